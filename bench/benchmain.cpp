@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <ctime>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "cuxinterface.h"
+#include "samplesettings.h"
+#include "fakeecu.h"
+
+/**
+ * Drives CUXInterface against the simulated link for a fixed time, the same
+ * way the GUI and headless logger do, and prints what it achieved: the rate
+ * of each reading, the time taken to deliver each frame to the consumer, and
+ * the CPU time used.
+ */
+int main(int argc, char* argv[])
+{
+  QCoreApplication a(argc, argv);
+  a.setApplicationName("rovergauge_bench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Measures the RoverGauge polling loop against a simulated 14CUX serial link");
+
+  const QCommandLineOption baudOption
+    ({"b", "baud"}, "Link speed: 7812 (standard) or 15625 (doubled firmware).", "baud", "7812");
+  const QCommandLineOption scriptOption
+    ({"s", "script"}, "Driving pattern: idle, transient, or drive.", "script", "transient");
+  const QCommandLineOption durationOption
+    ({"t", "time"}, "Length of the run in seconds.", "secs", "10");
+  const QCommandLineOption readingsOption
+    ({"r", "readings"}, "Comma-separated list of readings to enable (default: all).", "list");
+  const QCommandLineOption adaptiveOption
+    ({"a", "adaptive"}, "Use adaptive read rates.");
+  const QCommandLineOption noBatchOption
+    ("no-batch", "Read every value with its own call instead of batching RAM reads.");
+  const QCommandLineOption failureOption
+    ("failure-rate", "Fraction of reads that fail (0 to 1).", "fraction", "0");
+  const QCommandLineOption seedOption
+    ("seed", "Seed for the link's timing jitter and failures.", "n", "1");
+
+  parser.addHelpOption();
+  parser.addOption(baudOption);
+  parser.addOption(scriptOption);
+  parser.addOption(durationOption);
+  parser.addOption(readingsOption);
+  parser.addOption(adaptiveOption);
+  parser.addOption(noBatchOption);
+  parser.addOption(failureOption);
+  parser.addOption(seedOption);
+  parser.process(a);
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  FakeLinkModel model;
+  FakeScript script;
+  const bool doubleBaud = (parser.value(baudOption).toUInt() == 15625);
+  const int durationMs = (int)(parser.value(durationOption).toDouble() * 1000.0);
+
+  if (!FakeEcu::scriptFromName(parser.value(scriptOption), script))
+  {
+    err << "Unknown script: " << parser.value(scriptOption) << Qt::endl;
+    return 1;
+  }
+
+  model.baud = doubleBaud ? 15625.0 : 7812.5;
+  model.failureRate = parser.value(failureOption).toDouble();
+
+  // same reading selection and defaults as the headless logger
+  const QMap<SampleType, QString> enableNames = SampleSettings::enableSettingNames();
+  QMap<SampleType, bool> enabledSamples;
+  foreach (SampleType sType, enableNames.keys())
+  {
+    enabledSamples[sType] = !parser.isSet(readingsOption);
+  }
+  foreach (const QString& name, parser.value(readingsOption).split(',', Qt::SkipEmptyParts))
+  {
+    SampleType sType;
+    if (!SampleSettings::fromShortName(name, sType))
+    {
+      err << "Unknown reading: " << name << Qt::endl;
+      return 1;
+    }
+    enabledSamples[sType] = true;
+  }
+  SampleSettings::groupLikeSamples(enabledSamples);
+  enabledSamples[SampleType_MIL] = true;
+
+  // keep the fake ECU's ROM and fuel maps out of the user's real caches
+  QTemporaryDir settingsDir;
+  QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, settingsDir.path());
+
+  FakeEcu::instance().configure(model, script, parser.value(seedOption).toUInt());
+
+  CUXInterface* cux = new CUXInterface("fake", CUXInterface::getBaudRate(doubleBaud), MPH, Fahrenheit, false, false);
+  cux->setEnabledSamples(enabledSamples);
+  cux->setRateLimits(SampleSettings::defaultRateLimits());
+  cux->setReadIntervals(SampleSettings::defaultReadIntervals());
+  cux->setAdaptiveRates(parser.isSet(adaptiveOption));
+  cux->setBatchedReads(!parser.isSet(noBatchOption));
+
+  QThread thread;
+  cux->moveToThread(&thread);
+  QObject::connect(&thread, &QThread::started, cux, &CUXInterface::onParentThreadStarted);
+
+  QVector<qint64> deliveryMs;
+  unsigned long long frames = 0;
+  QElapsedTimer wall;
+  std::clock_t cpuStart = 0;
+  LinkStatisticsSnapshot stats;
+  double wallSecs = 0.0;
+  double cpuSecs = 0.0;
+
+  QObject::connect(cux, &CUXInterface::interfaceReadyForPolling, [cux]()
+  {
+    QMetaObject::invokeMethod(cux, "onStartPollingRequest", Qt::QueuedConnection);
+  });
+
+  QObject::connect(cux, &CUXInterface::connected, [&]()
+  {
+    wall.start();
+    cpuStart = std::clock();
+    QTimer::singleShot(durationMs, &a, [&]()
+    {
+      stats = cux->getLinkStatistics();
+      wallSecs = wall.nsecsElapsed() / 1e9;
+      cpuSecs = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+      a.quit();
+    });
+  });
+
+  QObject::connect(cux, &CUXInterface::dataReady, [&]()
+  {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    TelemetryFrame frame;
+
+    while (cux->takeFrame(frame))
+    {
+      deliveryMs.append(now - frame.timestampMs);
+      frames++;
+    }
+  });
+
+  thread.start();
+  a.exec();
+
+  QMetaObject::invokeMethod(cux, "onShutdownThreadRequest", Qt::QueuedConnection);
+  thread.wait(5000);
+  delete cux;
+
+  std::sort(deliveryMs.begin(), deliveryMs.end());
+  double deliveryTotal = 0.0;
+  foreach (qint64 ms, deliveryMs)
+  {
+    deliveryTotal += ms;
+  }
+
+  out << "script " << parser.value(scriptOption) << ", " << model.baud << " baud, "
+      << QString::number(wallSecs, 'f', 1) << " s, batching " << (parser.isSet(noBatchOption) ? "off" : "on")
+      << ", adaptive " << (parser.isSet(adaptiveOption) ? "on" : "off") << Qt::endl << Qt::endl;
+
+  out << QString("%1 %2 %3 %4 %5 %6").arg("reading", -20).arg("samples/s", 10).arg("mean ms", 9)
+         .arg("p95 ms", 9).arg("max ms", 9).arg("failures", 9) << Qt::endl;
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const ChannelStatistics& channel = stats.channels[type];
+    const unsigned int reads = channel.successes + channel.failures;
+
+    if (reads > 0)
+    {
+      out << QString("%1 %2 %3 %4 %5 %6")
+             .arg(SampleSettings::shortName((SampleType)type), -20)
+             .arg(channel.successes / std::max(wallSecs, 0.001), 10, 'f', 2)
+             .arg(channel.meanLatencyMs(), 9, 'f', 2)
+             .arg(channel.latencyPercentileMs(0.95f), 9, 'f', 2)
+             .arg(channel.maxLatencyMs, 9, 'f', 2)
+             .arg(channel.failures, 9) << Qt::endl;
+    }
+  }
+
+  out << Qt::endl;
+  out << "frames delivered: " << frames << " (" << QString::number(frames / std::max(wallSecs, 0.001), 'f', 1) << "/s)" << Qt::endl;
+  if (!deliveryMs.isEmpty())
+  {
+    out << "publish-to-consumer ms: mean " << QString::number(deliveryTotal / deliveryMs.size(), 'f', 2)
+        << ", p95 " << deliveryMs.at((int)(deliveryMs.size() * 0.95))
+        << ", max " << deliveryMs.last() << Qt::endl;
+  }
+  out << "loop passes: " << stats.passCount << " (mean " << QString::number(stats.meanPassMs(), 'f', 2)
+      << " ms, max " << QString::number(stats.maxPassMs, 'f', 2) << " ms)" << Qt::endl;
+  out << "link busy: " << QString::number(100.0 * FakeEcu::instance().busyUs() / 1e6 / std::max(wallSecs, 0.001), 'f', 1)
+      << "% (" << FakeEcu::instance().readCount() << " reads, " << FakeEcu::instance().failureCount() << " failed)" << Qt::endl;
+  out << "CPU time: " << QString::number(cpuSecs, 'f', 3) << " s ("
+      << QString::number(100.0 * cpuSecs / std::max(wallSecs, 0.001), 'f', 1) << "% of one core)" << Qt::endl;
+
+  return 0;
+}
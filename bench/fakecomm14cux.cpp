@@ -0,0 +1,281 @@
+// Replacements for the libcomm14cux functions used by CUXInterface. The
+// benchmark links against these instead of the real library, so that the
+// interface's scheduling can be measured against a simulated serial link
+// with realistic timing.
+
+#include <cstring>
+#include "comm14cux.h"
+#include "fakeecu.h"
+
+extern "C" {
+
+void c14cux_init(c14cux_info* info)
+{
+  (void)info;
+}
+
+bool c14cux_connect(c14cux_info* info, const char* devPath, unsigned int baud)
+{
+  (void)info;
+  (void)devPath;
+  (void)baud;
+  FakeEcu::instance().setConnected(true);
+  return true;
+}
+
+void c14cux_disconnect(c14cux_info* info)
+{
+  (void)info;
+  FakeEcu::instance().setConnected(false);
+}
+
+bool c14cux_isConnected(c14cux_info* info)
+{
+  (void)info;
+  return FakeEcu::instance().isConnected();
+}
+
+void c14cux_cancelRead(c14cux_info* info)
+{
+  (void)info;
+}
+
+bool c14cux_readMem(c14cux_info* info, uint16_t offset, uint16_t numBytes, uint8_t* buffer)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(numBytes);
+  if (ok)
+  {
+    FakeEcu::instance().readRam(offset, numBytes, buffer);
+  }
+  return ok;
+}
+
+bool c14cux_getEngineRPM(c14cux_info* info, uint16_t* rpm)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(2);
+  *rpm = FakeEcu::instance().engineRPM();
+  return ok;
+}
+
+bool c14cux_getRPMLimit(c14cux_info* info, uint16_t* rpmLimit)
+{
+  (void)info;
+  *rpmLimit = 5450;
+  return FakeEcu::instance().transfer(2);
+}
+
+bool c14cux_getThrottlePosition(c14cux_info* info, const enum c14cux_throttle_pos_type type, float* pos)
+{
+  (void)info;
+  // the corrected reading needs the minimum position as well
+  const bool ok = FakeEcu::instance().transfer(2) &&
+                  ((type == C14CUX_ThrottlePosType_Absolute) || FakeEcu::instance().transfer(2));
+  *pos = FakeEcu::instance().throttle();
+  return ok;
+}
+
+bool c14cux_getMAFReading(c14cux_info* info, const enum c14cux_airflow_type type, float* mafReading)
+{
+  (void)info;
+  (void)type;
+  const bool ok = FakeEcu::instance().transfer(2);
+  *mafReading = FakeEcu::instance().maf();
+  return ok;
+}
+
+bool c14cux_getLambdaTrimShort(c14cux_info* info, const enum c14cux_bank bank, int16_t* lambdaTrim)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(2);
+  *lambdaTrim = (bank == C14CUX_Bank_Odd) ? FakeEcu::instance().lambdaTrim() : -FakeEcu::instance().lambdaTrim();
+  return ok;
+}
+
+bool c14cux_getLambdaTrimLong(c14cux_info* info, const enum c14cux_bank bank, int16_t* lambdaTrim)
+{
+  (void)info;
+  (void)bank;
+  *lambdaTrim = 4;
+  return FakeEcu::instance().transfer(2);
+}
+
+bool c14cux_getFuelMapRowIndex(c14cux_info* info, uint8_t* fuelMapRowIndex, uint8_t* fuelMapRowWeighting)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(1);
+  *fuelMapRowIndex = FakeEcu::instance().fuelMapRow() >> 4;
+  *fuelMapRowWeighting = FakeEcu::instance().fuelMapRow() & 0x0F;
+  return ok;
+}
+
+bool c14cux_getFuelMapColumnIndex(c14cux_info* info, uint8_t* fuelMapColumnIndex, uint8_t* fuelMapColWeighting)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(1);
+  *fuelMapColumnIndex = FakeEcu::instance().fuelMapColumn() >> 4;
+  *fuelMapColWeighting = FakeEcu::instance().fuelMapColumn() & 0x0F;
+  return ok;
+}
+
+bool c14cux_getInjectorPulseWidth(c14cux_info* info, uint16_t* pulseWidth)
+{
+  (void)info;
+  const bool ok = FakeEcu::instance().transfer(2);
+  *pulseWidth = FakeEcu::instance().injectorPulseWidthUs();
+  return ok;
+}
+
+bool c14cux_getIdleBypassMotorPosition(c14cux_info* info, float* pos)
+{
+  (void)info;
+  *pos = 0.3f;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getMainVoltage(c14cux_info* info, float* mainVoltage)
+{
+  (void)info;
+  *mainVoltage = 13.8f;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getTargetIdle(c14cux_info* info, uint16_t* targetIdleRPM)
+{
+  (void)info;
+  *targetIdleRPM = 750;
+  return FakeEcu::instance().transfer(2);
+}
+
+bool c14cux_getIdleMode(c14cux_info* info, bool* idleMode)
+{
+  (void)info;
+  *idleMode = (FakeEcu::instance().throttle() < 0.1f);
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getFuelPumpRelayState(c14cux_info* info, bool* fuelPumpRelayOn)
+{
+  (void)info;
+  *fuelPumpRelayOn = true;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getGearSelection(c14cux_info* info, enum c14cux_gear* gear)
+{
+  (void)info;
+  *gear = C14CUX_Gear_ManualGearbox;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getRoadSpeed(c14cux_info* info, uint8_t* roadSpeed)
+{
+  (void)info;
+  *roadSpeed = FakeEcu::instance().roadSpeedMPH();
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getCoolantTemp(c14cux_info* info, int16_t* coolantTemp)
+{
+  (void)info;
+  *coolantTemp = FakeEcu::instance().coolantTempF();
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getFuelTemp(c14cux_info* info, int16_t* fuelTemp)
+{
+  (void)info;
+  *fuelTemp = 85;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_isMILOn(c14cux_info* info, bool* milOn)
+{
+  (void)info;
+  *milOn = false;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getCurrentFuelMap(c14cux_info* info, uint8_t* fuelMapId)
+{
+  (void)info;
+  *fuelMapId = 5;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getCOTrimVoltage(c14cux_info* info, float* coTrimVoltage)
+{
+  (void)info;
+  *coTrimVoltage = 2.5f;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_getFuelMap(c14cux_info* info, const int8_t fuelMapId, uint16_t* adjustmentFactor,
+                       uint8_t* rowScaler, uint8_t* buffer)
+{
+  (void)info;
+  for (int idx = 0; idx < 128; idx++)
+  {
+    buffer[idx] = (uint8_t)(0x40 + (fuelMapId * 8) + (idx / 8));
+  }
+  *adjustmentFactor = 0x4000;
+  *rowScaler = 0x10;
+  return FakeEcu::instance().transfer(128 + 3);
+}
+
+bool c14cux_getRpmTable(c14cux_info* info, c14cux_rpmtable* rpmTable)
+{
+  (void)info;
+  const int count = sizeof(rpmTable->rpm) / sizeof(rpmTable->rpm[0]);
+  for (int idx = 0; idx < count; idx++)
+  {
+    rpmTable->rpm[idx] = (uint16_t)(500 + idx * 500);
+  }
+  return FakeEcu::instance().transfer(count * 2);
+}
+
+bool c14cux_getTuneRevision(c14cux_info* info, uint16_t* tuneRevision, uint8_t* checksumFixer, uint16_t* tuneIdent)
+{
+  (void)info;
+  *tuneRevision = 0x3360;
+  *checksumFixer = 0xFF;
+  *tuneIdent = 0;
+  return FakeEcu::instance().transfer(5);
+}
+
+bool c14cux_getFaultCodes(c14cux_info* info, c14cux_faultcodes* faultCodes)
+{
+  (void)info;
+  memset(faultCodes, 0, sizeof(c14cux_faultcodes));
+  return FakeEcu::instance().transfer(sizeof(c14cux_faultcodes));
+}
+
+bool c14cux_clearFaultCodes(c14cux_info* info)
+{
+  (void)info;
+  return FakeEcu::instance().transfer(sizeof(c14cux_faultcodes));
+}
+
+bool c14cux_dumpROM(c14cux_info* info, uint8_t* buffer)
+{
+  (void)info;
+  memset(buffer, 0xFF, 16384);
+  return FakeEcu::instance().transfer(16384);
+}
+
+bool c14cux_runFuelPump(c14cux_info* info)
+{
+  (void)info;
+  return FakeEcu::instance().transfer(1);
+}
+
+bool c14cux_driveIdleAirControlMotor(c14cux_info* info, uint8_t direction, uint8_t magnitude)
+{
+  (void)info;
+  (void)direction;
+  (void)magnitude;
+  return FakeEcu::instance().transfer(2);
+}
+
+}
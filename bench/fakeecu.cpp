@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include "comm14cux.h"
+#include "fakeecu.h"
+
+namespace
+{
+const double s_pi = 3.14159265358979;
+
+/**
+ * Stores a 16-bit value in the 14CUX's (big-endian) byte order.
+ */
+void putWord(uint8_t* ram, uint16_t address, uint16_t value)
+{
+  ram[address] = (uint8_t)(value >> 8);
+  ram[(uint16_t)(address + 1)] = (uint8_t)(value & 0xFF);
+}
+}
+
+/**
+ * Returns the single simulated ECU used by the fake library functions.
+ */
+FakeEcu& FakeEcu::instance()
+{
+  static FakeEcu ecu;
+  return ecu;
+}
+
+/**
+ * Looks up a driving script by name ("idle", "transient", or "drive").
+ */
+bool FakeEcu::scriptFromName(const QString& name, FakeScript& script)
+{
+  bool found = true;
+
+  if (name == "idle")
+  {
+    script = FakeScript_Idle;
+  }
+  else if (name == "transient")
+  {
+    script = FakeScript_Transient;
+  }
+  else if (name == "drive")
+  {
+    script = FakeScript_Drive;
+  }
+  else
+  {
+    found = false;
+  }
+
+  return found;
+}
+
+/**
+ * Sets up the link model and driving script, and restarts the script's clock.
+ */
+void FakeEcu::configure(const FakeLinkModel& model, FakeScript script, uint32_t seed)
+{
+  m_model = model;
+  m_script = script;
+  m_rng.seed(seed);
+  m_reads = 0;
+  m_failures = 0;
+  m_busyUs = 0.0;
+  m_clock.start();
+}
+
+void FakeEcu::setConnected(bool connected)
+{
+  m_connected = connected;
+}
+
+bool FakeEcu::isConnected() const
+{
+  return m_connected;
+}
+
+/**
+ * Blocks for the time that one read of the given size would occupy the link.
+ * @param dataBytes Number of data bytes returned by the ECU
+ * @return False if the read was chosen to fail
+ */
+bool FakeEcu::transfer(unsigned int dataBytes)
+{
+  std::uniform_real_distribution<double> jitter(0.0, m_model.jitterUs);
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+  const bool fail = (m_model.failureRate > 0.0) && (chance(m_rng) < m_model.failureRate);
+
+  // A failed read typically times out partway through the response.
+  const unsigned int bytes = (m_model.commandBytes * 2) + (fail ? (dataBytes / 2) : dataBytes);
+  const double us = (bytes * m_model.byteTimeUs()) + m_model.turnaroundUs + jitter(m_rng);
+
+  std::this_thread::sleep_for(std::chrono::microseconds((long long)us));
+
+  m_reads++;
+  m_busyUs += us;
+  if (fail)
+  {
+    m_failures++;
+  }
+
+  return !fail;
+}
+
+/**
+ * Copies a range of the simulated ECU's memory. Only the locations that the
+ * interface decodes directly are populated; the rest read as zero.
+ */
+void FakeEcu::readRam(uint16_t address, uint16_t length, uint8_t* buffer)
+{
+  static uint8_t ram[65536];
+
+  putWord(ram, C14CUX_EngineSpeedFilteredOffset, (engineRPM() > 0) ? (uint16_t)(7500000 / engineRPM()) : 0xFFFF);
+  putWord(ram, C14CUX_ThrottlePositionOffset, (uint16_t)(throttle() * 1023.0f));
+  putWord(ram, C14CUX_MassAirflowDirectOffset, (uint16_t)(maf() * 1023.0f));
+  ram[C14CUX_FuelMapRowIndexOffset] = fuelMapRow();
+  ram[C14CUX_FuelMapColumnIndexOffset] = fuelMapColumn();
+
+  for (unsigned int idx = 0; idx < length; idx++)
+  {
+    buffer[idx] = ram[(uint16_t)(address + idx)];
+  }
+}
+
+/**
+ * Returns the time since the script was started.
+ */
+double FakeEcu::seconds() const
+{
+  return m_clock.isValid() ? (m_clock.nsecsElapsed() / 1e9) : 0.0;
+}
+
+/**
+ * Returns the throttle opening (0 to 1) called for by the script.
+ */
+float FakeEcu::throttle() const
+{
+  const double t = seconds();
+  double pos = 0.08;
+
+  if (m_script == FakeScript_Transient)
+  {
+    // a one-second blip every four seconds
+    const double phase = std::fmod(t, 4.0);
+    if (phase < 0.3)
+    {
+      pos = 0.08 + (0.72 * phase / 0.3);
+    }
+    else if (phase < 0.7)
+    {
+      pos = 0.8;
+    }
+    else if (phase < 1.0)
+    {
+      pos = 0.8 - (0.72 * (phase - 0.7) / 0.3);
+    }
+  }
+  else if (m_script == FakeScript_Drive)
+  {
+    pos = 0.25 + 0.15 * std::sin(2.0 * s_pi * t / 20.0);
+  }
+
+  return (float)pos;
+}
+
+uint16_t FakeEcu::engineRPM() const
+{
+  const double t = seconds();
+  double rpm = 750.0 + 10.0 * std::sin(2.0 * s_pi * t);
+
+  if (m_script == FakeScript_Transient)
+  {
+    rpm += (throttle() - 0.08f) * 5000.0;
+  }
+  else if (m_script == FakeScript_Drive)
+  {
+    rpm = 2000.0 + 1200.0 * std::sin(2.0 * s_pi * t / 20.0);
+  }
+
+  return (uint16_t)rpm;
+}
+
+float FakeEcu::maf() const
+{
+  return std::min(0.05f + throttle() * 0.9f, 1.0f);
+}
+
+uint8_t FakeEcu::roadSpeedMPH() const
+{
+  return (m_script == FakeScript_Drive) ? (uint8_t)(40.0 + 20.0 * std::sin(2.0 * s_pi * seconds() / 20.0)) : 0;
+}
+
+/**
+ * Returns the coolant temperature, which warms from cold over the first two
+ * minutes of the drive script and is otherwise steady.
+ */
+int16_t FakeEcu::coolantTempF() const
+{
+  return (m_script == FakeScript_Drive) ? (int16_t)std::min(60.0 + seconds(), 190.0) : 190;
+}
+
+int16_t FakeEcu::lambdaTrim() const
+{
+  return (int16_t)(20.0 * std::sin(2.0 * s_pi * seconds() / 1.5));
+}
+
+/**
+ * Returns the fuel map row register (index in the upper nibble, weighting in
+ * the lower), which follows the engine speed.
+ */
+uint8_t FakeEcu::fuelMapRow() const
+{
+  const unsigned int scaled = std::min<unsigned int>(engineRPM() * 16 / 700, 0x7F);
+  return (uint8_t)(((scaled / 16) << 4) | (scaled % 16));
+}
+
+/**
+ * Returns the fuel map column register, which follows the airflow.
+ */
+uint8_t FakeEcu::fuelMapColumn() const
+{
+  const unsigned int scaled = std::min<unsigned int>((unsigned int)(maf() * 255.0f), 0xFF);
+  return (uint8_t)(((scaled / 16) << 4) | (scaled % 16));
+}
+
+uint16_t FakeEcu::injectorPulseWidthUs() const
+{
+  return (uint16_t)(1800.0f + maf() * 9000.0f);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <random>
+#include <stdint.h>
+#include <QElapsedTimer>
+#include <QString>
+
+/**
+ * Timing parameters for the simulated serial link. Every byte is framed as
+ * 8N1 (ten bits on the wire), and each read consists of a command whose bytes
+ * are echoed back by the ECU, followed by the requested data.
+ */
+struct FakeLinkModel
+{
+  double baud = 7812.5;
+  int commandBytes = 3;
+  double turnaroundUs = 500.0;
+  double jitterUs = 200.0;
+  double failureRate = 0.0;
+
+  double byteTimeUs() const
+  {
+    return 10.0 * 1000000.0 / baud;
+  }
+};
+
+/**
+ * Driving pattern that determines the values reported by the simulated ECU.
+ */
+enum FakeScript
+{
+  FakeScript_Idle,
+  FakeScript_Transient,
+  FakeScript_Drive
+};
+
+/**
+ * A deterministic stand-in for a 14CUX on the other end of a serial link.
+ * Each read blocks for as long as the real link would take to carry it, and
+ * the reported values follow a scripted driving pattern over time. Random
+ * jitter and read failures come from a seeded generator, so a run can be
+ * repeated exactly.
+ */
+class FakeEcu
+{
+public:
+  static FakeEcu& instance();
+  static bool scriptFromName(const QString& name, FakeScript& script);
+
+  void configure(const FakeLinkModel& model, FakeScript script, uint32_t seed);
+  void setConnected(bool connected);
+  bool isConnected() const;
+
+  bool transfer(unsigned int dataBytes);
+  void readRam(uint16_t address, uint16_t length, uint8_t* buffer);
+
+  uint16_t engineRPM() const;
+  float throttle() const;
+  float maf() const;
+  uint8_t roadSpeedMPH() const;
+  int16_t coolantTempF() const;
+  int16_t lambdaTrim() const;
+  uint8_t fuelMapRow() const;
+  uint8_t fuelMapColumn() const;
+  uint16_t injectorPulseWidthUs() const;
+
+  unsigned long long readCount() const
+  {
+    return m_reads;
+  }
+
+  unsigned long long failureCount() const
+  {
+    return m_failures;
+  }
+
+  double busyUs() const
+  {
+    return m_busyUs;
+  }
+
+private:
+  FakeLinkModel m_model;
+  FakeScript m_script = FakeScript_Transient;
+  std::mt19937 m_rng;
+  QElapsedTimer m_clock;
+  bool m_connected = false;
+  unsigned long long m_reads = 0;
+  unsigned long long m_failures = 0;
+  double m_busyUs = 0.0;
+
+  double seconds() const;
+};
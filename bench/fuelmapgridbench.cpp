@@ -0,0 +1,237 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QPaintEvent>
+#include <QRandomGenerator>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QVector>
+#include "fuelmapgrid.h"
+
+/**
+ * The fuel map display as it was before FuelMapGrid painted itself: a table
+ * of 128 items, with the highlight moved by changing the items' colors.
+ */
+class TableFuelMapGrid : public QTableWidget
+{
+public:
+  TableFuelMapGrid() :
+    QTableWidget(FUEL_MAP_ROWS, FUEL_MAP_COLUMNS)
+  {
+    horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    verticalHeader()->setVisible(false);
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+      {
+        QTableWidgetItem* cell = new QTableWidgetItem();
+        cell->setTextAlignment(Qt::AlignCenter);
+        cell->setFlags(Qt::NoItemFlags);
+        setItem(row, col, cell);
+      }
+    }
+  }
+
+  void setData(const QByteArray& data)
+  {
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+      {
+        const unsigned char byte = data.at(row * FUEL_MAP_COLUMNS + col);
+        m_colors[row][col] = QColor::fromRgb(255, (byte / 2 * -1) + 255, 255.0 - byte);
+        item(row, col)->setText(QString("%1").arg(byte, 2, 16, QChar('0')).toUpper());
+        item(row, col)->setBackground(m_colors[row][col]);
+      }
+    }
+  }
+
+  void moveCellHighlight(int row, int rowWeight, int col, int colWeight)
+  {
+    const float leftPercent = 1.0 - (colWeight / 15.0);
+    const float topPercent = 1.0 - (rowWeight / 15.0);
+    const float shade[NUM_ACTIVE_FUEL_MAP_CELLS] = { 1.0f - (leftPercent * topPercent),
+                                                     1.0f - ((1.0f - leftPercent) * topPercent),
+                                                     1.0f - (leftPercent * (1.0f - topPercent)),
+                                                     1.0f - ((1.0f - leftPercent) * (1.0f - topPercent)) };
+
+    for (int idx = 0; idx < m_lastCount; idx++)
+    {
+      QTableWidgetItem* cell = item(m_last[idx].first, m_last[idx].second);
+      if (cell)
+      {
+        cell->setBackground(m_colors[m_last[idx].first][m_last[idx].second]);
+        cell->setForeground(Qt::black);
+      }
+    }
+
+    m_lastCount = 0;
+    for (int idx = 0; idx < NUM_ACTIVE_FUEL_MAP_CELLS; idx++)
+    {
+      const int r = row + (idx / 2);
+      const int c = col + (idx % 2);
+      QTableWidgetItem* cell = item(r, c);
+      if (cell)
+      {
+        const QColor& base = m_colors[r][c];
+        QColor shaded;
+        shaded.setRgb(base.red() * shade[idx], base.green() * shade[idx], base.blue() * shade[idx]);
+        cell->setBackground(shaded);
+        cell->setForeground((shaded.value() > 128) ? Qt::black : Qt::white);
+        m_last[m_lastCount++] = qMakePair(r, c);
+      }
+    }
+  }
+
+private:
+  QColor m_colors[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS];
+  QPair<int, int> m_last[NUM_ACTIVE_FUEL_MAP_CELLS];
+  int m_lastCount = 0;
+};
+
+/**
+ * A position in the fuel map, as reported by the ECU.
+ */
+struct MapPosition
+{
+  int row;
+  int rowWeight;
+  int col;
+  int colWeight;
+};
+
+/**
+ * Builds a path through the fuel map that wanders the way the engine's
+ * operating point does: mostly small steps, with an occasional jump.
+ */
+static QVector<MapPosition> makePath(int count, quint32 seed)
+{
+  QRandomGenerator rng(seed);
+  QVector<MapPosition> path(count);
+  int rowPos = 3 * 16;
+  int colPos = 4 * 16;
+
+  for (MapPosition& pos : path)
+  {
+    if (rng.bounded(50) == 0)
+    {
+      rowPos = rng.bounded((FUEL_MAP_ROWS - 1) * 16);
+      colPos = rng.bounded((FUEL_MAP_COLUMNS - 1) * 16);
+    }
+    else
+    {
+      rowPos = qBound(0, rowPos + rng.bounded(-3, 4), (FUEL_MAP_ROWS - 1) * 16 - 1);
+      colPos = qBound(0, colPos + rng.bounded(-3, 4), (FUEL_MAP_COLUMNS - 1) * 16 - 1);
+    }
+    pos = { rowPos / 16, rowPos % 16, colPos / 16, colPos % 16 };
+  }
+
+  return path;
+}
+
+/**
+ * Moves the highlight along the path, letting the widget repaint after each
+ * move, and returns the mean time per move in microseconds.
+ */
+template <typename Mover>
+static double timeMoves(QWidget& widget, const QVector<MapPosition>& path, Mover move)
+{
+  QElapsedTimer timer;
+
+  // settle any pending layout and the first full paint before timing
+  QApplication::processEvents();
+  widget.repaint();
+
+  timer.start();
+  foreach (const MapPosition& pos, path)
+  {
+    move(pos);
+    QApplication::processEvents();
+  }
+
+  return (timer.nsecsElapsed() / 1000.0) / qMax(path.size(), 1);
+}
+
+/**
+ * Compares the cost of moving the fuel map highlight in the table-based
+ * display against the painted FuelMapGrid, including the repaint that each
+ * move causes.
+ */
+int main(int argc, char* argv[])
+{
+  // an on-screen window isn't needed to measure painting
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+
+  QApplication a(argc, argv);
+  a.setApplicationName("rovergauge_gridbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Measures the cost of moving the fuel map cell highlight");
+
+  const QCommandLineOption movesOption
+    ({"n", "moves"}, "Number of highlight moves to time.", "moves", "20000");
+  const QCommandLineOption seedOption
+    ("seed", "Seed for the path through the map.", "n", "1");
+
+  parser.addHelpOption();
+  parser.addOption(movesOption);
+  parser.addOption(seedOption);
+  parser.process(a);
+
+  QTextStream out(stdout);
+  const QVector<MapPosition> path = makePath(qMax(1, parser.value(movesOption).toInt()),
+                                             parser.value(seedOption).toUInt());
+  QByteArray map(FUEL_MAP_ROWS * FUEL_MAP_COLUMNS, 0);
+  QFont font("Andale Mono", 9);
+
+  for (int idx = 0; idx < map.size(); idx++)
+  {
+    map[idx] = (char)(0x20 + ((idx % FUEL_MAP_COLUMNS) * 6) + ((idx / FUEL_MAP_COLUMNS) * 9));
+  }
+
+  TableFuelMapGrid table;
+  table.setFont(font);
+  table.resize(640, 260);
+  table.setData(map);
+  table.show();
+  const double tableUs = timeMoves(table, path, [&](const MapPosition& pos)
+  {
+    table.moveCellHighlight(pos.row, pos.rowWeight, pos.col, pos.colWeight);
+  });
+  table.hide();
+
+  FuelMapGrid grid;
+  grid.setFont(font);
+  grid.resize(640, 260);
+  grid.setup(16);
+  grid.setData(map);
+  grid.show();
+  const double gridUs = timeMoves(grid, path, [&](const MapPosition& pos)
+  {
+    grid.moveCellHighlight(pos.row, pos.rowWeight, pos.col, pos.colWeight, true);
+  });
+
+  // for scale: repainting the whole grid from the cache
+  QElapsedTimer timer;
+  const int fullRepaints = qMin(path.size(), 2000);
+  timer.start();
+  for (int idx = 0; idx < fullRepaints; idx++)
+  {
+    grid.repaint();
+  }
+  const double fullUs = (timer.nsecsElapsed() / 1000.0) / fullRepaints;
+
+  out << path.size() << " highlight moves (soft highlight), 640x260:" << Qt::endl;
+  out << QString("  QTableWidget items    %1 us/move").arg(tableUs, 9, 'f', 1) << Qt::endl;
+  out << QString("  FuelMapGrid           %1 us/move (%2x)").arg(gridUs, 9, 'f', 1)
+                                                             .arg(tableUs / qMax(gridUs, 0.001), 0, 'f', 1) << Qt::endl;
+  out << QString("  FuelMapGrid, full     %1 us/repaint").arg(fullUs, 9, 'f', 1) << Qt::endl;
+
+  return 0;
+}
@@ -0,0 +1,233 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include "textlogformatter.h"
+
+/**
+ * Formats rows the way the text logger did before TextLogFormatter: through a
+ * QTextStream, with the timestamp built as a QString for every row.
+ */
+class StreamRowFormatter
+{
+public:
+  explicit StreamRowFormatter(const LogSettings& settings) :
+    m_settings(settings)
+  {
+  }
+
+  void appendFrame(QTextStream& out, const TelemetryFrame& frame)
+  {
+    double roadSpeed = frame.roadSpeed;
+
+    if (m_settings.speedoAdjust)
+    {
+      roadSpeed *= m_settings.speedoMultiplier;
+      roadSpeed += m_settings.speedoOffset;
+    }
+
+    if (!m_firstTimestampSet)
+    {
+      m_firstTimestampMs = frame.timestampMs;
+      m_firstTimestampSet = true;
+    }
+
+    const QString timestamp = m_settings.timesMsecsFromZero ?
+      QString::number(frame.timestampMs - m_firstTimestampMs) :
+      QDateTime::fromMSecsSinceEpoch(frame.timestampMs).toString("yyyy-MM-dd_hh:mm:ss.zzz");
+
+    out << timestamp << ","
+        << roadSpeed << ","
+        << frame.engineSpeedRPM << ","
+        << frame.coolantTemp << ","
+        << frame.fuelTemp << ","
+        << frame.throttlePos << ","
+        << frame.mafReading << ","
+        << frame.idleBypassPos << ","
+        << frame.mainVoltage << ","
+        << frame.currentFuelMapIndex << ","
+        << ((float)frame.fuelMapRowIndex + ((float)frame.fuelMapRowWeighting / 16.0)) << ","
+        << ((float)frame.fuelMapColumnIndex + ((float)frame.fuelMapColumnWeighting / 16.0)) << ","
+        << frame.targetIdleSpeed << ","
+        << frame.lambdaTrimOdd << ","
+        << frame.lambdaTrimEven << ","
+        << frame.injectorPulseWidthMs
+        << '\n';
+  }
+
+private:
+  LogSettings m_settings;
+  qint64 m_firstTimestampMs = 0;
+  bool m_firstTimestampSet = false;
+};
+
+/**
+ * Builds frames with readings spread over (and a little beyond) the ranges
+ * the ECU produces, at roughly the rate a fast poll delivers them.
+ */
+static QVector<TelemetryFrame> makeFrames(int count, quint32 seed)
+{
+  QRandomGenerator rng(seed);
+  QVector<TelemetryFrame> frames(count);
+  qint64 timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+  for (TelemetryFrame& frame : frames)
+  {
+    timestampMs += rng.bounded(5, 60);
+    frame.timestampMs = timestampMs;
+    frame.roadSpeed = rng.bounded(160);
+    frame.engineSpeedRPM = rng.bounded(7000);
+    frame.targetIdleSpeed = rng.bounded(2) ? rng.bounded(600, 1100) : 0;
+    frame.coolantTemp = rng.bounded(-40, 260);
+    frame.fuelTemp = rng.bounded(-40, 200);
+    frame.throttlePos = (float)rng.bounded(1024) / 1023.0f;
+    frame.mafReading = (float)rng.bounded(1024) / 1023.0f;
+    frame.idleBypassPos = (float)rng.bounded(181) / 180.0f;
+    frame.mainVoltage = (float)rng.bounded(256) * 0.07f;
+    frame.injectorPulseWidthMs = (float)rng.bounded(65536) / 1000.0f;
+    frame.lambdaTrimOdd = rng.bounded(-256, 256);
+    frame.lambdaTrimEven = rng.bounded(-256, 256);
+    frame.currentFuelMapIndex = rng.bounded(6);
+    frame.fuelMapRowIndex = rng.bounded(8);
+    frame.fuelMapRowWeighting = rng.bounded(16);
+    frame.fuelMapColumnIndex = rng.bounded(16);
+    frame.fuelMapColumnWeighting = rng.bounded(16);
+
+    // an occasional value large or small enough to be written in exponent form
+    if (rng.bounded(1000) == 0)
+    {
+      frame.injectorPulseWidthMs = (rng.bounded(2) ? 1234567.0f : 0.00001234f);
+    }
+  }
+
+  return frames;
+}
+
+/**
+ * Compares the two formatters for identical output, then times each of them
+ * formatting the same frames into an in-memory buffer.
+ */
+int main(int argc, char* argv[])
+{
+  QCoreApplication a(argc, argv);
+  a.setApplicationName("rovergauge_logbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Measures the rate at which text log rows are formatted");
+
+  const QCommandLineOption rowsOption
+    ({"n", "rows"}, "Number of rows to format in each pass.", "rows", "200000");
+  const QCommandLineOption passesOption
+    ({"p", "passes"}, "Number of timed passes; the best is reported.", "passes", "5");
+  const QCommandLineOption seedOption
+    ("seed", "Seed for the generated readings.", "n", "1");
+
+  parser.addHelpOption();
+  parser.addOption(rowsOption);
+  parser.addOption(passesOption);
+  parser.addOption(seedOption);
+  parser.process(a);
+
+  QTextStream out(stdout);
+  const int rowCount = qMax(1, parser.value(rowsOption).toInt());
+  const int passes = qMax(1, parser.value(passesOption).toInt());
+  const QVector<TelemetryFrame> frames = makeFrames(rowCount, parser.value(seedOption).toUInt());
+  int status = 0;
+
+  for (int mode = 0; mode < 2; mode++)
+  {
+    LogSettings settings;
+    settings.timesMsecsFromZero = (mode == 1);
+    settings.speedoAdjust = true;
+    settings.speedoMultiplier = 1.037;
+    settings.speedoOffset = 1;
+
+    // check that the output is unchanged
+    QByteArray expected;
+    QByteArray actual;
+    {
+      StreamRowFormatter reference(settings);
+      QTextStream stream(&expected, QIODevice::WriteOnly);
+      foreach (const TelemetryFrame& frame, frames)
+      {
+        reference.appendFrame(stream, frame);
+      }
+    }
+    TextLogFormatter formatter;
+    formatter.setSettings(settings);
+    actual.reserve(expected.size());
+    foreach (const TelemetryFrame& frame, frames)
+    {
+      formatter.appendFrame(actual, frame);
+    }
+
+    const bool identical = (actual == expected);
+    if (!identical)
+    {
+      const QList<QByteArray> expectedRows = expected.split('\n');
+      const QList<QByteArray> actualRows = actual.split('\n');
+      for (int row = 0; row < qMin(expectedRows.size(), actualRows.size()); row++)
+      {
+        if (expectedRows.at(row) != actualRows.at(row))
+        {
+          out << "row " << row << " differs:" << Qt::endl
+              << "  expected " << expectedRows.at(row) << Qt::endl
+              << "  actual   " << actualRows.at(row) << Qt::endl;
+          break;
+        }
+      }
+      status = 1;
+    }
+
+    // time both, keeping the best pass of each
+    qint64 bestStreamNs = 0;
+    qint64 bestFormatterNs = 0;
+    QByteArray buffer;
+    buffer.reserve(expected.size());
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+      QElapsedTimer timer;
+
+      buffer.resize(0);
+      StreamRowFormatter reference(settings);
+      timer.start();
+      {
+        QTextStream stream(&buffer, QIODevice::WriteOnly);
+        foreach (const TelemetryFrame& frame, frames)
+        {
+          reference.appendFrame(stream, frame);
+        }
+      }
+      const qint64 streamNs = timer.nsecsElapsed();
+
+      buffer.resize(0);
+      TextLogFormatter timedFormatter;
+      timedFormatter.setSettings(settings);
+      timer.restart();
+      foreach (const TelemetryFrame& frame, frames)
+      {
+        timedFormatter.appendFrame(buffer, frame);
+      }
+      const qint64 formatterNs = timer.nsecsElapsed();
+
+      bestStreamNs = (pass == 0) ? streamNs : qMin(bestStreamNs, streamNs);
+      bestFormatterNs = (pass == 0) ? formatterNs : qMin(bestFormatterNs, formatterNs);
+    }
+
+    const double streamRate = rowCount / (qMax(bestStreamNs, (qint64)1) / 1e9);
+    const double formatterRate = rowCount / (qMax(bestFormatterNs, (qint64)1) / 1e9);
+
+    out << (settings.timesMsecsFromZero ? "msecs-from-zero timestamps" : "date/time timestamps") << ", "
+        << rowCount << " rows: output " << (identical ? "identical" : "DIFFERS") << Qt::endl;
+    out << QString("  QTextStream       %1 rows/s").arg(streamRate, 12, 'f', 0) << Qt::endl;
+    out << QString("  TextLogFormatter  %1 rows/s (%2x)")
+           .arg(formatterRate, 12, 'f', 0).arg(formatterRate / streamRate, 0, 'f', 1) << Qt::endl;
+  }
+
+  return status;
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cmath>
+#include <QMutexLocker>
+#include "adaptiverate.h"
+
+/**
+ * Turns adaptive scheduling on or off.
+ */
+void AdaptiveRateController::setEnabled(bool enabled)
+{
+  QMutexLocker locker(&m_lock);
+  m_enabled = enabled;
+  m_lastUpdateMs = 0;
+
+  // make sure that every interval is reported on the next update
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    m_channels[type].intervalMs = 0;
+  }
+}
+
+/**
+ * Returns true if adaptive scheduling is enabled.
+ */
+bool AdaptiveRateController::isEnabled() const
+{
+  QMutexLocker locker(&m_lock);
+  return m_enabled;
+}
+
+/**
+ * Sets the floor and ceiling rates for the sample types that may be scheduled
+ * adaptively. Sample types without limits keep their fixed intervals.
+ */
+void AdaptiveRateController::setLimits(const QHash<SampleType, SampleRateLimits>& limits)
+{
+  QMutexLocker locker(&m_lock);
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    ChannelState& channel = m_channels[type];
+    channel.adaptive = limits.contains((SampleType)type);
+    if (channel.adaptive)
+    {
+      channel.limits = limits.value((SampleType)type);
+      channel.limits.floorHz = std::max(channel.limits.floorHz, 0.01f);
+      channel.limits.ceilingHz = std::max(channel.limits.ceilingHz, channel.limits.floorHz);
+    }
+  }
+}
+
+/**
+ * Forgets the history of every sample type. Called when (re)connecting.
+ */
+void AdaptiveRateController::reset()
+{
+  QMutexLocker locker(&m_lock);
+
+  m_lastUpdateMs = 0;
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    ChannelState& channel = m_channels[type];
+    channel.haveValue = false;
+    channel.activity = 0.0f;
+    channel.costMs = 0.0f;
+    channel.achievedIntervalMs = 0.0f;
+    channel.intervalMs = 0;
+  }
+}
+
+/**
+ * Records a completed read.
+ * @param type Sample type that was read
+ * @param value New value, as a fraction of the reading's full scale
+ * @param costMs Time spent on the link for this read
+ * @param nowMs Current time on the scheduler's monotonic clock
+ */
+void AdaptiveRateController::recordSample(SampleType type, float value, float costMs, qint64 nowMs)
+{
+  QMutexLocker locker(&m_lock);
+  ChannelState& channel = m_channels[type];
+
+  if (channel.haveValue && (nowMs > channel.lastServiceMs))
+  {
+    const float elapsedMs = (float)(nowMs - channel.lastServiceMs);
+    const float changePerSec = std::fabs(value - channel.lastValue) * 1000.0f / elapsedMs;
+
+    // React quickly when a reading starts moving, but relax slowly so that a
+    // brief pause in a transient doesn't drop the rate right away.
+    const float alpha = (changePerSec > channel.activity) ? 0.5f : 0.1f;
+    channel.activity += alpha * (changePerSec - channel.activity);
+
+    channel.achievedIntervalMs = (channel.achievedIntervalMs == 0.0f) ? elapsedMs :
+      channel.achievedIntervalMs + 0.1f * (elapsedMs - channel.achievedIntervalMs);
+  }
+
+  channel.costMs = (channel.costMs == 0.0f) ? costMs : channel.costMs + 0.2f * (costMs - channel.costMs);
+  channel.lastValue = value;
+  channel.lastServiceMs = nowMs;
+  channel.haveValue = true;
+}
+
+/**
+ * Recomputes the intervals for the adaptively-scheduled sample types, at most
+ * once per update period.
+ * @param nowMs Current time on the scheduler's monotonic clock
+ * @param intervals Receives the sample types whose intervals have changed
+ * @return True if any interval changed
+ */
+bool AdaptiveRateController::updateIntervals(qint64 nowMs, QHash<SampleType, unsigned int>& intervals)
+{
+  QMutexLocker locker(&m_lock);
+  float rates[SampleType_NumSampleTypes];
+  float load = 0.0f;
+
+  intervals.clear();
+  if (!m_enabled || ((nowMs - m_lastUpdateMs) < s_updatePeriodMs))
+  {
+    return false;
+  }
+  m_lastUpdateMs = nowMs;
+
+  // the rate at which each reading changes by about one target step
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const ChannelState& channel = m_channels[type];
+    rates[type] = 0.0f;
+
+    if (channel.adaptive && channel.haveValue)
+    {
+      rates[type] = std::min(std::max(channel.activity / s_targetStep, channel.limits.floorHz),
+                             channel.limits.ceilingHz);
+      load += rates[type] * channel.costMs / 1000.0f;
+    }
+  }
+
+  // If that asks for more link time than there is, scale back the rates that
+  // are above their floors. Rates that reach their floors are fixed there and
+  // the remainder is shared out again, which converges in a few rounds.
+  for (int round = 0; (round < 3) && (load > s_maxLinkLoad); round++)
+  {
+    float fixedLoad = 0.0f;
+    float scalableLoad = 0.0f;
+
+    for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+    {
+      const ChannelState& channel = m_channels[type];
+      const float typeLoad = rates[type] * channel.costMs / 1000.0f;
+
+      if (rates[type] > channel.limits.floorHz)
+      {
+        scalableLoad += typeLoad;
+      }
+      else
+      {
+        fixedLoad += typeLoad;
+      }
+    }
+
+    if (scalableLoad <= 0.0f)
+    {
+      break;
+    }
+
+    const float scale = std::max(s_maxLinkLoad - fixedLoad, 0.0f) / scalableLoad;
+    load = fixedLoad;
+    for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+    {
+      const ChannelState& channel = m_channels[type];
+      if (rates[type] > channel.limits.floorHz)
+      {
+        rates[type] = std::max(rates[type] * scale, channel.limits.floorHz);
+        load += rates[type] * channel.costMs / 1000.0f;
+      }
+    }
+  }
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    ChannelState& channel = m_channels[type];
+
+    if (rates[type] > 0.0f)
+    {
+      const unsigned int intervalMs = (unsigned int)std::lround(1000.0f / rates[type]);
+      if (intervalMs != channel.intervalMs)
+      {
+        channel.intervalMs = intervalMs;
+        intervals[(SampleType)type] = intervalMs;
+      }
+    }
+  }
+
+  return !intervals.isEmpty();
+}
+
+/**
+ * Returns the rate (in Hz) at which a sample type has recently been read, or
+ * zero if it isn't being read.
+ */
+float AdaptiveRateController::getAchievedRate(SampleType type, qint64 nowMs) const
+{
+  QMutexLocker locker(&m_lock);
+  const ChannelState& channel = m_channels[type];
+  float rate = 0.0f;
+
+  // a reading that has gone quiet for several of its recent intervals has stopped
+  if ((channel.achievedIntervalMs > 0.0f) &&
+      ((nowMs - channel.lastServiceMs) < (qint64)(channel.achievedIntervalMs * 5.0f) + 1000))
+  {
+    rate = 1000.0f / channel.achievedIntervalMs;
+  }
+
+  return rate;
+}
+
+/**
+ * Returns how quickly a sample type is changing, in full-scale units per second.
+ */
+float AdaptiveRateController::getActivity(SampleType type) const
+{
+  QMutexLocker locker(&m_lock);
+  return m_channels[type].activity;
+}
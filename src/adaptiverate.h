@@ -0,0 +1,65 @@
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include "commonunits.h"
+
+/**
+ * Lowest and highest rates (in Hz) at which an adaptively-scheduled sample
+ * type may be read.
+ */
+struct SampleRateLimits
+{
+  float floorHz = 0.0f;
+  float ceilingHz = 0.0f;
+};
+
+/**
+ * Chooses read intervals for the sample types based on how quickly each one is
+ * changing and how much link time each read costs. A reading that is moving
+ * (such as the throttle during a transient) is read more often, and one that
+ * is steady (such as coolant temperature once the engine is warm) is read less
+ * often, always within the configured floor and ceiling rates. If the chosen
+ * rates would need more time than the link has, they are scaled back evenly.
+ *
+ * The rate actually achieved for every sample type is tracked whether or not
+ * adaptive scheduling is enabled.
+ */
+class AdaptiveRateController
+{
+public:
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+  void setLimits(const QHash<SampleType, SampleRateLimits>& limits);
+  void reset();
+
+  void recordSample(SampleType type, float value, float costMs, qint64 nowMs);
+  bool updateIntervals(qint64 nowMs, QHash<SampleType, unsigned int>& intervals);
+
+  float getAchievedRate(SampleType type, qint64 nowMs) const;
+  float getActivity(SampleType type) const;
+
+private:
+  struct ChannelState
+  {
+    bool adaptive = false;
+    SampleRateLimits limits;
+    bool haveValue = false;
+    float lastValue = 0.0f;
+    qint64 lastServiceMs = 0;
+    float activity = 0.0f;
+    float costMs = 0.0f;
+    float achievedIntervalMs = 0.0f;
+    unsigned int intervalMs = 0;
+  };
+
+  // Each read should ideally see this much change (as a fraction of the
+  // reading's full scale.)
+  static constexpr float s_targetStep = 0.01f;
+  static constexpr float s_maxLinkLoad = 0.9f;
+  static const qint64 s_updatePeriodMs = 250;
+
+  mutable QMutex m_lock;
+  bool m_enabled = false;
+  qint64 m_lastUpdateMs = 0;
+  ChannelState m_channels[SampleType_NumSampleTypes];
+};
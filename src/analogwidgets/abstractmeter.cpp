@@ -45,7 +45,7 @@ void AbstractMeter::setValue( double val )
   if ( m_value != val )
   {
     m_value = val;
-    update(); 
+    repaintValue();
     emit valueChanged(val);
     emit valueChanged((int)val); 
   }
@@ -56,13 +56,18 @@ void AbstractMeter::setValue( int val )
   if ( m_value != val )
   {
     m_value = val;
-    update(); // Ciekawe czy tak jest lepiej ??
+    repaintValue(); // Ciekawe czy tak jest lepiej ??
     // to znaczy najpierw odmalowa a potem generowa sygna ? 
     emit valueChanged(val);
     emit valueChanged(double(val));
   }
 }
 
+void AbstractMeter::repaintValue()
+{
+  update();
+}
+
 void AbstractMeter::setMinimum(double i)
 {
   if ((m_maximum - i) > 0.00001 )
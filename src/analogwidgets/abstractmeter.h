@@ -94,6 +94,13 @@
 	 */
        
 	bool calcMaxMin();
+
+       /**
+         * Schedules a repaint after the value has changed. Subclasses that
+	 * can tell which part of the widget the new value touches may
+	 * repaint only that part.
+	 */
+	virtual void repaintValue();
         
 	/** Starting value on meter  this value is less than m_minimum */
 	double m_min;
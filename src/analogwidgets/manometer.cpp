@@ -27,6 +27,11 @@
 #include "manometer.h"
 #define PI 3.141592653589793238512808959406186204433
 
+// Needle and hub extent in dial coordinates, before rotation, with a unit of
+// margin for antialiasing
+const QRectF ManoMeter::s_needleBounds(-11.0, -52.0, 22.0, 183.0);
+const double ManoMeter::s_needleLength = 129.0;
+
 using namespace Qt;
 ManoMeter::ManoMeter(QWidget *parent)
         : AbstractMeter(parent)
@@ -170,44 +175,164 @@ void ManoMeter::paintBackground(QPainter & painter)
 
 void ManoMeter::paintEvent(QPaintEvent * )
 {
+	// The layers depend on the same properties and geometry as the
+	// background, so they are rebuilt whenever the background is.
+	if (doRepaintBackground() || m_layerSize != size() || m_layerPixelRatio != devicePixelRatioF())
+	{
+	  m_needleValue = value();
+	  renderNeedleLayer();
+	  renderValueTextLayer();
+	  m_layerSize = size();
+	  m_layerPixelRatio = devicePixelRatioF();
+	}
+
 	drawBackground();
 	QPainter painter(this);
-        initCoordinateSystem(painter);
-      // --------------------------------------------- ///
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+	// Rysowanie wskazwki
+	painter.save();
+	painter.setTransform(needleTransform(m_needleValue));
+	painter.drawPixmap(s_needleBounds, m_needleLayer, QRectF(m_needleLayer.rect()));
+	painter.restore();
+
+	// Rysowanie wywietlanej wartoci
+	if (!m_valueTextLayer.isNull())
+	  painter.drawPixmap(m_valueTextRect.topLeft(), m_valueTextLayer);
+}// paintEvent
+
+/**
+ * Repaints only the area swept by the needle and the area covered by the old
+ * and new value strings. A needle movement of less than a pixel at its tip is
+ * not drawn until further changes add up to a whole pixel.
+ */
+void ManoMeter::repaintValue()
+{
+	if (doRepaintBackground() || m_layerSize != size() || m_layerPixelRatio != devicePixelRatioF())
+	{
+	  update();
+	  return;
+	}
+
+	QRect dirty;
+	const double sweep = ((value() - m_needleValue) * 240.0) / (m_max - m_min);
+	const double tipTravel = fabs(sweep) * PI / 180.0 * s_needleLength * scaleFactor();
+
+	if (tipTravel >= 1.0)
+	{
+	  dirty = needleRect(m_needleValue) | needleRect(value());
+	  m_needleValue = value();
+	}
+
+	if (valueText() != m_valueText || (value() >= critical()) != m_valueTextCritical)
+	{
+	  dirty |= m_valueTextRect;
+	  renderValueTextLayer();
+	  dirty |= m_valueTextRect;
+	}
+
+	if (!dirty.isEmpty())
+	  update(dirty);
+}
+
+/** Scale from the 335x335 dial coordinates to widget pixels */
+double ManoMeter::scaleFactor() const
+{
+	return qMin(width(), height()) / 335.0;
+}
+
+/** Same mapping as initCoordinateSystem(), for use outside of a painter */
+QTransform ManoMeter::dialTransform() const
+{
+	QTransform transform;
+	transform.translate(width() / 2, height() / 2);
+	transform.scale(scaleFactor(), scaleFactor());
+	return transform;
+}
+
+/** Maps the needle layer's dial coordinates to the widget for the given value */
+QTransform ManoMeter::needleTransform(double value) const
+{
+	QTransform transform = dialTransform();
+	transform.rotate(60.0 + ((value - m_min) * 240.0) / static_cast<double>(m_max - m_min));
+	return transform;
+}
+
+/** Widget area covered by the needle when it shows the given value */
+QRect ManoMeter::needleRect(double value) const
+{
+	return needleTransform(value).mapRect(s_needleBounds).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+QString ManoMeter::valueText() const
+{
+	return prefix() + QString("%1").arg(value()) + suffix();
+}
+
+/**
+ * Renders the needle and its hub once at the current scale, so that painting
+ * a new value only has to blit the layer at a different angle.
+ */
+void ManoMeter::renderNeedleLayer()
+{
 	static const int hand[12] = {-4, 0, -1, 129, 1, 129, 4, 0, 8,-50, -8,-50};
 
+	const double pixels = scaleFactor() * devicePixelRatioF();
+	m_needleLayer = QPixmap(qMax(1, qCeil(s_needleBounds.width() * pixels)),
+	                        qMax(1, qCeil(s_needleBounds.height() * pixels)));
+	m_needleLayer.fill(Qt::transparent);
 
-        QPainterPath hand_path;
-        hand_path.moveTo(QPointF(hand[0],hand[1]));
+	QPainterPath hand_path;
+	hand_path.moveTo(QPointF(hand[0],hand[1]));
 
-        for (int i=2;i<10;i+=2)
-	 hand_path.lineTo(hand[i],hand[i+1]);
+	for (int i=2;i<10;i+=2)
+	  hand_path.lineTo(hand[i],hand[i+1]);
 
 	hand_path.cubicTo ( 8.1,-51.0, 5.0,-48.0,   0.0,-48.0);
 	hand_path.cubicTo(  -5.0,-48.0, -8.1,-51.0, -8.0,-50.0);
 
-        // Rysowanie wskazwki
-	painter.save();
-	painter.rotate(60.0);
+	QPainter painter(&m_needleLayer);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.scale(m_needleLayer.width() / s_needleBounds.width(),
+	              m_needleLayer.height() / s_needleBounds.height());
+	painter.translate(-s_needleBounds.topLeft());
 	painter.setPen(Qt::NoPen);
 	painter.setBrush(QBrush(Qt::black));
-   	painter.rotate(  ((  value()-m_min) * 240.0) / static_cast<double> (m_max - m_min) );
-
 	painter.drawPath(hand_path);
-
 	painter.drawEllipse(-10,-10,20,20);
+}
 
+/**
+ * Renders the value string into a layer just big enough to hold it, and
+ * records where on the widget that layer belongs.
+ */
+void ManoMeter::renderValueTextLayer()
+{
+	m_valueText = valueText();
+	m_valueTextCritical = (value() >= critical());
 
-        painter.restore();// Przywrocenie do wychylenia o 60 stopni
+	if (!valueOffset())
+	{
+	  m_valueTextLayer = QPixmap();
+	  m_valueTextRect = QRect();
+	  return;
+	}
 
-	// Rysowanie wywietlanej wartoci
-        if (valueOffset())
-        {
+	const QFont font(valueFont(), this);
+	const QFontMetrics metrics(font, this);
+	const QSize Size = metrics.size(Qt::TextSingleLine, m_valueText);
+	const QPointF baseline(Size.width() / -2.0, static_cast<int>(0 - valueOffset()));
+	const QRectF textBounds(baseline.x(), baseline.y() - metrics.ascent(), Size.width(), metrics.height());
 
-	  if (value() >= critical() ) painter.setPen(Qt::red);
-	  painter.setFont(valueFont());
-          QString Str = prefix() + QString("%1").arg(value()) + suffix();
-          QSize Size = painter.fontMetrics().size(Qt::TextSingleLine, Str);
-          painter.drawText( QPointF( Size.width() / -2.0,static_cast<int>( 0 - valueOffset())) , Str);
-        }
-}// paintEvent
+	m_valueTextRect = dialTransform().mapRect(textBounds).toAlignedRect().adjusted(-2, -2, 2, 2);
+	m_valueTextLayer = QPixmap(m_valueTextRect.size() * devicePixelRatioF());
+	m_valueTextLayer.setDevicePixelRatio(devicePixelRatioF());
+	m_valueTextLayer.fill(Qt::transparent);
+
+	QPainter painter(&m_valueTextLayer);
+	painter.translate(-m_valueTextRect.topLeft());
+	initCoordinateSystem(painter);
+	painter.setPen(m_valueTextCritical ? Qt::red : Qt::black);
+	painter.setFont(font);
+	painter.drawText(baseline, m_valueText);
+}
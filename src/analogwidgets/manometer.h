@@ -23,6 +23,8 @@
 #ifndef BARMETER_H
 #define BARMETER_H
 
+#include <QPixmap>
+#include <QTransform>
 #include "abstractmeter.h"
 
 class ManoMeter : public AbstractMeter
@@ -33,6 +35,32 @@ class ManoMeter : public AbstractMeter
   protected:
     void paintEvent(QPaintEvent *event); 	 // inherited from WidgetWithBackground 
     void paintBackground(QPainter & painter);// inherited form WidgetWithBackground 
+    void repaintValue();                     // inherited from AbstractMeter
     void initCoordinateSystem(QPainter & painter);
+
+  private:
+    static const QRectF s_needleBounds;
+    static const double s_needleLength;
+
+    double scaleFactor() const;
+    QTransform dialTransform() const;
+    QTransform needleTransform(double value) const;
+    QRect needleRect(double value) const;
+    QString valueText() const;
+    void renderNeedleLayer();
+    void renderValueTextLayer();
+
+    /** Needle and hub, drawn pointing straight down; rotated into place when painted */
+    QPixmap m_needleLayer;
+    /** Value string, drawn at m_valueTextRect */
+    QPixmap m_valueTextLayer;
+    QRect m_valueTextRect;
+    QString m_valueText;
+    bool m_valueTextCritical = false;
+    /** Value at which the needle is currently drawn; lags m_value by less than a pixel of travel */
+    double m_needleValue = 0.0;
+    /** Widget size and pixel ratio the layers were rendered for */
+    QSize m_layerSize;
+    qreal m_layerPixelRatio = 0.0;
 };
 #endif // BARMETER_H
@@ -0,0 +1,225 @@
+#include <cstring>
+#include <QtEndian>
+#include "binarylogformat.h"
+
+/**
+ * Returns the set of columns written by this version of RoverGauge. The names
+ * and order match the columns of the text log, so that a binary log can be
+ * converted back into exactly the same CSV layout. The lambda trim columns
+ * are retagged by the writer when long-term trim is being logged.
+ */
+QVector<BinaryLogColumn> BinaryLogFormat::defaultColumns()
+{
+  // Readings that change on nearly every poll are stored as fixed-width
+  // fields; readings that change slowly (or are small integers) are
+  // delta-encoded so that an unchanged value costs nothing.
+  return QVector<BinaryLogColumn>
+  {
+    { SampleType_RoadSpeed,          BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "roadSpeed" },
+    { SampleType_EngineRPM,          BinaryLogValueType_Int,   BinaryLogEncoding_Fixed, "engineSpeed" },
+    { SampleType_EngineTemperature,  BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "waterTemp" },
+    { SampleType_FuelTemperature,    BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "fuelTemp" },
+    { SampleType_Throttle,           BinaryLogValueType_Float, BinaryLogEncoding_Fixed, "throttlePos" },
+    { SampleType_MAF,                BinaryLogValueType_Float, BinaryLogEncoding_Fixed, "mafPercentage" },
+    { SampleType_IdleBypassPosition, BinaryLogValueType_Float, BinaryLogEncoding_Delta, "idleBypassPos" },
+    { SampleType_MainVoltage,        BinaryLogValueType_Float, BinaryLogEncoding_Delta, "mainVoltage" },
+    { SampleType_FuelMapIndex,       BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "currentFuelMapIndex" },
+    { SampleType_FuelMapRowCol,      BinaryLogValueType_Float, BinaryLogEncoding_Fixed, "currentFuelMapRow" },
+    { SampleType_FuelMapRowCol,      BinaryLogValueType_Float, BinaryLogEncoding_Fixed, "currentFuelMapCol" },
+    { SampleType_TargetIdleRPM,      BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "targetIdle" },
+    { SampleType_LambdaTrimShort,    BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "lambdaTrimOdd" },
+    { SampleType_LambdaTrimShort,    BinaryLogValueType_Int,   BinaryLogEncoding_Delta, "lambdaTrimEven" },
+    { SampleType_InjectorPulseWidth, BinaryLogValueType_Float, BinaryLogEncoding_Fixed, "pulseWidthMs" }
+  };
+}
+
+/**
+ * Returns the header line of the CSV that corresponds to the columns in the
+ * binary log header.
+ */
+QString BinaryLogFormat::csvHeader(const BinaryLogHeader& header)
+{
+  QString line("#datetime");
+
+  foreach (const BinaryLogColumn& col, header.columns)
+  {
+    line += "," + col.name;
+  }
+
+  return line;
+}
+
+/**
+ * Serializes a segment header (including the leading magic) into the buffer.
+ */
+void BinaryLogFormat::appendHeader(QByteArray& buf, const BinaryLogHeader& header)
+{
+  uchar field[8];
+  quint64 multBits = 0;
+
+  buf.append("RGBL", 4);
+
+  qToLittleEndian<quint16>(header.version, field);
+  buf.append((const char*)field, 2);
+  qToLittleEndian<quint16>(header.flags, field);
+  buf.append((const char*)field, 2);
+
+  memcpy(&multBits, &header.speedoMultiplier, sizeof(multBits));
+  qToLittleEndian<quint64>(multBits, field);
+  buf.append((const char*)field, 8);
+  qToLittleEndian<qint32>(header.speedoOffset, field);
+  buf.append((const char*)field, 4);
+  qToLittleEndian<qint64>(header.startTimeMs, field);
+  buf.append((const char*)field, 8);
+
+  buf.append((char)header.columns.size());
+  foreach (const BinaryLogColumn& col, header.columns)
+  {
+    const QByteArray name = col.name.toUtf8();
+    buf.append((char)col.source);
+    buf.append((char)col.type);
+    buf.append((char)col.encoding);
+    buf.append((char)name.size());
+    buf.append(name);
+  }
+}
+
+/**
+ * Reads the remainder of a segment header, after the initial 'R' tag byte has
+ * already been consumed.
+ * @return True if a complete and supported header was read; false otherwise
+ */
+bool BinaryLogFormat::readHeaderBody(QIODevice& dev, BinaryLogHeader& header)
+{
+  const QByteArray fixed = dev.read(3 + 2 + 2 + 8 + 4 + 8 + 1);
+
+  if ((fixed.size() != 28) || !fixed.startsWith("GBL"))
+  {
+    return false;
+  }
+
+  const uchar* p = (const uchar*)fixed.constData() + 3;
+  quint64 multBits = qFromLittleEndian<quint64>(p + 4);
+
+  header.version = qFromLittleEndian<quint16>(p);
+  header.flags = qFromLittleEndian<quint16>(p + 2);
+  memcpy(&header.speedoMultiplier, &multBits, sizeof(multBits));
+  header.speedoOffset = qFromLittleEndian<qint32>(p + 12);
+  header.startTimeMs = qFromLittleEndian<qint64>(p + 16);
+
+  const int columnCount = p[24];
+
+  if ((header.version > currentVersion) || (columnCount > maxColumns))
+  {
+    return false;
+  }
+
+  header.columns.clear();
+  for (int idx = 0; idx < columnCount; idx++)
+  {
+    const QByteArray desc = dev.read(4);
+    if (desc.size() != 4)
+    {
+      return false;
+    }
+
+    BinaryLogColumn col;
+    col.source = (SampleType)(uchar)desc.at(0);
+    col.type = (BinaryLogValueType)(uchar)desc.at(1);
+    col.encoding = (BinaryLogEncoding)(uchar)desc.at(2);
+
+    const int nameLen = (uchar)desc.at(3);
+    const QByteArray name = dev.read(nameLen);
+    if (name.size() != nameLen)
+    {
+      return false;
+    }
+    col.name = QString::fromUtf8(name);
+
+    header.columns.append(col);
+  }
+
+  return true;
+}
+
+/**
+ * Appends an unsigned LEB128 varint to the buffer.
+ */
+void BinaryLogFormat::appendVarint(QByteArray& buf, quint64 value)
+{
+  while (value >= 0x80)
+  {
+    buf.append((char)((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buf.append((char)value);
+}
+
+/**
+ * Reads an unsigned LEB128 varint from the device.
+ * @return True if a complete varint was read; false at end of file
+ */
+bool BinaryLogFormat::readVarint(QIODevice& dev, quint64& value)
+{
+  char c = 0;
+  int shift = 0;
+
+  value = 0;
+  do
+  {
+    if ((shift > 63) || !dev.getChar(&c))
+    {
+      return false;
+    }
+    value |= (quint64)(c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+
+  return true;
+}
+
+/**
+ * Appends a fixed-width (four byte) column value to the buffer.
+ */
+void BinaryLogFormat::appendFixed(QByteArray& buf, qint32 value)
+{
+  uchar field[4];
+  qToLittleEndian<qint32>(value, field);
+  buf.append((const char*)field, 4);
+}
+
+/**
+ * Reads a fixed-width (four byte) column value from the device.
+ */
+bool BinaryLogFormat::readFixed(QIODevice& dev, qint32& value)
+{
+  uchar field[4];
+
+  if (dev.read((char*)field, 4) != 4)
+  {
+    return false;
+  }
+
+  value = qFromLittleEndian<qint32>(field);
+  return true;
+}
+
+/**
+ * Returns the IEEE-754 bit pattern of a float, for storage in an integer column.
+ */
+qint32 BinaryLogFormat::floatBits(float value)
+{
+  qint32 bits = 0;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/**
+ * Reinterprets a stored bit pattern as a float.
+ */
+float BinaryLogFormat::bitsToFloat(qint32 bits)
+{
+  float value = 0.0f;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
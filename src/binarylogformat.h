@@ -0,0 +1,115 @@
+#pragma once
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QIODevice>
+#include "commonunits.h"
+
+/**
+ * Layout of the binary log (.rglog) files
+ *
+ * A log is a sequence of segments, each of which begins with a header
+ * describing the columns (one per logged reading, tagged with the SampleType
+ * that produces it), followed by any number of records. A new segment is
+ * also started when the lambda trim being logged switches between short- and
+ * long-term, so that the trim columns are always tagged with the right type.
+ * All multi-byte integers are little-endian.
+ *
+ * Header:
+ *   'R' 'G' 'B' 'L'  magic
+ *   u16              format version
+ *   u16              flags (BinaryLogFlag_*)
+ *   f64              road speed multiplier
+ *   i32              road speed offset
+ *   i64              time of segment creation (msecs since epoch)
+ *   u8               column count
+ *   per column:      u8 sample type, u8 value type, u8 encoding,
+ *                    u8 name length, name (UTF-8)
+ *
+ * Records start with a one-byte tag. A keyframe ('K') holds the absolute
+ * timestamp as a varint, the fixed-width columns, and then every delta-encoded
+ * column as an absolute zigzag varint. A delta record ('D') holds the time
+ * since the previous record as a varint, the fixed-width columns, a varint
+ * bitmask of the delta-encoded columns that changed, and a zigzag varint
+ * difference for each of those columns. Keyframes are written periodically so
+ * that a reader can resynchronize without decoding from the start of the file.
+ *
+ * Float columns are stored as their IEEE-754 bit patterns, so values are
+ * reproduced exactly when converted back to text.
+ */
+
+enum BinaryLogRecordTag
+{
+  BinaryLogRecordTag_Header = 'R',
+  BinaryLogRecordTag_Keyframe = 'K',
+  BinaryLogRecordTag_Delta = 'D'
+};
+
+enum BinaryLogValueType
+{
+  BinaryLogValueType_Int,
+  BinaryLogValueType_Float
+};
+
+enum BinaryLogEncoding
+{
+  BinaryLogEncoding_Fixed,
+  BinaryLogEncoding_Delta
+};
+
+enum BinaryLogFlag
+{
+  BinaryLogFlag_SpeedoAdjust = 0x0001,
+  BinaryLogFlag_TimesFromZero = 0x0002
+};
+
+struct BinaryLogColumn
+{
+  SampleType source;
+  BinaryLogValueType type;
+  BinaryLogEncoding encoding;
+  QString name;
+};
+
+struct BinaryLogHeader
+{
+  quint16 version = 0;
+  quint16 flags = 0;
+  double speedoMultiplier = 1.0;
+  qint32 speedoOffset = 0;
+  qint64 startTimeMs = 0;
+  QVector<BinaryLogColumn> columns;
+};
+
+class BinaryLogFormat
+{
+public:
+  static const quint16 currentVersion = 1;
+  static const int maxColumns = 32;
+  static const int keyframeInterval = 250;
+
+  static QVector<BinaryLogColumn> defaultColumns();
+  static QString csvHeader(const BinaryLogHeader& header);
+
+  static void appendHeader(QByteArray& buf, const BinaryLogHeader& header);
+  static bool readHeaderBody(QIODevice& dev, BinaryLogHeader& header);
+
+  static void appendVarint(QByteArray& buf, quint64 value);
+  static bool readVarint(QIODevice& dev, quint64& value);
+  static void appendFixed(QByteArray& buf, qint32 value);
+  static bool readFixed(QIODevice& dev, qint32& value);
+
+  static quint64 zigzag(qint64 value)
+  {
+    return ((quint64)value << 1) ^ (quint64)(value >> 63);
+  }
+
+  static qint64 unzigzag(quint64 value)
+  {
+    return (qint64)(value >> 1) ^ -(qint64)(value & 1);
+  }
+
+  static qint32 floatBits(float value);
+  static float bitsToFloat(qint32 bits);
+};
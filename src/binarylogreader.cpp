@@ -0,0 +1,165 @@
+#include "binarylogreader.h"
+
+/**
+ * Opens a binary log and reads the header of its first segment.
+ * @return True if the file was opened and begins with a valid header
+ */
+bool BinaryLogReader::open(const QString& path)
+{
+  char tag = 0;
+
+  close();
+  m_file.setFileName(path);
+
+  if (!m_file.open(QFile::ReadOnly))
+  {
+    m_error = m_file.errorString();
+    return false;
+  }
+
+  if (!m_file.getChar(&tag) || (tag != BinaryLogRecordTag_Header) || !readSegmentHeader())
+  {
+    m_error = "Not a RoverGauge binary log";
+    m_file.close();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Closes the log file and discards the decoding state.
+ */
+void BinaryLogReader::close()
+{
+  m_file.close();
+  m_haveHeader = false;
+  m_haveKeyframe = false;
+  m_headerChanged = false;
+  m_error.clear();
+}
+
+/**
+ * Reads a segment header (after its tag byte) and resets the decoding state.
+ */
+bool BinaryLogReader::readSegmentHeader()
+{
+  if (!BinaryLogFormat::readHeaderBody(m_file, m_header))
+  {
+    return false;
+  }
+
+  m_values.fill(0, m_header.columns.size());
+  m_haveHeader = true;
+  m_haveKeyframe = false;
+  m_headerChanged = true;
+
+  return true;
+}
+
+/**
+ * Moves to the given file offset, which must be the start of a record or
+ * segment header. Delta records are skipped until the next keyframe, since
+ * they cannot be decoded without one.
+ */
+bool BinaryLogReader::seek(qint64 offset)
+{
+  m_haveKeyframe = false;
+  return m_haveHeader && m_file.seek(offset);
+}
+
+/**
+ * Decodes the next record in the file. When a new segment begins, its header
+ * is read and headerChanged() returns true until the following call.
+ * @param record Receives the decoded timestamp and column values
+ * @return True if a record was read; false at the end of the file or if the
+ *  file is damaged (in which case errorString() is set)
+ */
+bool BinaryLogReader::readNext(BinaryLogRecord& record)
+{
+  char tag = 0;
+  m_headerChanged = false;
+
+  while (m_haveHeader && m_file.getChar(&tag))
+  {
+    if (tag == BinaryLogRecordTag_Header)
+    {
+      if (!readSegmentHeader())
+      {
+        m_error = "Invalid segment header";
+        return false;
+      }
+      continue;
+    }
+
+    if ((tag != BinaryLogRecordTag_Keyframe) && (tag != BinaryLogRecordTag_Delta))
+    {
+      m_error = QString("Unknown record type at offset %1").arg(m_file.pos() - 1);
+      return false;
+    }
+
+    const bool keyframe = (tag == BinaryLogRecordTag_Keyframe);
+    const int columnCount = m_header.columns.size();
+    quint64 timeField = 0;
+    quint64 changedMask = 0;
+    quint64 field = 0;
+    bool ok = BinaryLogFormat::readVarint(m_file, timeField);
+
+    for (int col = 0; ok && (col < columnCount); col++)
+    {
+      if (m_header.columns.at(col).encoding == BinaryLogEncoding_Fixed)
+      {
+        ok = BinaryLogFormat::readFixed(m_file, m_values[col]);
+      }
+    }
+
+    if (ok && !keyframe)
+    {
+      ok = BinaryLogFormat::readVarint(m_file, changedMask);
+    }
+
+    int deltaBit = 0;
+    for (int col = 0; ok && (col < columnCount); col++)
+    {
+      if (m_header.columns.at(col).encoding == BinaryLogEncoding_Delta)
+      {
+        if (keyframe)
+        {
+          ok = BinaryLogFormat::readVarint(m_file, field);
+          m_values[col] = (qint32)BinaryLogFormat::unzigzag(field);
+        }
+        else if (changedMask & (1ULL << deltaBit))
+        {
+          ok = BinaryLogFormat::readVarint(m_file, field);
+          m_values[col] = (qint32)(m_values[col] + BinaryLogFormat::unzigzag(field));
+        }
+        deltaBit++;
+      }
+    }
+
+    if (!ok)
+    {
+      // a partial final record is expected if the application was killed
+      // before the last buffer was flushed
+      m_error = "Log ends with a truncated record";
+      return false;
+    }
+
+    m_timestampMs = keyframe ? (qint64)timeField : (m_timestampMs + (qint64)timeField);
+
+    if (keyframe)
+    {
+      m_haveKeyframe = true;
+    }
+
+    if (m_haveKeyframe)
+    {
+      record.timestampMs = m_timestampMs;
+      record.keyframe = keyframe;
+      record.values = m_values;
+      return true;
+    }
+  }
+
+  return false;
+}
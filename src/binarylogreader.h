@@ -0,0 +1,65 @@
+#pragma once
+#include <QString>
+#include <QFile>
+#include <QVector>
+#include "binarylogformat.h"
+
+/**
+ * A single decoded record from a binary log. The values are in the column
+ * order given by the header of the segment that the record belongs to.
+ */
+struct BinaryLogRecord
+{
+  qint64 timestampMs = 0;
+  bool keyframe = false;
+  QVector<qint32> values;
+};
+
+/**
+ * Sequential decoder for binary log (.rglog) files.
+ */
+class BinaryLogReader
+{
+public:
+  bool open(const QString& path);
+  void close();
+  bool readNext(BinaryLogRecord& record);
+  bool seek(qint64 offset);
+
+  qint64 pos() const
+  {
+    return m_file.pos();
+  }
+
+  qint64 size() const
+  {
+    return m_file.size();
+  }
+
+  const BinaryLogHeader& header() const
+  {
+    return m_header;
+  }
+
+  bool headerChanged() const
+  {
+    return m_headerChanged;
+  }
+
+  QString errorString() const
+  {
+    return m_error;
+  }
+
+private:
+  QFile m_file;
+  BinaryLogHeader m_header;
+  bool m_haveHeader = false;
+  bool m_haveKeyframe = false;
+  bool m_headerChanged = false;
+  QVector<qint32> m_values;
+  qint64 m_timestampMs = 0;
+  QString m_error;
+
+  bool readSegmentHeader();
+};
@@ -0,0 +1,228 @@
+#include <QDateTime>
+#include "binarylogwriter.h"
+
+/**
+ * Constructor.
+ */
+BinaryLogWriter::BinaryLogWriter()
+{
+  m_header.version = BinaryLogFormat::currentVersion;
+  m_header.columns = BinaryLogFormat::defaultColumns();
+  m_values.resize(m_header.columns.size());
+  m_lastValues.resize(m_header.columns.size());
+}
+
+/**
+ * Destructor. Writes out anything that is still buffered.
+ */
+BinaryLogWriter::~BinaryLogWriter()
+{
+  close();
+}
+
+/**
+ * Opens the log for appending and writes a new segment header.
+ * @param path Path to the log file
+ * @param flags Combination of BinaryLogFlag values
+ * @param speedoMultiplier Road speed multiplier to apply when converting the log
+ * @param speedoOffset Road speed offset to apply when converting the log
+ * @return True if the file was opened; false otherwise
+ */
+bool BinaryLogWriter::open(const QString& path, quint16 flags, double speedoMultiplier, int speedoOffset)
+{
+  bool status = false;
+
+  if (!m_file.isOpen())
+  {
+    m_file.setFileName(path);
+    if (m_file.open(QFile::WriteOnly | QFile::Append))
+    {
+      m_header.flags = flags;
+      m_header.speedoMultiplier = speedoMultiplier;
+      m_header.speedoOffset = speedoOffset;
+      m_header.startTimeMs = QDateTime::currentMSecsSinceEpoch();
+
+      m_buffer.clear();
+      m_buffer.reserve(s_flushSizeBytes + 256);
+      BinaryLogFormat::appendHeader(m_buffer, m_header);
+
+      // force the first record to be a keyframe
+      m_recordsSinceKeyframe = BinaryLogFormat::keyframeInterval;
+      m_sinceFlush.start();
+      status = true;
+    }
+  }
+
+  return status;
+}
+
+/**
+ * Encodes a frame as a single record. The buffered records are written out to
+ * the file once the buffer is full or once a second has passed.
+ * @param frame Set of readings to log
+ */
+void BinaryLogWriter::append(const TelemetryFrame& frame)
+{
+  if (!m_file.isOpen())
+  {
+    return;
+  }
+
+  extractValues(frame);
+  tagLambdaTrimColumns(frame.lambdaTrimType);
+
+  const int columnCount = m_header.columns.size();
+  const bool keyframe = (m_recordsSinceKeyframe >= BinaryLogFormat::keyframeInterval) ||
+                        (frame.timestampMs < m_lastTimestampMs);
+
+  if (keyframe)
+  {
+    m_buffer.append((char)BinaryLogRecordTag_Keyframe);
+    BinaryLogFormat::appendVarint(m_buffer, (quint64)frame.timestampMs);
+    m_recordsSinceKeyframe = 0;
+  }
+  else
+  {
+    m_buffer.append((char)BinaryLogRecordTag_Delta);
+    BinaryLogFormat::appendVarint(m_buffer, (quint64)(frame.timestampMs - m_lastTimestampMs));
+    m_recordsSinceKeyframe++;
+  }
+
+  for (int col = 0; col < columnCount; col++)
+  {
+    if (m_header.columns.at(col).encoding == BinaryLogEncoding_Fixed)
+    {
+      BinaryLogFormat::appendFixed(m_buffer, m_values.at(col));
+    }
+  }
+
+  if (keyframe)
+  {
+    for (int col = 0; col < columnCount; col++)
+    {
+      if (m_header.columns.at(col).encoding == BinaryLogEncoding_Delta)
+      {
+        BinaryLogFormat::appendVarint(m_buffer, BinaryLogFormat::zigzag(m_values.at(col)));
+      }
+    }
+  }
+  else
+  {
+    quint64 changedMask = 0;
+    int deltaBit = 0;
+
+    for (int col = 0; col < columnCount; col++)
+    {
+      if (m_header.columns.at(col).encoding == BinaryLogEncoding_Delta)
+      {
+        if (m_values.at(col) != m_lastValues.at(col))
+        {
+          changedMask |= (1ULL << deltaBit);
+        }
+        deltaBit++;
+      }
+    }
+
+    BinaryLogFormat::appendVarint(m_buffer, changedMask);
+
+    for (int col = 0; col < columnCount; col++)
+    {
+      if ((m_header.columns.at(col).encoding == BinaryLogEncoding_Delta) &&
+          (m_values.at(col) != m_lastValues.at(col)))
+      {
+        const qint64 delta = (qint64)m_values.at(col) - (qint64)m_lastValues.at(col);
+        BinaryLogFormat::appendVarint(m_buffer, BinaryLogFormat::zigzag(delta));
+      }
+    }
+  }
+
+  m_lastValues = m_values;
+  m_lastTimestampMs = frame.timestampMs;
+
+  if ((m_buffer.size() >= s_flushSizeBytes) || (m_sinceFlush.elapsed() >= s_flushIntervalMs))
+  {
+    flush();
+  }
+}
+
+/**
+ * Writes any buffered records out to the file.
+ */
+void BinaryLogWriter::flush()
+{
+  if (m_file.isOpen() && !m_buffer.isEmpty())
+  {
+    m_file.write(m_buffer);
+    m_file.flush();
+    m_buffer.clear();
+  }
+
+  m_sinceFlush.restart();
+}
+
+/**
+ * Flushes and closes the log file.
+ */
+void BinaryLogWriter::close()
+{
+  if (m_file.isOpen())
+  {
+    flush();
+    m_file.close();
+  }
+}
+
+/**
+ * Tags the lambda trim columns with the kind of trim that is being read. The
+ * kind can be switched while logging; when it is, a new segment header is
+ * written with the columns retagged, and the next record is a keyframe.
+ */
+void BinaryLogWriter::tagLambdaTrimColumns(c14cux_lambda_trim_type type)
+{
+  const SampleType source = (type == C14CUX_LambdaTrimType_LongTerm) ?
+                            SampleType_LambdaTrimLong : SampleType_LambdaTrimShort;
+  bool retagged = false;
+
+  for (BinaryLogColumn& column : m_header.columns)
+  {
+    if (((column.source == SampleType_LambdaTrimShort) || (column.source == SampleType_LambdaTrimLong)) &&
+        (column.source != source))
+    {
+      column.source = source;
+      retagged = true;
+    }
+  }
+
+  if (retagged)
+  {
+    BinaryLogFormat::appendHeader(m_buffer, m_header);
+    m_recordsSinceKeyframe = BinaryLogFormat::keyframeInterval;
+  }
+}
+
+/**
+ * Pulls the logged readings out of the frame, in column order. Road speed is
+ * stored without the speedometer adjustment; the multiplier and offset are
+ * kept in the header and applied at conversion time instead.
+ */
+void BinaryLogWriter::extractValues(const TelemetryFrame& frame)
+{
+  const float row = (float)frame.fuelMapRowIndex + ((float)frame.fuelMapRowWeighting / 16.0);
+  const float col = (float)frame.fuelMapColumnIndex + ((float)frame.fuelMapColumnWeighting / 16.0);
+
+  m_values[0]  = (qint32)frame.roadSpeed;
+  m_values[1]  = frame.engineSpeedRPM;
+  m_values[2]  = frame.coolantTemp;
+  m_values[3]  = frame.fuelTemp;
+  m_values[4]  = BinaryLogFormat::floatBits(frame.throttlePos);
+  m_values[5]  = BinaryLogFormat::floatBits(frame.mafReading);
+  m_values[6]  = BinaryLogFormat::floatBits(frame.idleBypassPos);
+  m_values[7]  = BinaryLogFormat::floatBits(frame.mainVoltage);
+  m_values[8]  = frame.currentFuelMapIndex;
+  m_values[9]  = BinaryLogFormat::floatBits(row);
+  m_values[10] = BinaryLogFormat::floatBits(col);
+  m_values[11] = frame.targetIdleSpeed;
+  m_values[12] = frame.lambdaTrimOdd;
+  m_values[13] = frame.lambdaTrimEven;
+  m_values[14] = BinaryLogFormat::floatBits(frame.injectorPulseWidthMs);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include <QElapsedTimer>
+#include "binarylogformat.h"
+#include "telemetryframe.h"
+
+/**
+ * Streams TelemetryFrames to a binary log file. Encoded records accumulate in
+ * memory and are written out when the buffer fills or when enough time has
+ * passed since the last write, rather than once per record.
+ */
+class BinaryLogWriter
+{
+public:
+  BinaryLogWriter();
+  ~BinaryLogWriter();
+
+  bool open(const QString& path, quint16 flags, double speedoMultiplier, int speedoOffset);
+  void append(const TelemetryFrame& frame);
+  void flush();
+  void close();
+
+  bool isOpen() const
+  {
+    return m_file.isOpen();
+  }
+
+  QString errorString() const
+  {
+    return m_file.errorString();
+  }
+
+  int handle() const
+  {
+    return m_file.handle();
+  }
+
+  qint64 size() const
+  {
+    return m_file.size() + m_buffer.size();
+  }
+
+private:
+  static const int s_flushSizeBytes = 64 * 1024;
+  static const qint64 s_flushIntervalMs = 1000;
+
+  QFile m_file;
+  BinaryLogHeader m_header;
+  QByteArray m_buffer;
+  QElapsedTimer m_sinceFlush;
+  QVector<qint32> m_values;
+  QVector<qint32> m_lastValues;
+  qint64 m_lastTimestampMs = 0;
+  int m_recordsSinceKeyframe = 0;
+
+  void extractValues(const TelemetryFrame& frame);
+  void tagLambdaTrimColumns(c14cux_lambda_trim_type type);
+};
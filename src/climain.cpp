@@ -0,0 +1,290 @@
+#include <csignal>
+#include <cstdio>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDateTime>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include "cuxinterface.h"
+#include "headlesssession.h"
+#include "logsegmentcompressor.h"
+#include "logsettings.h"
+#include "samplesettings.h"
+
+static volatile std::sig_atomic_t s_stopRequested = 0;
+
+/**
+ * Handler for SIGINT/SIGTERM. Only sets a flag; the event loop checks it.
+ */
+static void onStopSignal(int)
+{
+  s_stopRequested = 1;
+}
+
+int main(int argc, char* argv[])
+{
+  const QString versionStr = QString("%1.%2.%3").arg(ROVERGAUGE_VER_MAJOR).arg(ROVERGAUGE_VER_MINOR).arg(ROVERGAUGE_VER_PATCH);
+
+  QCoreApplication a(argc, argv);
+  a.setApplicationVersion(versionStr);
+  a.setApplicationName("rovergauge-cli");
+
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Logs data from the Lucas 14CUX automotive ECU without a graphical interface");
+
+  const QCommandLineOption configOption
+    ({"c", "config"}, "Read settings from <file> instead of the RoverGauge settings file.", "file");
+  const QCommandLineOption deviceOption
+    ({"p", "port"}, "Serial device connected to the 14CUX (overrides the settings file.)", "device");
+  const QCommandLineOption logNameOption
+    ({"o", "log"}, "Base name of the log file (written in the 'logs' directory.)", "name");
+  const QCommandLineOption samplesOption
+    ({"r", "readings"}, "Comma-separated list of readings to enable, e.g. EngineRPM,MAF,Throttle. "
+     "All other readings are disabled.", "list");
+  const QCommandLineOption intervalOption
+    ({"i", "interval"}, "Interval between reads of a reading, e.g. RoadSpeed=500. May be repeated.", "name=ms");
+  const QCommandLineOption binaryOption
+    ({"b", "binary"}, "Write a binary (.rglog) log instead of a text log.");
+  const QCommandLineOption syncOption
+    ("sync", "When to force the log onto the disk: 'none' (leave it to the OS), 'interval' (every few seconds; "
+     "the default), or 'always' (after every write.)", "policy");
+  const QCommandLineOption segmentSizeOption
+    ("segment-size", "Start a new log segment when the current one reaches <MB> megabytes.", "MB");
+  const QCommandLineOption segmentTimeOption
+    ("segment-time", "Start a new log segment when the current one is <minutes> old.", "minutes");
+  const QCommandLineOption compressOption
+    ("compress", "Compress each log segment with zstd once it is closed.");
+  const QCommandLineOption adaptiveOption
+    ({"a", "adaptive"}, "Read changing values more often and steady ones less often, within the "
+     "limits in the [SampleRateLimits] group of the settings file.");
+  const QCommandLineOption statsOption
+    ({"t", "stats"}, "Append link statistics (read rates, read times, and failures) to <file> whenever "
+     "the connection is closed.", "file");
+  const QCommandLineOption retryOption
+    ({"w", "retry"}, "Seconds to wait before reconnecting after a failure (0 exits instead; default 5.)", "secs", "5");
+  QCommandLineOption doublebaudOption
+    ({"d", "doublebaud"}, "Connect to an ECU that has customized firmware doubling the serial baud rate.");
+  doublebaudOption.setFlags(QCommandLineOption::HiddenFromHelp);
+  QCommandLineOption simulatedData
+    ({"s", "simulated"}, "Simulate a connection to the ECU. Generally used only for internal RoverGauge testing.");
+  simulatedData.setFlags(QCommandLineOption::HiddenFromHelp);
+  QCommandLineOption simulationSeedOption
+    ("sim-seed", "Seed for the simulated engine; the same seed gives the same readings.", "n", "1");
+  simulationSeedOption.setFlags(QCommandLineOption::HiddenFromHelp);
+
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addOption(configOption);
+  parser.addOption(deviceOption);
+  parser.addOption(logNameOption);
+  parser.addOption(samplesOption);
+  parser.addOption(intervalOption);
+  parser.addOption(binaryOption);
+  parser.addOption(syncOption);
+  parser.addOption(segmentSizeOption);
+  parser.addOption(segmentTimeOption);
+  parser.addOption(compressOption);
+  parser.addOption(adaptiveOption);
+  parser.addOption(statsOption);
+  parser.addOption(retryOption);
+  parser.addOption(doublebaudOption);
+  parser.addOption(simulatedData);
+  parser.addOption(simulationSeedOption);
+
+  parser.process(a);
+
+  QTextStream err(stderr);
+
+  // Start from the same settings that the GUI uses (or from the file given
+  // on the command line), then apply any command-line overrides.
+  QSettings* settings = parser.isSet(configOption) ?
+    new QSettings(parser.value(configOption), QSettings::IniFormat) :
+    new QSettings(QSettings::IniFormat, QSettings::UserScope, "RoverGauge");
+
+  const QMap<SampleType, QString> enableNames = SampleSettings::enableSettingNames();
+  QMap<SampleType, bool> enabledSamples;
+  QHash<SampleType, unsigned int> intervals = SampleSettings::defaultReadIntervals();
+  QHash<SampleType, SampleRateLimits> rateLimits = SampleSettings::defaultRateLimits();
+  LogSettings logSettings;
+
+  settings->beginGroup("Settings");
+  QString device = settings->value("SerialDevice", "").toString();
+  const SpeedUnits speedUnits = (SpeedUnits)(settings->value("SpeedUnits", MPH).toInt());
+  const TemperatureUnits tempUnits = (TemperatureUnits)(settings->value("TemperatureUnits", Fahrenheit).toInt());
+  logSettings.format = (LogFormat)(settings->value("LogFormat", LogFormat_Text).toInt());
+  logSettings.timesMsecsFromZero = settings->value("LogTimesMsecsFromZero", false).toBool();
+  logSettings.speedoAdjust = settings->value("SpeedometerAdjustment", false).toBool();
+  logSettings.speedoMultiplier = settings->value("SpeedometerMultiplier", 1.0).toDouble();
+  logSettings.speedoOffset = settings->value("SpeedometerOffset", 0).toInt();
+  logSettings.syncPolicy = (LogSyncPolicy)(settings->value("LogSyncPolicy", LogSyncPolicy_Interval).toInt());
+  logSettings.syncIntervalMs = settings->value("LogSyncIntervalMs", 5000).toInt();
+  logSettings.segmentMaxMB = settings->value("LogSegmentMaxMB", 0).toInt();
+  logSettings.segmentMaxMinutes = settings->value("LogSegmentMaxMinutes", 0).toInt();
+  logSettings.compressSegments = settings->value("LogCompressSegments", false).toBool();
+  bool adaptiveRates = settings->value("AdaptiveSampleRates", false).toBool();
+  foreach (SampleType sType, enableNames.keys())
+  {
+    enabledSamples[sType] = settings->value(enableNames[sType], true).toBool();
+  }
+  settings->endGroup();
+
+  SampleSettings::readIntervalOverrides(*settings, intervals);
+  SampleSettings::readRateLimitOverrides(*settings, rateLimits);
+  delete settings;
+
+  if (parser.isSet(samplesOption))
+  {
+    foreach (SampleType sType, enableNames.keys())
+    {
+      enabledSamples[sType] = false;
+    }
+
+    foreach (const QString& name, parser.value(samplesOption).split(',', Qt::SkipEmptyParts))
+    {
+      SampleType sType;
+      if (!SampleSettings::fromShortName(name, sType))
+      {
+        err << "Unknown reading: " << name << Qt::endl;
+        return 1;
+      }
+      enabledSamples[sType] = true;
+    }
+  }
+
+  // the grouped readings follow the user-selectable reading in their group
+  SampleSettings::groupLikeSamples(enabledSamples);
+  enabledSamples[SampleType_MIL] = true;
+
+  foreach (const QString& spec, parser.values(intervalOption))
+  {
+    const QStringList parts = spec.split('=');
+    SampleType sType;
+    bool ok = false;
+
+    if (parts.size() == 2)
+    {
+      const unsigned int intervalMs = parts.at(1).toUInt(&ok);
+      ok = ok && SampleSettings::fromShortName(parts.at(0), sType);
+      if (ok)
+      {
+        intervals[sType] = intervalMs;
+      }
+    }
+
+    if (!ok)
+    {
+      err << "Invalid interval: " << spec << Qt::endl;
+      return 1;
+    }
+  }
+
+  if (parser.isSet(deviceOption))
+  {
+    device = parser.value(deviceOption);
+  }
+#ifdef WIN32
+  device = QString("\\\\.\\%1").arg(device);
+#endif
+
+  if (parser.isSet(binaryOption))
+  {
+    logSettings.format = LogFormat_Binary;
+  }
+
+  if (parser.isSet(syncOption))
+  {
+    const QString policy = parser.value(syncOption);
+    if (policy == "none")
+    {
+      logSettings.syncPolicy = LogSyncPolicy_None;
+    }
+    else if (policy == "interval")
+    {
+      logSettings.syncPolicy = LogSyncPolicy_Interval;
+    }
+    else if (policy == "always")
+    {
+      logSettings.syncPolicy = LogSyncPolicy_EveryFlush;
+    }
+    else
+    {
+      err << "Unknown sync policy: " << policy << Qt::endl;
+      return 1;
+    }
+  }
+
+  if (parser.isSet(segmentSizeOption))
+  {
+    bool ok = false;
+    logSettings.segmentMaxMB = parser.value(segmentSizeOption).toInt(&ok);
+    if (!ok || (logSettings.segmentMaxMB < 0))
+    {
+      err << "Invalid segment size: " << parser.value(segmentSizeOption) << Qt::endl;
+      return 1;
+    }
+  }
+
+  if (parser.isSet(segmentTimeOption))
+  {
+    bool ok = false;
+    logSettings.segmentMaxMinutes = parser.value(segmentTimeOption).toInt(&ok);
+    if (!ok || (logSettings.segmentMaxMinutes < 0))
+    {
+      err << "Invalid segment time: " << parser.value(segmentTimeOption) << Qt::endl;
+      return 1;
+    }
+  }
+
+  if (parser.isSet(compressOption))
+  {
+    logSettings.compressSegments = true;
+  }
+
+  if (logSettings.compressSegments && !LogSegmentCompressor::isAvailable())
+  {
+    err << "Warning: this build cannot compress logs; segments will be left uncompressed" << Qt::endl;
+  }
+
+  if (parser.isSet(adaptiveOption))
+  {
+    adaptiveRates = true;
+  }
+
+  const QString logName = parser.isSet(logNameOption) ?
+    parser.value(logNameOption) : QDateTime::currentDateTime().toString("yyyy-MM-dd_hh.mm.ss");
+
+  CUXInterface* cux = new CUXInterface(device, CUXInterface::getBaudRate(parser.isSet(doublebaudOption)),
+                                       speedUnits, tempUnits, false, parser.isSet(simulatedData));
+  cux->setSimulationSeed(parser.value(simulationSeedOption).toUInt());
+  cux->setEnabledSamples(enabledSamples);
+  cux->setRateLimits(rateLimits);
+  cux->setReadIntervals(intervals);
+  cux->setAdaptiveRates(adaptiveRates);
+  cux->setStatisticsReportPath(parser.value(statsOption));
+
+  HeadlessSession session(cux, logName, logSettings, parser.value(retryOption).toInt());
+
+  std::signal(SIGINT, onStopSignal);
+  std::signal(SIGTERM, onStopSignal);
+
+  QTimer stopCheck;
+  QObject::connect(&stopCheck, &QTimer::timeout, [&a]()
+  {
+    if (s_stopRequested)
+    {
+      a.quit();
+    }
+  });
+  stopCheck.start(250);
+
+  session.start();
+  const int status = a.exec();
+  session.shutdown();
+
+  return status;
+}
@@ -12,6 +12,19 @@ enum TemperatureUnits
   Celsius
 };
 
+enum LogFormat
+{
+  LogFormat_Text,
+  LogFormat_Binary
+};
+
+enum LogSyncPolicy
+{
+  LogSyncPolicy_None,
+  LogSyncPolicy_Interval,
+  LogSyncPolicy_EveryFlush
+};
+
 enum SampleType
 {
   SampleType_EngineTemperature,
@@ -49,3 +62,18 @@ enum QueueableRequest
   QueueableRequest_BatteryBackedMem
 };
 
+enum FuelMapOverlay
+{
+  FuelMapOverlay_None,
+  FuelMapOverlay_Dwell,
+  FuelMapOverlay_LambdaTrimMean,
+  FuelMapOverlay_LambdaTrimStdDev,
+  FuelMapOverlay_MAF
+};
+
+enum RomReadStage
+{
+  RomReadStage_Reading,
+  RomReadStage_Verifying,
+  RomReadStage_Comparing
+};
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <QThread>
 #include <QDateTime>
-#include <QCoreApplication>
+#include <QTimer>
+#include <QRandomGenerator>
 #include <string.h>
 #include "cuxinterface.h"
 
@@ -21,7 +23,7 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
   m_deviceName(device),
   m_baudRate(baud),
   m_batteryBackedMem(21, 0x00),
-  m_romImage(16384, 0x00),
+  m_romImage(s_romImageBytes, 0x00),
   m_speedUnits(sUnits),
   m_tempUnits(tUnits),
   m_fuelMapRefresh(fuelMapRefresh)
@@ -34,16 +36,16 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
   }
 
   memset(&m_rpmTable, 0, sizeof(m_rpmTable));
-
-  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
-  {
-    m_lastReadTime.insert((SampleType)type, 0);
-  }
+  m_readTimer.start();
 
   if (m_sim)
   {
     m_simEcu = new SimulatedECUData();
   }
+
+  // Wakeups may be requested from any thread; the queued connection ensures
+  // that the service pass itself always runs in the worker thread.
+  connect(this, &CUXInterface::serviceWakeRequested, this, &CUXInterface::onServiceWake, Qt::QueuedConnection);
 }
 
 /**
@@ -52,6 +54,82 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
 CUXInterface::~CUXInterface()
 {
   delete m_simEcu;
+  delete m_replay;
+}
+
+/**
+ * Chooses the seed for the simulated engine, so that a simulated session can
+ * be repeated exactly. Has no effect unless the interface was created in
+ * simulation mode.
+ * @param seed Seed for the simulated engine's driving pattern and noise
+ */
+void CUXInterface::setSimulationSeed(uint32_t seed)
+{
+  if (m_simEcu)
+  {
+    m_simEcu->setSeed(seed);
+  }
+}
+
+/**
+ * Replaces the simulated ECU with a recorded log. Must be called before the
+ * first connection, and only on an interface created in simulation mode.
+ * @param source Opened log to replay; ownership passes to this object
+ * @param speed Playback speed multiplier, or 0 to replay as fast as possible
+ * @param startOffsetMs Point in the log (in msecs from its start) at which
+ *  each connection begins replaying
+ */
+void CUXInterface::setReplaySource(LogReplaySource* source, unsigned int speed, qint64 startOffsetMs)
+{
+  delete m_replay;
+  m_replay = source;
+  m_replaySpeed = speed;
+  m_replayStartOffsetMs = startOffsetMs;
+}
+
+/**
+ * Changes the replay speed multiplier (0 for as fast as possible.) May be
+ * called from any thread.
+ */
+void CUXInterface::setReplaySpeed(unsigned int speed)
+{
+  m_replaySpeed = speed;
+  wakeServiceLoop();
+}
+
+/**
+ * Jumps to a point in the log being replayed. May be called from any thread.
+ * @param offsetMs Milliseconds from the start of the log
+ */
+void CUXInterface::seekReplay(qint64 offsetMs)
+{
+  m_replaySeekMs = std::max<qint64>(0, offsetMs);
+  wakeServiceLoop();
+}
+
+/**
+ * Determines the order in which a queued request is serviced relative to the
+ * others and to the periodic readings.
+ */
+CUXInterface::RequestClass CUXInterface::requestClass(QueueableRequest req)
+{
+  RequestClass reqClass = RequestClass_OneShot;
+
+  switch (req)
+  {
+  case QueueableRequest_FuelPumpRun:
+  case QueueableRequest_IACMotorDrive:
+  case QueueableRequest_ClearFaultCodes:
+    reqClass = RequestClass_Actuator;
+    break;
+  case QueueableRequest_ROMImage:
+    reqClass = RequestClass_Bulk;
+    break;
+  default:
+    break;
+  }
+
+  return reqClass;
 }
 
 /**
@@ -61,8 +139,11 @@ CUXInterface::~CUXInterface()
 void CUXInterface::enqueueRequest(QueueableRequest req, int data)
 {
   m_queueMutex.lock();
-  m_reqQueue.enqueue(std::pair<QueueableRequest, int>(req, data));
+  m_reqQueues[requestClass(req)].enqueue(std::pair<QueueableRequest, int>(req, data));
+  m_linkStats.recordQueueDepth(queuedRequestCount());
   m_queueMutex.unlock();
+
+  wakeServiceLoop();
 }
 
 /**
@@ -73,14 +154,90 @@ void CUXInterface::enqueueRequest(QueueableRequest req)
   enqueueRequest(req, 0);
 }
 
-void CUXInterface::processQueuedRequest()
+/**
+ * Returns the total number of requests waiting in the queues. The caller must
+ * hold the queue mutex.
+ */
+int CUXInterface::queuedRequestCount() const
 {
-  if (isConnected())
+  int count = 0;
+
+  for (int reqClass = 0; reqClass < (int)RequestClass_NumClasses; reqClass++)
   {
-    m_queueMutex.lock();
-    const std::pair<QueueableRequest, int> req = m_reqQueue.dequeue();
-    m_queueMutex.unlock();
+    count += m_reqQueues[reqClass].size();
+  }
+
+  return count;
+}
+
+/**
+ * Indicates whether there are any requests waiting in the queues.
+ */
+bool CUXInterface::hasQueuedRequest()
+{
+  QMutexLocker locker(&m_queueMutex);
+  return (queuedRequestCount() > 0);
+}
+
+/**
+ * Removes the highest-priority waiting request from the queues.
+ * @param includeBulk True to also consider bulk transfers
+ * @param req Set to the request that was removed
+ * @return True if a request was waiting, false otherwise
+ */
+bool CUXInterface::takeQueuedRequest(bool includeBulk, std::pair<QueueableRequest, int>& req)
+{
+  QMutexLocker locker(&m_queueMutex);
+  const int lastClass = includeBulk ? RequestClass_Bulk : RequestClass_OneShot;
+  bool found = false;
 
+  for (int reqClass = 0; !found && (reqClass <= lastClass); reqClass++)
+  {
+    if (!m_reqQueues[reqClass].isEmpty())
+    {
+      req = m_reqQueues[reqClass].dequeue();
+      found = true;
+    }
+  }
+
+  if (found)
+  {
+    m_linkStats.recordQueueDepth(queuedRequestCount());
+  }
+
+  return found;
+}
+
+/**
+ * Services the waiting actuator commands and one-shot reads, highest priority
+ * first, and then advances any bulk transfer by a single chunk. Requests that
+ * arrive while a one-shot read is in progress are picked up before the next
+ * one starts, so an actuator command never waits behind more than one read.
+ */
+void CUXInterface::serviceQueuedRequests()
+{
+  std::pair<QueueableRequest, int> req;
+
+  while (!m_stopPolling && !m_shutdownThread && takeQueuedRequest(false, req))
+  {
+    processQueuedRequest(req);
+  }
+
+  if (!m_romReadActive && takeQueuedRequest(true, req))
+  {
+    processQueuedRequest(req);
+  }
+
+  if (m_romReadActive)
+  {
+    readROMChunk();
+  }
+}
+
+void CUXInterface::processQueuedRequest(const std::pair<QueueableRequest, int>& req)
+{
+  if (isConnected())
+  {
     const QueueableRequest reqType = std::get<0>(req);
     const int reqData = std::get<1>(req);
 
@@ -98,11 +255,14 @@ void CUXInterface::processQueuedRequest()
     case QueueableRequest_FuelMapData:
       readFuelMap(reqData);
       break;
+    case QueueableRequest_FuelPumpRun:
+      runFuelPump();
+      break;
     case QueueableRequest_IACMotorDrive:
       driveIACMotor(reqData);
       break;
     case QueueableRequest_ROMImage:
-      readROMImage();
+      startROMImage();
       break;
     case QueueableRequest_RPMTable:
       readRPMTable();
@@ -178,48 +338,300 @@ void CUXInterface::clearFaultCodes()
 }
 
 /**
- * Reads the entire 16KB ROM.
+ * Begins reading the 16KB ROM, or resumes a read that was canceled or failed
+ * partway through. The image is read in small blocks, one per service pass,
+ * so that the periodic readings keep updating during the dump.
  */
-void CUXInterface::readROMImage()
+void CUXInterface::startROMImage()
 {
+  m_readCanceled = false;
+
   if (m_sim)
   {
     // In simulation mode, we don't support reading the ROM image.
     emit romImageReadFailed();
   }
-  else
+  else if (!m_romReadActive)
+  {
+    // a previously completed image is read again from the start
+    if (m_romReadOffset >= m_romImage.size())
+    {
+      m_romReadOffset = 0;
+    }
+
+    m_romReadActive = true;
+    m_romVerifyPass = 0;
+    m_romChunkFailures = 0;
+
+    if ((m_romReadOffset > 0) || !startROMComparison())
+    {
+      emit romImageProgress(m_romReadOffset, m_romImage.size(), RomReadStage_Reading);
+    }
+  }
+}
+
+/**
+ * Looks for a cached image for this ECU's tune and, if there is one, sets up
+ * a comparison against a sample of blocks spread across the ROM. A different
+ * set of blocks is chosen each time, so repeated checks of the same car cover
+ * more of the ROM.
+ * @return True if a cached image was found, false if the ROM must be read
+ */
+bool CUXInterface::startROMComparison()
+{
+  QByteArray cached;
+
+  m_romSampling = readTuneIdentity() &&
+                  m_romCache.load(RomImageCache::keyFor(m_tune, m_checksumFixer, m_ident), cached) &&
+                  (cached.size() == m_romImage.size());
+
+  if (m_romSampling)
   {
-    if (c14cux_dumpROM(&m_cuxinfo, reinterpret_cast<uint8_t*>(m_romImage.data())))
+    const int blockCount = m_romImage.size() / s_romChunkBytes;
+    const int stride = blockCount / s_romSampleBlocks;
+    const int phase = QRandomGenerator::global()->bounded(stride);
+
+    // copied into place rather than assigned, since the GUI may be holding a reference to the buffer
+    memcpy(m_romImage.data(), cached.constData(), m_romImage.size());
+    m_romSampleOffsets.clear();
+    for (int block = phase; block < blockCount; block += stride)
     {
-      if (!m_readCanceled)
+      m_romSampleOffsets.append(block * s_romChunkBytes);
+    }
+    m_romSampleIndex = 0;
+    emit romImageProgress(0, m_romSampleOffsets.size() * s_romChunkBytes, RomReadStage_Comparing);
+  }
+
+  return m_romSampling;
+}
+
+/**
+ * Reads a single block of ROM. A failed block is retried on the following
+ * passes; the dump is only abandoned when the same block has failed several
+ * times in a row.
+ * @return True if the block was read, false otherwise
+ */
+bool CUXInterface::readROMBlock(int offset, int length, uint8_t* buffer)
+{
+  bool status = c14cux_readMem(&m_cuxinfo, s_romBaseAddress + offset, length, buffer);
+
+  if (status)
+  {
+    m_romChunkFailures = 0;
+  }
+  else if (++m_romChunkFailures > s_romChunkRetries)
+  {
+    abortROMImage();
+  }
+
+  return status;
+}
+
+/**
+ * Reads the next block of the ROM image. The first pass fills the image; if
+ * the finished image fails its checksum, further passes read it again and
+ * replace any block that doesn't match the earlier read.
+ */
+void CUXInterface::readROMChunk()
+{
+  if (m_readCanceled)
+  {
+    // keep what has been read so far, so that the next request resumes
+    m_romReadActive = false;
+    m_readCanceled = false;
+    return;
+  }
+
+  const int total = m_romImage.size();
+
+  if (m_romSampling)
+  {
+    readROMSample();
+  }
+  else if (m_romVerifyPass == 0)
+  {
+    const int remaining = total - m_romReadOffset;
+    const int length = (remaining < s_romChunkBytes) ? remaining : s_romChunkBytes;
+    uint8_t* const buffer = reinterpret_cast<uint8_t*>(m_romImage.data()) + m_romReadOffset;
+
+    if (readROMBlock(m_romReadOffset, length, buffer))
+    {
+      m_romReadOffset += length;
+      emit romImageProgress(m_romReadOffset, total, RomReadStage_Reading);
+
+      if (m_romReadOffset >= total)
       {
-        emit romImageReady();
+        finishROMPass();
       }
     }
-    else
+  }
+  else
+  {
+    const int remaining = total - m_romVerifyOffset;
+    const int length = (remaining < s_romChunkBytes) ? remaining : s_romChunkBytes;
+    uint8_t block[s_romChunkBytes];
+
+    if (readROMBlock(m_romVerifyOffset, length, block))
     {
-      if (!m_readCanceled)
+      uint8_t* const image = reinterpret_cast<uint8_t*>(m_romImage.data()) + m_romVerifyOffset;
+      if (memcmp(image, block, length) != 0)
+      {
+        memcpy(image, block, length);
+        m_romVerifyMismatch = true;
+      }
+
+      m_romVerifyOffset += length;
+      emit romImageProgress(m_romVerifyOffset, total, RomReadStage_Verifying);
+
+      if (m_romVerifyOffset >= total)
       {
-        emit romImageReadFailed();
+        finishROMPass();
       }
     }
   }
+}
+
+/**
+ * Reads the next sampled block and compares it with the cached image. If
+ * every sample matches, the cached image is taken to be the ROM's contents.
+ * At the first mismatch the cached image is abandoned and the whole ROM is
+ * read instead.
+ */
+void CUXInterface::readROMSample()
+{
+  const int offset = m_romSampleOffsets.at(m_romSampleIndex);
+  uint8_t block[s_romChunkBytes];
+
+  if (readROMBlock(offset, s_romChunkBytes, block))
+  {
+    if (memcmp(m_romImage.constData() + offset, block, s_romChunkBytes) != 0)
+    {
+      m_romSampling = false;
+      m_romReadOffset = 0;
+      emit romImageProgress(0, m_romImage.size(), RomReadStage_Reading);
+    }
+    else if (++m_romSampleIndex < m_romSampleOffsets.size())
+    {
+      emit romImageProgress(m_romSampleIndex * s_romChunkBytes,
+                            m_romSampleOffsets.size() * s_romChunkBytes, RomReadStage_Comparing);
+    }
+    else
+    {
+      m_romSampling = false;
+      m_romReadOffset = m_romImage.size();
+      completeROMImage();
+    }
+  }
+}
+
+/**
+ * Decides what to do after a full pass over the ROM. A valid checksum, or a
+ * verification pass that read back exactly the same data (as it will for a
+ * modified ROM whose checksum was never fixed), completes the image.
+ * Otherwise the image is verified again, up to a limit.
+ */
+void CUXInterface::finishROMPass()
+{
+  const bool consistent = (m_romVerifyPass > 0) && !m_romVerifyMismatch;
+
+  if (isROMChecksumValid(m_romImage) || consistent)
+  {
+    // failing to write the cache only means that the next check of this ECU will be slower
+    if (readTuneIdentity())
+    {
+      m_romCache.store(RomImageCache::keyFor(m_tune, m_checksumFixer, m_ident), m_romImage);
+    }
+
+    completeROMImage();
+  }
+  else if (m_romVerifyPass < s_romVerifyPasses)
+  {
+    m_romVerifyPass++;
+    m_romVerifyOffset = 0;
+    m_romVerifyMismatch = false;
+  }
+  else
+  {
+    abortROMImage();
+  }
+}
+
+/**
+ * Ends the ROM read and reports that the image is ready.
+ */
+void CUXInterface::completeROMImage()
+{
+  m_romReadActive = false;
+  if (!m_readCanceled)
+  {
+    emit romImageReady();
+  }
+  m_readCanceled = false;
+}
+
+/**
+ * Abandons a ROM read that is in progress, reporting the failure unless the
+ * read was canceled. The blocks read so far are kept so that the read can be
+ * resumed.
+ */
+void CUXInterface::abortROMImage()
+{
+  if (m_romReadActive)
+  {
+    m_romReadActive = false;
+    if (!m_readCanceled)
+    {
+      emit romImageReadFailed();
+    }
+  }
 
   m_readCanceled = false;
 }
 
+/**
+ * Checks the ROM image against the 14CUX's checksum, which requires the 8-bit
+ * sum of every byte in the ROM to be 0x01.
+ */
+bool CUXInterface::isROMChecksumValid(const QByteArray& image)
+{
+  uint8_t sum = 0;
+
+  for (int idx = 0; idx < image.size(); idx++)
+  {
+    sum += static_cast<uint8_t>(image.at(idx));
+  }
+
+  return (sum == 0x01);
+}
+
 /**
  * Reads the data for the specified fuel map from the ECU, emitting a signal
  * when done.
  * @param fuelMapId ID of the fuel map that should be retrieved (1 through 5)
+ * @param announce False to store the map without signaling that it's ready,
+ *  as when it is prefetched in the background
  */
-bool CUXInterface::readFuelMap(unsigned int fuelMapId)
+bool CUXInterface::readFuelMap(unsigned int fuelMapId, bool announce)
 {
   uint8_t* const buffer = reinterpret_cast<uint8_t* const>(m_fuelMaps[fuelMapId].data());
   uint16_t adjFactor = 0;
   bool status = false;
 
-  if (m_sim)
+  if (m_replay)
+  {
+    // only the map that was recorded in the static data log is available
+    const ReplayStaticData& recorded = m_replay->staticData();
+    if (recorded.valid && (recorded.fuelMapId == fuelMapId))
+    {
+      m_fuelMaps[fuelMapId] = recorded.fuelMap;
+      m_fuelMapAdjFactors[fuelMapId] = recorded.fuelMapAdjFactor;
+      m_rowScaler[fuelMapId] = recorded.rowScaler;
+      m_mafScaler = recorded.mafScaler;
+      m_fuelMapDataIsCurrent[fuelMapId] = true;
+      status = true;
+    }
+  }
+  else if (m_sim)
   {
     m_simEcu->fuelMapData(buffer, m_mafScaler, m_fuelMapAdjFactors[fuelMapId]);
     m_fuelMapDataIsCurrent[fuelMapId] = true;
@@ -232,9 +644,15 @@ bool CUXInterface::readFuelMap(unsigned int fuelMapId)
     m_fuelMapAdjFactors[fuelMapId] = adjFactor;
     m_fuelMapDataIsCurrent[fuelMapId] = true;
     status = true;
+
+    if (readTuneIdentity())
+    {
+      m_fuelMapCache.storeMap(RomImageCache::keyFor(m_tune, m_checksumFixer, m_ident), fuelMapId,
+                              m_fuelMaps[fuelMapId], adjFactor, m_rowScaler[fuelMapId], m_mafScaler);
+    }
   }
 
-  if (status)
+  if (status && announce)
   {
     emit fuelMapReady(fuelMapId);
   }
@@ -250,14 +668,121 @@ void CUXInterface::readRPMTable()
   if (m_sim)
   {
     m_simEcu->engineRPMTable(m_rpmTable);
+    m_rpmTableRead = true;
     emit rpmTableReady();
   }
   else if (c14cux_getRpmTable(&m_cuxinfo, &m_rpmTable))
   {
+    m_rpmTableRead = true;
+    if (readTuneIdentity())
+    {
+      m_fuelMapCache.storeRPMTable(RomImageCache::keyFor(m_tune, m_checksumFixer, m_ident), m_rpmTable);
+    }
     emit rpmTableReady();
   }
 }
 
+/**
+ * Reads the tune number, checksum fixer, and ident that identify the ECU's
+ * ROM, unless they've already been read during this connection.
+ * @return True if the values are known, false otherwise
+ */
+bool CUXInterface::readTuneIdentity()
+{
+  if (!m_tuneRevRead && !m_sim)
+  {
+    m_tuneRevRead = c14cux_getTuneRevision(&m_cuxinfo, &m_tune, &m_checksumFixer, &m_ident);
+  }
+
+  return m_tuneRevRead;
+}
+
+/**
+ * Fills in any fuel maps, and the RPM table, that were read from an ECU with
+ * the same ROM on an earlier connection. Those maps are then available as
+ * soon as the fuel map index is known, without spending any link time on
+ * reading them again.
+ */
+void CUXInterface::loadCachedFuelMaps()
+{
+  if (readTuneIdentity())
+  {
+    const QString key = RomImageCache::keyFor(m_tune, m_checksumFixer, m_ident);
+    uint16_t mafScaler = 0;
+
+    if (m_fuelMapCache.loadMAFScaler(key, mafScaler))
+    {
+      m_mafScaler = mafScaler;
+
+      for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
+      {
+        m_fuelMapDataIsCurrent[idx] =
+          m_fuelMapCache.loadMap(key, idx, m_fuelMaps[idx], m_fuelMapAdjFactors[idx], m_rowScaler[idx]);
+      }
+    }
+
+    if (m_fuelMapCache.loadRPMTable(key, m_rpmTable))
+    {
+      m_rpmTableRead = true;
+      emit rpmTableReady();
+    }
+  }
+}
+
+/**
+ * Indicates whether the RPM table or any of the fuel maps has yet to be read
+ * during this connection.
+ */
+bool CUXInterface::isPrefetchPending() const
+{
+  bool pending = !m_rpmTableRead;
+
+  for (unsigned int idx = 0; !pending && (idx < fuelMapCount); ++idx)
+  {
+    pending = !m_fuelMapDataIsCurrent[idx];
+  }
+
+  return pending && !m_replay && (m_prefetchFailures < s_prefetchMaxFailures);
+}
+
+/**
+ * Reads the RPM table or one of the fuel maps that hasn't been read yet, so
+ * that switching to any map later doesn't have to wait for it to come across
+ * the link. The time taken is tracked so that the service loop can judge
+ * whether the next prefetch will fit in the slack before a sample is due.
+ */
+void CUXInterface::prefetchFuelData()
+{
+  const qint64 start = m_readTimer.nsecsElapsed();
+  bool status = true;
+
+  if (!m_rpmTableRead)
+  {
+    readRPMTable();
+    status = m_rpmTableRead;
+  }
+  else
+  {
+    for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
+    {
+      if (!m_fuelMapDataIsCurrent[idx])
+      {
+        status = readFuelMap(idx, false);
+        break;
+      }
+    }
+  }
+
+  if (!status)
+  {
+    m_prefetchFailures++;
+  }
+
+  const float costMs = (float)(m_readTimer.nsecsElapsed() - start) / 1e6f;
+  m_prefetchCostMs = (m_prefetchCostMs * 0.5f) + (costMs * 0.5f);
+  m_lastPrefetchMs = m_readTimer.elapsed();
+}
+
 /**
  * Commands the ECU to close the fuel pump relay and run the fuel pump for
  * a single time interval.
@@ -292,12 +817,20 @@ void CUXInterface::driveIACMotor(int steps)
 
 void CUXInterface::readTuneRevID()
 {
-  if (m_sim)
+  if (m_replay && m_replay->staticData().valid)
+  {
+    m_tune = m_replay->staticData().tune;
+    m_checksumFixer = m_replay->staticData().checksumFixer;
+    m_ident = m_replay->staticData().ident;
+    emit revisionNumberReady(m_tune, m_checksumFixer, m_ident);
+  }
+  else if (m_sim)
   {
     emit revisionNumberReady(1234, 255, 255);
   }
   else if (c14cux_getTuneRevision(&m_cuxinfo, &m_tune, &m_checksumFixer, &m_ident))
   {
+    m_tuneRevRead = true;
     emit revisionNumberReady(m_tune, m_checksumFixer, m_ident);
   }
 }
@@ -310,6 +843,8 @@ bool CUXInterface::connectToECU()
 {
   if (m_sim)
   {
+    // every simulated connection starts the same run from a cold engine
+    m_simEcu->reset();
     m_simConnected = true;
   }
 
@@ -318,6 +853,10 @@ bool CUXInterface::connectToECU()
 
   if (status)
   {
+    if (!m_sim)
+    {
+      loadCachedFuelMaps();
+    }
     emit connected();
   }
 
@@ -330,11 +869,13 @@ bool CUXInterface::connectToECU()
 void CUXInterface::disconnectFromECU()
 {
   m_stopPolling = true;
+  wakeServiceLoop();
 }
 
 /**
  * Clears flags and stored data. Called on disconnect, so that reconnecting will force
- * retrieval of fresh data from the ECU.
+ * retrieval of fresh data from the ECU (or from the fuel map cache, if the ROM has
+ * been seen before.)
  */
 void CUXInterface::clearFlagsAndData()
 {
@@ -344,18 +885,23 @@ void CUXInterface::clearFlagsAndData()
     m_fuelMapDataIsCurrent[idx] = false;
   }
 
+  // a partial ROM image can't be resumed on what might be a different ECU
+  m_romReadOffset = 0;
+
   m_fuelMapIndexRead = false;
 
-  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
-  {
-    m_lastReadTime[(SampleType)type] = 0;
-  }
+  // make every sample due as soon as we reconnect
+  m_scheduler.reset();
+  m_rates.reset();
 
   m_cuxinfo.promRev = C14CUX_DataOffsets_Unset;
   m_cuxinfo.voltageFactorA = 0;
   m_cuxinfo.voltageFactorB = 0;
   m_cuxinfo.voltageFactorC = 0;
   m_rpmLimitRead = false;
+  m_tuneRevRead = false;
+  m_rpmTableRead = false;
+  m_prefetchFailures = 0;
 }
 
 /**
@@ -363,29 +909,16 @@ void CUXInterface::clearFlagsAndData()
  */
 void CUXInterface::onShutdownThreadRequest()
 {
-  // If we're currently connected, just set a flag to let the polling loop
-  // shut the thread down. Otherwise, shut it down here.
-  if (m_sim)
+  // If we're currently polling, just set a flag and let the next service
+  // pass disconnect and shut the thread down. Otherwise, shut it down here.
+  if (m_polling)
   {
-    if (m_simConnected)
-    {
-      m_shutdownThread = true;
-    }
-    else
-    {
-      QThread::currentThread()->quit();
-    }
+    m_shutdownThread = true;
+    runServicePass();
   }
   else
   {
-    if (c14cux_isConnected(&m_cuxinfo))
-    {
-      m_shutdownThread = true;
-    }
-    else
-    {
-      QThread::currentThread()->quit();
-    }
+    QThread::currentThread()->quit();
   }
 }
 
@@ -415,6 +948,13 @@ void CUXInterface::onParentThreadStarted()
     {
       c14cux_init(&m_cuxinfo);
     }
+
+    // The timer is created here so that it belongs to the worker thread.
+    m_serviceTimer = new QTimer(this);
+    m_serviceTimer->setSingleShot(true);
+    m_serviceTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_serviceTimer, &QTimer::timeout, this, &CUXInterface::runServicePass);
+
     m_initComplete = true;
   }
 
@@ -430,7 +970,20 @@ void CUXInterface::onStartPollingRequest()
   {
     m_stopPolling = false;
     m_shutdownThread = false;
-    runServiceLoop();
+    m_polling = true;
+    m_linkStats.reset();
+
+    // a map read takes roughly 350 ms at the standard baud rate
+    m_prefetchCostMs = 2750000.0f / m_baudRate;
+    m_lastPrefetchMs = m_readTimer.elapsed();
+
+    // every connection starts replaying from the same point
+    if (m_replay)
+    {
+      m_replaySeekMs = m_replayStartOffsetMs;
+    }
+
+    m_serviceTimer->start(0);
   }
   else
   {
@@ -451,36 +1004,124 @@ void CUXInterface::onStartPollingRequest()
 }
 
 /**
- * Calls readData() in a loop until commanded to disconnect and possibly
- * shut down the thread.
+ * Asks the worker thread to run a service pass as soon as it is idle. This may
+ * be called from any thread, and is used when something happens (such as a new
+ * queued request or a disconnect command) that shouldn't have to wait for the
+ * next sample to fall due. Repeated calls before the pass runs are coalesced.
+ */
+void CUXInterface::wakeServiceLoop()
+{
+  if (!m_wakePending.exchange(true))
+  {
+    emit serviceWakeRequested();
+  }
+}
+
+/**
+ * Responds to a wakeup request by running a service pass immediately.
  */
-void CUXInterface::runServiceLoop()
+void CUXInterface::onServiceWake()
 {
-  ReadResult res = ReadResult_NoStatement;
-  bool connected = m_sim ? m_simConnected : c14cux_isConnected(&m_cuxinfo);
+  m_wakePending = false;
 
-  while (!m_stopPolling && !m_shutdownThread && connected)
+  if (m_polling)
   {
-    // process any queued requests before we get the periodic data update
-    while (!m_reqQueue.isEmpty())
-    {
-      processQueuedRequest();
-    }
+    runServicePass();
+  }
+}
+
+/**
+ * Services any queued requests and reads the samples that are currently due,
+ * then arms the service timer to fire when the next sample falls due. When
+ * nothing is due, the worker thread simply sleeps in its event loop until
+ * either the timer fires or it is woken by wakeServiceLoop(), so no CPU time
+ * is spent while waiting on long read intervals.
+ */
+void CUXInterface::runServicePass()
+{
+  if (!m_polling)
+  {
+    return;
+  }
+
+  const bool connected = m_sim ? m_simConnected : c14cux_isConnected(&m_cuxinfo);
+
+  if (m_stopPolling || m_shutdownThread || !connected)
+  {
+    stopServiceLoop(connected);
+    return;
+  }
+
+  const qint64 passStart = m_readTimer.nsecsElapsed();
+
+  // service any queued requests before we get the periodic data update
+  serviceQueuedRequests();
+
+  qint64 wait = -1;
 
-    res = m_sim ? readSimData() : readData();
+  if (m_replay)
+  {
+    wait = runReplayPass();
+  }
+  else
+  {
+    const ReadResult res = readData();
 
     if (res == ReadResult_Success)
     {
+      publishFrame();
       emit readSuccess();
-      emit dataReady();
+      notifyDataReady();
     }
     else if (res == ReadResult_Failure)
     {
       emit readError();
     }
 
-    QCoreApplication::processEvents();
+    wait = m_scheduler.msecsUntilNextDue();
+
+    // Fill the slack before the next sample falls due by prefetching the
+    // fuel maps. If the schedule is too busy to ever leave enough slack,
+    // a prefetch is allowed to delay the samples slightly once in a while.
+    if (isPrefetchPending() && !m_romReadActive && !hasQueuedRequest() &&
+        ((wait < 0) || (wait >= (qint64)m_prefetchCostMs) ||
+         ((m_readTimer.elapsed() - m_lastPrefetchMs) > s_prefetchMaxDeferMs)))
+    {
+      prefetchFuelData();
+      wait = m_scheduler.msecsUntilNextDue();
+    }
+  }
+
+  m_linkStats.recordPass((float)(m_readTimer.nsecsElapsed() - passStart) / 1e6f);
+
+  if (m_stopPolling || m_shutdownThread || m_romReadActive || hasQueuedRequest())
+  {
+    m_serviceTimer->start(0);
+  }
+  else
+  {
+    // With no samples enabled there is nothing to time; the next pass will be
+    // triggered by a wakeup instead.
+    if (wait >= 0)
+    {
+      m_serviceTimer->start(static_cast<int>(wait));
+    }
+    else
+    {
+      m_serviceTimer->stop();
+    }
   }
+}
+
+/**
+ * Stops the service timer, closes the serial device, and shuts down the
+ * thread if that was requested.
+ * @param connected True if the serial device is still open
+ */
+void CUXInterface::stopServiceLoop(bool connected)
+{
+  m_serviceTimer->stop();
+  m_polling = false;
 
   if (m_sim)
   {
@@ -491,6 +1132,13 @@ void CUXInterface::runServiceLoop()
     c14cux_disconnect(&m_cuxinfo);
   }
 
+  const QString reportPath = m_linkStats.reportPath();
+  if (!reportPath.isEmpty())
+  {
+    LinkStatistics::writeReport(getLinkStatistics(), reportPath);
+  }
+
+  abortROMImage();
   emit disconnected();
   clearFlagsAndData();
 
@@ -531,351 +1179,660 @@ bool CUXInterface::isSampleAppropriateForMode(SampleType type) const
 }
 
 /**
- * Determines if a sample type is due to be read (i.e. enough time has passed since the
- * last reading to prevent another read from being redundant)
+ * Reads every sample that the scheduler reports as due, in priority order, and
+ * stores the data in member variables. If the pass runs longer than its time
+ * budget, the remaining samples are handed back to the scheduler so that the
+ * high-priority readings are not held up behind slow ones.
+ * @return Success if at least one value was read successfully, failure if all
+ *  the reads failed, or NoStatement if nothing was due.
  */
-bool CUXInterface::isDueForMeasurement(SampleType type)
+CUXInterface::ReadResult CUXInterface::readData()
 {
-  bool status = false;
+  ReadResult result = ReadResult_NoStatement;
+  const qint64 passStart = m_scheduler.now();
+
+  m_scheduler.takeDueSamples(m_dueSamples);
 
-  if (m_enabledSamples[type] && isSampleAppropriateForMode(type))
+  float batchShareMs = 0.0f;
+
+  // fetch the memory behind all the batchable samples with as few reads as possible
+  if (!m_sim && m_batchedReads)
   {
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int batchedCount = 0;
 
-    if (now - m_lastReadTime[type] >= m_readIntervals[type])
+    m_batch.clear();
+    foreach (SampleType type, m_dueSamples)
     {
-      status = true;
-      m_lastReadTime[type] = now;
+      if (m_enabledSamples[type] && isSampleAppropriateForMode(type) && addBatchFields(type))
+      {
+        batchedCount++;
+      }
+    }
+
+    if (batchedCount > 0)
+    {
+      // the cost of the shared reads is split evenly among the samples that use them
+      const qint64 batchStart = m_readTimer.nsecsElapsed();
+      readBatch();
+      batchShareMs = (float)(m_readTimer.nsecsElapsed() - batchStart) / 1e6f / batchedCount;
     }
   }
 
-  return status;
+  for (int idx = 0; idx < m_dueSamples.size(); idx++)
+  {
+    const SampleType type = m_dueSamples.at(idx);
+
+    if ((idx > 0) && ((m_scheduler.now() - passStart) > s_passBudgetMs))
+    {
+      m_scheduler.defer(type);
+    }
+    else
+    {
+      if (m_enabledSamples[type] && isSampleAppropriateForMode(type))
+      {
+        const qint64 readStart = m_readTimer.nsecsElapsed();
+        ReadResult typeResult = ReadResult_NoStatement;
+        float costMs = 0.0f;
+
+        if (!m_sim && m_batchedReads && decodeBatchedSample(type, typeResult))
+        {
+          costMs = batchShareMs;
+        }
+        else
+        {
+          typeResult = m_sim ? readSimSample(type) : readSample(type);
+          costMs = (float)(m_readTimer.nsecsElapsed() - readStart) / 1e6f;
+        }
+
+        result = mergeResult(result, typeResult);
+        if (typeResult != ReadResult_NoStatement)
+        {
+          m_linkStats.recordRead(type, (typeResult == ReadResult_Success), costMs);
+        }
+        m_rates.recordSample(type, sampleLevel(type), costMs, m_scheduler.now());
+      }
+      m_scheduler.complete(type);
+    }
+  }
+
+  // move link time toward the readings that are changing
+  if (m_rates.updateIntervals(m_scheduler.now(), m_adaptedIntervals))
+  {
+    foreach (SampleType type, m_adaptedIntervals.keys())
+    {
+      m_scheduler.setInterval(type, m_adaptedIntervals[type]);
+    }
+  }
+
+  return result;
 }
 
 /**
- * Reads data from the 14CUX via calls to the library, and stores the data in
- * member variables.
- * @return True if at least one value was read successfully; false otherwise.
+ * Reads a single sample type from the 14CUX via calls to the library, and stores
+ * the data in member variables.
+ * @param type Sample type to read
+ * @return Result of the read(s) needed for this sample type
  */
-CUXInterface::ReadResult CUXInterface::readData()
+CUXInterface::ReadResult CUXInterface::readSample(SampleType type)
 {
   ReadResult result = ReadResult_NoStatement;
 
-  if (isDueForMeasurement(SampleType_MAF))
+  switch (type)
   {
+  case SampleType_MAF:
     result = mergeResult(result, c14cux_getMAFReading(&m_cuxinfo, m_airflowType, &m_mafReading));
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_Throttle))
-  {
+  case SampleType_Throttle:
     result = mergeResult(result, c14cux_getThrottlePosition(&m_cuxinfo, m_throttlePosType, &m_throttlePos));
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_LambdaTrimShort))
-  {
+  case SampleType_LambdaTrimShort:
     result = mergeResult(result, c14cux_getLambdaTrimShort(&m_cuxinfo, C14CUX_Bank_Odd, &m_lambdaTrimOdd));
     result = mergeResult(result, c14cux_getLambdaTrimShort(&m_cuxinfo, C14CUX_Bank_Even, &m_lambdaTrimEven));
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_EngineRPM))
-  {
+  case SampleType_EngineRPM:
     result = mergeResult(result, c14cux_getEngineRPM(&m_cuxinfo, &m_engineSpeedRPM));
+    if (result == ReadResult_Success)
+    {
+      checkRPMLimit();
+    }
+    break;
+
+  case SampleType_FuelMapRowCol:
+    result = mergeResult(result, c14cux_getFuelMapRowIndex(&m_cuxinfo, &m_currentFuelMapRowIndex, &m_fuelMapRowWeighting));
+    result = mergeResult(result, c14cux_getFuelMapColumnIndex(&m_cuxinfo, &m_currentFuelMapColumnIndex, &m_fuelMapColWeighting));
+    break;
+
+  case SampleType_InjectorPulseWidth:
+    result = mergeResult(result, c14cux_getInjectorPulseWidth(&m_cuxinfo, &m_injectorPulseWidthUs));
+    m_injectorPulseWidthMs = (float)m_injectorPulseWidthUs / 1000.0;
+    break;
+
+  case SampleType_IdleBypassPosition:
+    result = mergeResult(result, c14cux_getIdleBypassMotorPosition(&m_cuxinfo, &m_idleBypassPos));
+    break;
+
+  case SampleType_LambdaTrimLong:
+    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Odd, &m_lambdaTrimOdd));
+    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Even, &m_lambdaTrimEven));
+    break;
+
+  case SampleType_MainVoltage:
+    result = mergeResult(result, c14cux_getMainVoltage(&m_cuxinfo, &m_mainVoltage));
+    break;
+
+  case SampleType_TargetIdleRPM:
+    result = mergeResult(result, c14cux_getTargetIdle(&m_cuxinfo, &m_targetIdleSpeed));
+    result = mergeResult(result, c14cux_getIdleMode(&m_cuxinfo, &m_idleMode));
+    break;
+
+  case SampleType_FuelPumpRelay:
+    result = mergeResult(result, c14cux_getFuelPumpRelayState(&m_cuxinfo, &m_fuelPumpRelayOn));
+    break;
+
+  case SampleType_GearSelection:
+    result = mergeResult(result, c14cux_getGearSelection(&m_cuxinfo, &m_gear));
+    break;
+
+  case SampleType_RoadSpeed:
+    result = mergeResult(result, c14cux_getRoadSpeed(&m_cuxinfo, &m_roadSpeedMPH));
+    break;
+
+  case SampleType_EngineTemperature:
+    result = mergeResult(result, c14cux_getCoolantTemp(&m_cuxinfo, &m_coolantTempF));
+    break;
+
+  case SampleType_FuelTemperature:
+    result = mergeResult(result, c14cux_getFuelTemp(&m_cuxinfo, &m_fuelTempF));
+    break;
+
+  case SampleType_FuelMapData:
+    readFuelMap(m_currentFuelMapIndex);
+    break;
+
+  case SampleType_MIL:
+    // attempt to read the MIL status; if it can't be read, default it to off on the display
+    if (c14cux_isMILOn(&m_cuxinfo, &m_milOn))
+    {
+      result = mergeResult(result, true);
+    }
+    else
+    {
+      result = mergeResult(result, false);
+      m_milOn = false;
+    }
+    break;
+
+  case SampleType_FuelMapIndex:
+    {
+      uint8_t newFuelMapIndex = 0;
+      const bool fuelMapIndexReadResult = c14cux_getCurrentFuelMap(&m_cuxinfo, &newFuelMapIndex);
+      result = mergeResult(result, fuelMapIndexReadResult);
+
+      // do some processing that is only relevant if we successfully read the current map ID
+      if (fuelMapIndexReadResult)
+      {
+        updateFuelMapIndex(newFuelMapIndex);
+      }
+    }
+    break;
+
+  case SampleType_COTrimVoltage:
+    result = mergeResult(result, c14cux_getCOTrimVoltage(&m_cuxinfo, &m_coTrimVoltage));
+    break;
 
-    // If we haven't yet reported the RPM limit, see if we can read it now.
-    // This is a special case because the limit is only read into its RAM
-    // location in the ECU once the main spark interrupt has run; we therefore
-    // wait until the engine speed > 0 before attempting this.
-    if (!m_rpmLimitRead &&
-        (result == ReadResult_Success) &&
-        (m_engineSpeedRPM > 0) &&
-        c14cux_getRPMLimit(&m_cuxinfo, &m_rpmLimit))
-    {
-      m_rpmLimitRead = true;
-      emit rpmLimitReady(m_rpmLimit);
-    }
+  default:
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_FuelMapRowCol))
-  {
-    result = mergeResult(result, c14cux_getFuelMapRowIndex(&m_cuxinfo, &m_currentFuelMapRowIndex, &m_fuelMapRowWeighting));
-    result = mergeResult(result, c14cux_getFuelMapColumnIndex(&m_cuxinfo, &m_currentFuelMapColumnIndex, &m_fuelMapColWeighting));
-  }
+  return result;
+}
 
-  if (isDueForMeasurement(SampleType_InjectorPulseWidth))
+/**
+ * If we haven't yet reported the RPM limit, see if we can read it now. This is
+ * a special case because the limit is only read into its RAM location in the
+ * ECU once the main spark interrupt has run; we therefore wait until the
+ * engine speed > 0 before attempting this.
+ */
+void CUXInterface::checkRPMLimit()
+{
+  if (!m_rpmLimitRead &&
+      (m_engineSpeedRPM > 0) &&
+      c14cux_getRPMLimit(&m_cuxinfo, &m_rpmLimit))
   {
-    result = mergeResult(result, c14cux_getInjectorPulseWidth(&m_cuxinfo, &m_injectorPulseWidthUs));
-    m_injectorPulseWidthMs = (float)m_injectorPulseWidthUs / 1000.0;
+    m_rpmLimitRead = true;
+    emit rpmLimitReady(m_rpmLimit);
   }
+}
 
-  if (isDueForMeasurement(SampleType_IdleBypassPosition))
-  {
-    result = mergeResult(result, c14cux_getIdleBypassMotorPosition(&m_cuxinfo, &m_idleBypassPos));
-  }
+/**
+ * Adds the 14CUX memory locations behind a sample type to the batch for this
+ * pass. Only the readings whose raw values can be decoded without further
+ * reads are batched; the others (and the reading types that need calibration
+ * data, such as corrected throttle position) continue to use the library's
+ * individual calls.
+ * @return True if the sample type will be decoded from the batch
+ */
+bool CUXInterface::addBatchFields(SampleType type)
+{
+  bool batched = true;
 
-  if (isDueForMeasurement(SampleType_LambdaTrimLong))
+  switch (type)
   {
-    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Odd, &m_lambdaTrimOdd));
-    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Even, &m_lambdaTrimEven));
-  }
+  case SampleType_EngineRPM:
+    m_batch.addField(C14CUX_EngineSpeedFilteredOffset, 2);
+    break;
 
-  if (isDueForMeasurement(SampleType_MainVoltage))
-  {
-    result = mergeResult(result, c14cux_getMainVoltage(&m_cuxinfo, &m_mainVoltage));
-  }
+  case SampleType_Throttle:
+    batched = (m_throttlePosType == C14CUX_ThrottlePosType_Absolute);
+    if (batched)
+    {
+      m_batch.addField(C14CUX_ThrottlePositionOffset, 2);
+    }
+    break;
 
-  if (isDueForMeasurement(SampleType_TargetIdleRPM))
-  {
-    result = mergeResult(result, c14cux_getTargetIdle(&m_cuxinfo, &m_targetIdleSpeed));
-    result = mergeResult(result, c14cux_getIdleMode(&m_cuxinfo, &m_idleMode));
-  }
+  case SampleType_MAF:
+    batched = (m_airflowType == C14CUX_AirflowType_Direct);
+    if (batched)
+    {
+      m_batch.addField(C14CUX_MassAirflowDirectOffset, 2);
+    }
+    break;
 
-  if (isDueForMeasurement(SampleType_FuelPumpRelay))
-  {
-    result = mergeResult(result, c14cux_getFuelPumpRelayState(&m_cuxinfo, &m_fuelPumpRelayOn));
-  }
+  case SampleType_FuelMapRowCol:
+    m_batch.addField(C14CUX_FuelMapRowIndexOffset, 1);
+    m_batch.addField(C14CUX_FuelMapColumnIndexOffset, 1);
+    break;
 
-  if (isDueForMeasurement(SampleType_GearSelection))
-  {
-    result = mergeResult(result, c14cux_getGearSelection(&m_cuxinfo, &m_gear));
+  default:
+    batched = false;
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_RoadSpeed))
-  {
-    result = mergeResult(result, c14cux_getRoadSpeed(&m_cuxinfo, &m_roadSpeedMPH));
-  }
+  return batched;
+}
 
-  if (isDueForMeasurement(SampleType_EngineTemperature))
-  {
-    result = mergeResult(result, c14cux_getCoolantTemp(&m_cuxinfo, &m_coolantTempF));
-  }
+/**
+ * Reads each span of the batch from the 14CUX.
+ */
+void CUXInterface::readBatch()
+{
+  m_batch.plan();
 
-  if (isDueForMeasurement(SampleType_FuelTemperature))
+  for (int idx = 0; idx < m_batch.spanCount(); idx++)
   {
-    result = mergeResult(result, c14cux_getFuelTemp(&m_cuxinfo, &m_fuelTempF));
+    m_batch.setSpanValid(idx, c14cux_readMem(&m_cuxinfo, m_batch.spanStart(idx),
+                                             m_batch.spanLength(idx), m_batch.spanBuffer(idx)));
   }
+}
+
+/**
+ * Decodes a sample type from the memory read by readBatch(), in the same way
+ * as the corresponding library call.
+ * @param type Sample type to decode
+ * @param result Result for this sample, updated if the sample was decoded
+ * @return True if the sample was decoded; false if it must be read individually
+ */
+bool CUXInterface::decodeBatchedSample(SampleType type, ReadResult& result)
+{
+  bool decoded = false;
 
-  if (isDueForMeasurement(SampleType_FuelMapData))
+  switch (type)
   {
-    if (readFuelMap(m_currentFuelMapIndex))
+  case SampleType_EngineRPM:
+    if (m_batch.contains(C14CUX_EngineSpeedFilteredOffset, 2))
     {
-      emit fuelMapReady(m_currentFuelMapIndex);
+      // the ECU stores the filtered period between spark events; all ones means stalled
+      const uint16_t period = m_batch.wordAt(C14CUX_EngineSpeedFilteredOffset);
+      m_engineSpeedRPM = ((period == 0) || (period == 0xFFFF)) ? 0 : (uint16_t)(7500000 / period);
+      checkRPMLimit();
+      decoded = true;
     }
-  }
+    break;
 
-  // attempt to read the MIL status; if it can't be read, default it to off on the display
-  if (isDueForMeasurement(SampleType_MIL))
-  {
-    if (c14cux_isMILOn(&m_cuxinfo, &m_milOn))
+  case SampleType_Throttle:
+    if ((m_throttlePosType == C14CUX_ThrottlePosType_Absolute) &&
+        m_batch.contains(C14CUX_ThrottlePositionOffset, 2))
     {
-      result = mergeResult(result, true);
+      // 10-bit ADC count
+      m_throttlePos = (float)m_batch.wordAt(C14CUX_ThrottlePositionOffset) / 1023.0f;
+      decoded = true;
     }
-    else
+    break;
+
+  case SampleType_MAF:
+    if ((m_airflowType == C14CUX_AirflowType_Direct) &&
+        m_batch.contains(C14CUX_MassAirflowDirectOffset, 2))
     {
-      result = mergeResult(result, false);
-      m_milOn = false;
+      m_mafReading = (float)m_batch.wordAt(C14CUX_MassAirflowDirectOffset) / 1023.0f;
+      decoded = true;
     }
-  }
-
-  if (isDueForMeasurement(SampleType_FuelMapIndex))
-  {
-    uint8_t newFuelMapIndex = 0;
-    bool fuelMapIndexReadResult = c14cux_getCurrentFuelMap(&m_cuxinfo, &newFuelMapIndex);
-    result = mergeResult(result, fuelMapIndexReadResult);
+    break;
 
-    // do some processing that is only relevant if we successfully read the current map ID
-    if (fuelMapIndexReadResult)
+  case SampleType_FuelMapRowCol:
+    if (m_batch.contains(C14CUX_FuelMapRowIndexOffset, 1) &&
+        m_batch.contains(C14CUX_FuelMapColumnIndexOffset, 1))
     {
-      // if the fuel map index has changed, or if this is the first time we've read it
-      if ((newFuelMapIndex != m_currentFuelMapIndex) || !m_fuelMapIndexRead)
-      {
-        m_currentFuelMapIndex = newFuelMapIndex;
-        emit fuelMapIndexHasChanged(m_currentFuelMapIndex);
-      }
-
-      // regardless of whether the map has changed, we know now
-      // that is has been read at least once
-      m_fuelMapIndexRead = true;
-
-      // set the current fueling mode (open-loop or closed-loop)
-      c14cux_feedback_mode newFeedbackMode = C14CUX_FeedbackMode_ClosedLoop;
-
-      if ((m_currentFuelMapIndex >= s_firstOpenLoopMap) &&
-          (m_currentFuelMapIndex <= s_lastOpenLoopMap))
-      {
-        newFeedbackMode = C14CUX_FeedbackMode_OpenLoop;
-      }
-
-      // if the feedback mode has changed, emit a signal
-      if (newFeedbackMode != m_feedbackMode)
-      {
-        m_feedbackMode = newFeedbackMode;
-        emit feedbackModeHasChanged(m_feedbackMode);
-      }
+      // the index is in the upper nibble and the weighting in the lower
+      const uint8_t row = m_batch.byteAt(C14CUX_FuelMapRowIndexOffset);
+      const uint8_t col = m_batch.byteAt(C14CUX_FuelMapColumnIndexOffset);
+      m_currentFuelMapRowIndex = row >> 4;
+      m_fuelMapRowWeighting = row & 0x0F;
+      m_currentFuelMapColumnIndex = col >> 4;
+      m_fuelMapColWeighting = col & 0x0F;
+      decoded = true;
     }
+    break;
+
+  default:
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_COTrimVoltage))
+  if (decoded)
   {
-    result = mergeResult(result, c14cux_getCOTrimVoltage(&m_cuxinfo, &m_coTrimVoltage));
+    result = mergeResult(result, true);
   }
 
-  return result;
+  return decoded;
 }
 
-CUXInterface::ReadResult CUXInterface::readSimData()
+/**
+ * Takes a single sample type from the simulated ECU, and stores the data in
+ * member variables. A short sleep stands in for the time spent on the serial link,
+ * and the simulated engine is run forward by the same amount.
+ * @param type Sample type to read
+ * @return Always indicates success
+ */
+CUXInterface::ReadResult CUXInterface::readSimSample(SampleType type)
 {
-  if (isDueForMeasurement(SampleType_MAF))
+  if (type != SampleType_FuelMapData)
   {
-    QThread::currentThread()->msleep(5);
-    m_mafReading = m_simEcu->maf();
+    QThread::currentThread()->msleep(s_simReadTimeMs);
+    m_simEcu->advance(s_simReadTimeMs);
   }
 
-  if (isDueForMeasurement(SampleType_Throttle))
+  switch (type)
   {
-    QThread::currentThread()->msleep(5);
+  case SampleType_MAF:
+    m_mafReading = m_simEcu->maf();
+    break;
+
+  case SampleType_Throttle:
     m_throttlePos = m_simEcu->throttle();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_LambdaTrimShort))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_LambdaTrimShort:
     m_lambdaTrimOdd = m_simEcu->lambdaShortOdd();
     m_lambdaTrimEven = m_simEcu->lambdaShortEven();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_EngineRPM))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_EngineRPM:
     m_engineSpeedRPM = m_simEcu->engineRPM();
     m_rpmLimitRead = true;
     emit rpmLimitReady(m_simEcu->engineRPMLimit());
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_FuelMapRowCol))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_FuelMapRowCol:
     m_simEcu->fuelMapRowColIndices(m_currentFuelMapRowIndex, m_fuelMapRowWeighting,
                                    m_currentFuelMapColumnIndex, m_fuelMapColWeighting);
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_InjectorPulseWidth))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_InjectorPulseWidth:
     m_injectorPulseWidthUs = m_simEcu->injectorPulsewidthUs();
     m_injectorPulseWidthMs = (float)m_injectorPulseWidthUs / 1000.0;
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_IdleBypassPosition))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_IdleBypassPosition:
     m_idleBypassPos = m_simEcu->idleBypassPos();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_LambdaTrimLong))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_LambdaTrimLong:
     m_lambdaTrimOdd = m_simEcu->lambdaLongOdd();
     m_lambdaTrimEven = m_simEcu->lambdaLongEven();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_MainVoltage))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_MainVoltage:
     m_mainVoltage = m_simEcu->mainVoltage();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_TargetIdleRPM))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_TargetIdleRPM:
     m_targetIdleSpeed = m_simEcu->targetIdle();
     m_idleMode = m_simEcu->idleMode();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_FuelPumpRelay))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_FuelPumpRelay:
     m_fuelPumpRelayOn = m_simEcu->fuelPumpRelayState();
-  }
+    break;
 
-  if (isDueForMeasurement(SampleType_GearSelection))
-  {
-    QThread::currentThread()->msleep(5);
+  case SampleType_GearSelection:
     m_gear = (c14cux_gear)m_simEcu->gearSelection();
+    break;
+
+  case SampleType_RoadSpeed:
+    m_roadSpeedMPH = m_simEcu->roadSpeedMPH();
+    break;
+
+  case SampleType_EngineTemperature:
+    m_coolantTempF = m_simEcu->coolantTempF();
+    break;
+
+  case SampleType_FuelTemperature:
+    m_fuelTempF = m_simEcu->fuelTempF();
+    break;
+
+  case SampleType_FuelMapData:
+    readFuelMap(m_currentFuelMapIndex);
+    break;
+
+  case SampleType_MIL:
+    m_milOn = m_simEcu->mil();
+    break;
+
+  case SampleType_FuelMapIndex:
+    updateFuelMapIndex(m_simEcu->currentFuelMap());
+    break;
+
+  case SampleType_COTrimVoltage:
+    m_coTrimVoltage = m_simEcu->coTrimVoltage();
+    break;
+
+  default:
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_RoadSpeed))
+  return CUXInterface::ReadResult_Success;
+}
+
+/**
+ * Records a newly-read fuel map index, and derives the fueling feedback mode
+ * (open- or closed-loop) from it. Signals are emitted if either has changed.
+ * @param newFuelMapIndex Fuel map index just read from the ECU
+ */
+void CUXInterface::updateFuelMapIndex(uint8_t newFuelMapIndex)
+{
+  // if the fuel map index has changed, or if this is the first time we've read it
+  if ((newFuelMapIndex != m_currentFuelMapIndex) || !m_fuelMapIndexRead)
   {
-    QThread::currentThread()->msleep(5);
-    m_roadSpeedMPH = m_simEcu->roadSpeedMPH();
+    m_currentFuelMapIndex = newFuelMapIndex;
+    emit fuelMapIndexHasChanged(m_currentFuelMapIndex);
   }
 
-  if (isDueForMeasurement(SampleType_EngineTemperature))
+  // regardless of whether the map has changed, we know now
+  // that is has been read at least once
+  m_fuelMapIndexRead = true;
+
+  // set the current fueling mode (open-loop or closed-loop)
+  c14cux_feedback_mode newFeedbackMode = C14CUX_FeedbackMode_ClosedLoop;
+
+  if ((m_currentFuelMapIndex >= s_firstOpenLoopMap) &&
+      (m_currentFuelMapIndex <= s_lastOpenLoopMap))
   {
-    QThread::currentThread()->msleep(5);
-    m_coolantTempF = m_simEcu->coolantTempF();
+    newFeedbackMode = C14CUX_FeedbackMode_OpenLoop;
   }
 
-  if (isDueForMeasurement(SampleType_FuelTemperature))
+  // if the feedback mode has changed, emit a signal
+  if (newFeedbackMode != m_feedbackMode)
   {
-    QThread::currentThread()->msleep(5);
-    m_fuelTempF = m_simEcu->fuelTempF();
+    m_feedbackMode = newFeedbackMode;
+    emit feedbackModeHasChanged(m_feedbackMode);
   }
+}
+
+/**
+ * Captures the current set of readings as a single frame and publishes it to
+ * the consumer (GUI) thread. If the consumer has fallen too far behind, the
+ * frame is dropped rather than stalling the polling loop.
+ */
+void CUXInterface::publishFrame()
+{
+  TelemetryFrame frame;
+
+  frame.timestampMs = QDateTime::currentMSecsSinceEpoch();
+  frame.monotonicMs = m_scheduler.now();
+  frame.roadSpeed = getRoadSpeed();
+  frame.engineSpeedRPM = m_engineSpeedRPM;
+  frame.targetIdleSpeed = m_targetIdleSpeed;
+  frame.idleMode = m_idleMode;
+  frame.coolantTemp = getCoolantTemp();
+  frame.fuelTemp = getFuelTemp();
+  frame.throttlePos = m_throttlePos;
+  frame.mafReading = m_mafReading;
+  frame.idleBypassPos = m_idleBypassPos;
+  frame.mainVoltage = m_mainVoltage;
+  frame.coTrimVoltage = m_coTrimVoltage;
+  frame.injectorPulseWidthMs = m_injectorPulseWidthMs;
+  frame.lambdaTrimOdd = m_lambdaTrimOdd;
+  frame.lambdaTrimEven = m_lambdaTrimEven;
+  frame.lambdaTrimType = m_lambdaTrimType;
+  frame.gear = m_gear;
+  frame.feedbackMode = m_feedbackMode;
+  frame.currentFuelMapIndex = m_currentFuelMapIndex;
+  frame.fuelMapRowIndex = m_currentFuelMapRowIndex;
+  frame.fuelMapRowWeighting = m_fuelMapRowWeighting;
+  frame.fuelMapColumnIndex = m_currentFuelMapColumnIndex;
+  frame.fuelMapColumnWeighting = m_fuelMapColWeighting;
+  frame.fuelPumpRelayOn = m_fuelPumpRelayOn;
+  frame.milOn = m_milOn;
+
+  m_frames.push(frame);
+}
 
-  if (isDueForMeasurement(SampleType_FuelMapData))
+/**
+ * Tells the consumer that frames are waiting, unless it has already been told
+ * and hasn't yet started taking them. At high link rates this keeps the
+ * consumer's event queue from filling with notifications that it would find
+ * nothing left to take for.
+ */
+void CUXInterface::notifyDataReady()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!m_dataReadyPending.exchange(true))
   {
-    if (readFuelMap(m_currentFuelMapIndex))
-    {
-      emit fuelMapReady(m_currentFuelMapIndex);
-    }
+    emit dataReady();
   }
+}
 
-  // attempt to read the MIL status; if it can't be read, default it to off on the display
-  if (isDueForMeasurement(SampleType_MIL))
+/**
+ * Publishes the frames from the log being replayed whose (scaled) recording
+ * time has arrived. The replay clock is anchored to the first frame published
+ * after a connection, seek, or speed change, so the recorded cadence is kept
+ * regardless of how long each pass takes.
+ * @return Milliseconds until the next frame is due
+ */
+qint64 CUXInterface::runReplayPass()
+{
+  const qint64 now = m_scheduler.now();
+  const qint64 seekTo = m_replaySeekMs.exchange(-1);
+  const unsigned int speed = m_replaySpeed;
+  qint64 wait = 0;
+  int published = 0;
+
+  if (seekTo >= 0)
   {
-    QThread::currentThread()->msleep(5);
-    m_milOn = m_simEcu->mil();
+    m_replay->seek(m_replay->firstTimestampMs() + seekTo);
+    m_replayHavePending = false;
+    m_replayClockSet = false;
   }
 
-  if (isDueForMeasurement(SampleType_FuelMapIndex))
+  if (speed != m_replayAnchorSpeed)
   {
-    QThread::currentThread()->msleep(5);
-    uint8_t newFuelMapIndex = m_simEcu->currentFuelMap();
+    m_replayClockSet = false;
+  }
 
-    // if the fuel map index has changed, or if this is the first time we've read it
-    if ((newFuelMapIndex != m_currentFuelMapIndex) || !m_fuelMapIndexRead)
+  while (published < s_replayBatchSize)
+  {
+    if (!m_replayHavePending)
     {
-      m_currentFuelMapIndex = newFuelMapIndex;
-      emit fuelMapIndexHasChanged(m_currentFuelMapIndex);
+      if (!m_replay->next(m_replayPending))
+      {
+        // the end of the log is treated like the ECU going away
+        m_stopPolling = true;
+        break;
+      }
+      m_replayHavePending = true;
     }
 
-    // regardless of whether the map has changed, we know now
-    // that is has been read at least once
-    m_fuelMapIndexRead = true;
-
-    // set the current fueling mode (open-loop or closed-loop)
-    c14cux_feedback_mode newFeedbackMode = C14CUX_FeedbackMode_ClosedLoop;
-
-    if ((m_currentFuelMapIndex >= s_firstOpenLoopMap) &&
-        (m_currentFuelMapIndex <= s_lastOpenLoopMap))
+    if (!m_replayClockSet)
     {
-      newFeedbackMode = C14CUX_FeedbackMode_OpenLoop;
+      m_replayAnchorLogMs = m_replayPending.timestampMs;
+      m_replayAnchorMonoMs = now;
+      m_replayAnchorSpeed = speed;
+      m_replayClockSet = true;
     }
 
-    // if the feedback mode has changed, emit a signal
-    if (newFeedbackMode != m_feedbackMode)
+    if (speed > 0)
+    {
+      const qint64 dueAt = m_replayAnchorMonoMs + ((m_replayPending.timestampMs - m_replayAnchorLogMs) / speed);
+      if (dueAt > now)
+      {
+        wait = dueAt - now;
+        break;
+      }
+    }
+    else if (m_frames.size() >= (telemetryRingSize / 2))
     {
-      m_feedbackMode = newFeedbackMode;
-      emit feedbackModeHasChanged(m_feedbackMode);
+      // When replaying as fast as possible, let the consumer catch up
+      // rather than overrunning the ring and dropping frames.
+      wait = 1;
+      break;
     }
+
+    publishReplayFrame(m_replayPending);
+    m_replayHavePending = false;
+    published++;
   }
 
-  if (isDueForMeasurement(SampleType_COTrimVoltage))
+  if (published > 0)
   {
-    QThread::currentThread()->msleep(5);
-    m_coTrimVoltage = m_simEcu->coTrimVoltage();
+    emit readSuccess();
+    notifyDataReady();
   }
 
-  return CUXInterface::ReadResult_Success;
+  return wait;
+}
+
+/**
+ * Publishes a frame from the log being replayed, updating the stored readings
+ * that are also available through the getters. Values are published in the
+ * units in which they were logged.
+ */
+void CUXInterface::publishReplayFrame(TelemetryFrame& frame)
+{
+  updateFuelMapIndex(frame.currentFuelMapIndex);
+
+  m_currentFuelMapRowIndex = frame.fuelMapRowIndex;
+  m_fuelMapRowWeighting = frame.fuelMapRowWeighting;
+  m_currentFuelMapColumnIndex = frame.fuelMapColumnIndex;
+  m_fuelMapColWeighting = frame.fuelMapColumnWeighting;
+  m_engineSpeedRPM = frame.engineSpeedRPM;
+  m_throttlePos = frame.throttlePos;
+  m_mafReading = frame.mafReading;
+
+  frame.monotonicMs = m_scheduler.now();
+  frame.feedbackMode = m_feedbackMode;
+  m_frames.push(frame);
 }
 
 /**
@@ -1010,9 +1967,13 @@ void CUXInterface::setEnabledSamples(QMap<SampleType, bool> samples)
   foreach(SampleType field, samples.keys())
   {
     m_enabledSamples[field] = samples[field];
+    m_scheduler.setEnabled(field, samples[field]);
   }
 
   zeroDisabledSamples();
+
+  // a newly-enabled sample is due immediately
+  wakeServiceLoop();
 }
 
 /**
@@ -1102,14 +2063,133 @@ void CUXInterface::zeroDisabledSamples()
   }
 }
 
+/**
+ * Returns the current link statistics, combined with the achieved read rates
+ * and deadline misses kept by the rate controller and scheduler. May be
+ * called from any thread.
+ */
+LinkStatisticsSnapshot CUXInterface::getLinkStatistics() const
+{
+  LinkStatisticsSnapshot stats = m_linkStats.snapshot();
+  const qint64 now = m_scheduler.now();
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    stats.channels[type].rateHz = m_rates.getAchievedRate((SampleType)type, now);
+    stats.channels[type].deadlineMisses = m_scheduler.getDeadlineMissCount((SampleType)type);
+    stats.channels[type].maxLatenessMs = m_scheduler.getMaxLatenessMs((SampleType)type);
+  }
+  stats.droppedFrames = m_frames.droppedCount();
+
+  return stats;
+}
+
+/**
+ * Clears the link statistics.
+ */
+void CUXInterface::resetLinkStatistics()
+{
+  m_linkStats.reset();
+}
+
 /**
  * Updates the list of intervals at which the various sensor values should be read
  */
 void CUXInterface::setReadIntervals(QHash<SampleType, unsigned int> intervals)
 {
+  const bool adaptive = m_rates.isEnabled();
+
+  m_baseIntervals = intervals;
   foreach(SampleType field, intervals.keys())
   {
-    m_readIntervals[field] = intervals[field];
+    // the intervals of adaptively-scheduled samples are left to the rate controller
+    if (!adaptive || !m_rateLimits.contains(field))
+    {
+      m_scheduler.setInterval(field, intervals[field]);
+    }
+  }
+}
+
+/**
+ * Switches between the fixed read intervals and adaptive scheduling, in which
+ * the intervals follow how quickly each reading is changing (within the
+ * limits set with setRateLimits().)
+ */
+void CUXInterface::setAdaptiveRates(bool enabled)
+{
+  m_rates.setEnabled(enabled);
+
+  if (!enabled)
+  {
+    setReadIntervals(m_baseIntervals);
+  }
+}
+
+/**
+ * Sets the floor and ceiling read rates for the samples that may be scheduled
+ * adaptively.
+ */
+void CUXInterface::setRateLimits(const QHash<SampleType, SampleRateLimits>& limits)
+{
+  m_rateLimits = limits;
+  m_rates.setLimits(limits);
+}
+
+/**
+ * Returns the current value of a sample type as a fraction of its full scale,
+ * which lets the rate controller compare how quickly different readings change.
+ */
+float CUXInterface::sampleLevel(SampleType type) const
+{
+  float level = 0.0f;
+
+  switch (type)
+  {
+  case SampleType_EngineRPM:
+    level = m_engineSpeedRPM / 8000.0f;
+    break;
+  case SampleType_MAF:
+    level = m_mafReading;
+    break;
+  case SampleType_Throttle:
+    level = m_throttlePos;
+    break;
+  case SampleType_IdleBypassPosition:
+    level = m_idleBypassPos;
+    break;
+  case SampleType_FuelMapRowCol:
+    level = (((m_currentFuelMapRowIndex * 16) + m_fuelMapRowWeighting) / 128.0f) +
+            (((m_currentFuelMapColumnIndex * 16) + m_fuelMapColWeighting) / 256.0f);
+    break;
+  case SampleType_InjectorPulseWidth:
+    level = m_injectorPulseWidthMs / 20.0f;
+    break;
+  case SampleType_LambdaTrimShort:
+  case SampleType_LambdaTrimLong:
+    level = (m_lambdaTrimOdd + m_lambdaTrimEven) / 512.0f;
+    break;
+  case SampleType_RoadSpeed:
+    level = m_roadSpeedMPH / 150.0f;
+    break;
+  case SampleType_MainVoltage:
+    level = m_mainVoltage / 18.0f;
+    break;
+  case SampleType_TargetIdleRPM:
+    level = m_targetIdleSpeed / 2000.0f;
+    break;
+  case SampleType_COTrimVoltage:
+    level = m_coTrimVoltage / 5.0f;
+    break;
+  case SampleType_EngineTemperature:
+    level = m_coolantTempF / 300.0f;
+    break;
+  case SampleType_FuelTemperature:
+    level = m_fuelTempF / 300.0f;
+    break;
+  default:
+    break;
   }
+
+  return level;
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <utility>
 #include <QMutex>
 #include <QObject>
@@ -7,11 +8,24 @@
 #include <QHash>
 #include <QByteArray>
 #include <QMap>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "comm14cux.h"
 #include "commonunits.h"
+#include "adaptiverate.h"
+#include "linkstatistics.h"
+#include "samplescheduler.h"
 #include "simulatedecudata.h"
+#include "logreplaysource.h"
+#include "rambatch.h"
+#include "romimagecache.h"
+#include "fuelmapcache.h"
+#include "spscring.h"
+#include "telemetryframe.h"
 
 static const unsigned int fuelMapCount = 6;
+static const unsigned int telemetryRingSize = 256;
 
 class CUXInterface : public QObject
 {
@@ -22,6 +36,17 @@ class CUXInterface : public QObject
     ReadResult_NoStatement
   };
 
+  // Queued requests are serviced in this order. Actuator commands are short
+  // and time-sensitive; one-shot reads take up to a few hundred ms; bulk
+  // transfers are split into chunks so that the periodic readings continue.
+  enum RequestClass
+  {
+    RequestClass_Actuator,
+    RequestClass_OneShot,
+    RequestClass_Bulk,
+    RequestClass_NumClasses
+  };
+
   Q_OBJECT
 public:
   explicit CUXInterface(QString device,
@@ -58,8 +83,15 @@ public:
     m_throttlePosType = type;
   }
 
+  void setBatchedReads(bool enabled)
+  {
+    m_batchedReads = enabled;
+  }
+
   void setEnabledSamples(QMap<SampleType, bool> samples);
   void setReadIntervals(QHash<SampleType, unsigned int> intervals);
+  void setAdaptiveRates(bool enabled);
+  void setRateLimits(const QHash<SampleType, SampleRateLimits>& limits);
   void enqueueRequest(QueueableRequest req);
   void enqueueRequest(QueueableRequest req, int data);
 
@@ -185,6 +217,16 @@ public:
     return m_romImage;
   }
 
+  static int getROMImageSize()
+  {
+    return s_romImageBytes;
+  }
+
+  int getROMImageBytesRead() const
+  {
+    return m_romReadOffset;
+  }
+
   int getLambdaTrimOdd() const
   {
     return m_lambdaTrimOdd;
@@ -255,6 +297,61 @@ public:
     m_fuelMapRefresh = on;
   }
 
+  /**
+   * Takes the oldest published frame. Taking a frame (or trying to) rearms the
+   * dataReady signal, so that it is emitted once for each batch of frames that
+   * arrives while the consumer is busy, rather than once for every frame.
+   */
+  bool takeFrame(TelemetryFrame& frame)
+  {
+    m_dataReadyPending.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_frames.pop(frame);
+  }
+
+  unsigned int getDroppedFrameCount() const
+  {
+    return m_frames.droppedCount();
+  }
+
+  unsigned int getDeadlineMissCount(SampleType type) const
+  {
+    return m_scheduler.getDeadlineMissCount(type);
+  }
+
+  unsigned int getTotalDeadlineMisses() const
+  {
+    return m_scheduler.getTotalDeadlineMisses();
+  }
+
+  float getAchievedRate(SampleType type) const
+  {
+    return m_rates.getAchievedRate(type, m_scheduler.now());
+  }
+
+  void setStatisticsReportPath(const QString& path)
+  {
+    m_linkStats.setReportPath(path);
+  }
+
+  QString getStatisticsReportPath() const
+  {
+    return m_linkStats.reportPath();
+  }
+
+  LinkStatisticsSnapshot getLinkStatistics() const;
+  void resetLinkStatistics();
+
+  void setSimulationSeed(uint32_t seed);
+  void setReplaySource(LogReplaySource* source, unsigned int speed, qint64 startOffsetMs);
+  void setReplaySpeed(unsigned int speed);
+  void seekReplay(qint64 offsetMs);
+
+  bool isReplaying() const
+  {
+    return (m_replay != nullptr);
+  }
+
   void cancelRead();
 
   static unsigned int getBaudRate(bool doubled)
@@ -267,6 +364,10 @@ public slots:
   void onStartPollingRequest();
   void onShutdownThreadRequest();
 
+private slots:
+  void onServiceWake();
+  void runServicePass();
+
 signals:
   void dataReady();
   void connected();
@@ -285,34 +386,81 @@ signals:
   void rpmTableReady();
   void revisionNumberReady(int tuneRevisionNum, int checksumfixer, int ident);
   void romImageReady();
+  void romImageProgress(int bytesRead, int totalBytes, RomReadStage stage);
   void romImageReadFailed();
   void failedToConnect(QString dev);
   void interfaceReadyForPolling();
   void notConnected();
   void fuelMapIndexHasChanged(unsigned int fuelMapId);
   void feedbackModeHasChanged(c14cux_feedback_mode newMode);
+  void serviceWakeRequested();
 
 private:
   static const int s_firstOpenLoopMap = 1;
   static const int s_lastOpenLoopMap = 3;
+  static const qint64 s_passBudgetMs = 100;
+  static const int s_replayBatchSize = 64;
+  static const uint16_t s_romBaseAddress = 0xC000;
+  static const int s_romImageBytes = 16384;
+  static const int s_romChunkBytes = 64;
+  static const int s_romChunkRetries = 3;
+  static const int s_romVerifyPasses = 2;
+  static const int s_romSampleBlocks = 16;
+  static const qint64 s_prefetchMaxDeferMs = 10000;
+  static const int s_prefetchMaxFailures = 6;
+  static const unsigned int s_simReadTimeMs = 5;
 
   const bool m_sim;
   bool m_simConnected = false;
   SimulatedECUData* m_simEcu = nullptr;
+  LogReplaySource* m_replay = nullptr;
+  qint64 m_replayStartOffsetMs = 0;
+  std::atomic<unsigned int> m_replaySpeed{1};
+  std::atomic<qint64> m_replaySeekMs{-1};
+  bool m_replayClockSet = false;
+  qint64 m_replayAnchorLogMs = 0;
+  qint64 m_replayAnchorMonoMs = 0;
+  unsigned int m_replayAnchorSpeed = 1;
+  bool m_replayHavePending = false;
+  TelemetryFrame m_replayPending;
   QMutex m_queueMutex;
-  QQueue<std::pair<QueueableRequest, int> > m_reqQueue;
+  QQueue<std::pair<QueueableRequest, int> > m_reqQueues[RequestClass_NumClasses];
+  bool m_romReadActive = false;
+  std::atomic<int> m_romReadOffset{0};
+  int m_romVerifyPass = 0;
+  int m_romVerifyOffset = 0;
+  bool m_romVerifyMismatch = false;
+  int m_romChunkFailures = 0;
+  bool m_romSampling = false;
+  QVector<int> m_romSampleOffsets;
+  int m_romSampleIndex = 0;
+  RomImageCache m_romCache;
+  FuelMapCache m_fuelMapCache;
 
   QString m_deviceName;
   unsigned int m_baudRate;
   c14cux_info m_cuxinfo;
-  bool m_stopPolling = false;
+  std::atomic<bool> m_stopPolling{false};
   bool m_shutdownThread = false;
+  bool m_polling = false;
+  std::atomic<bool> m_wakePending{false};
+  std::atomic<bool> m_dataReadyPending{false};
+  QTimer* m_serviceTimer = nullptr;
   c14cux_faultcodes m_faultCodes;
   QByteArray m_batteryBackedMem;
-  bool m_readCanceled = false;
+  std::atomic<bool> m_readCanceled{false};
   QHash<SampleType, bool> m_enabledSamples;
-  QHash<SampleType, qint64> m_lastReadTime;
-  QHash<SampleType, unsigned int> m_readIntervals;
+  SampleScheduler m_scheduler;
+  QVector<SampleType> m_dueSamples;
+  RamBatch m_batch;
+  bool m_batchedReads = true;
+  AdaptiveRateController m_rates;
+  QHash<SampleType, unsigned int> m_baseIntervals;
+  QHash<SampleType, SampleRateLimits> m_rateLimits;
+  QHash<SampleType, unsigned int> m_adaptedIntervals;
+  QElapsedTimer m_readTimer;
+  LinkStatistics m_linkStats;
+  SpscRing<TelemetryFrame, telemetryRingSize> m_frames;
 
   c14cux_lambda_trim_type m_lambdaTrimType = C14CUX_LambdaTrimType_ShortTerm;
   c14cux_feedback_mode m_feedbackMode = C14CUX_FeedbackMode_ClosedLoop;
@@ -363,27 +511,60 @@ private:
 
   bool m_initComplete = false;
   bool m_rpmLimitRead = false;
+  bool m_tuneRevRead = false;
+  bool m_rpmTableRead = false;
+  qint64 m_lastPrefetchMs = 0;
+  float m_prefetchCostMs = 0.0f;
+  int m_prefetchFailures = 0;
 
   void zeroDisabledSamples();
-  void runServiceLoop();
+  void wakeServiceLoop();
+  void stopServiceLoop(bool connected);
   void clearFlagsAndData();
   ReadResult readData();
-  ReadResult readSimData();
+  ReadResult readSample(SampleType type);
+  bool addBatchFields(SampleType type);
+  void readBatch();
+  bool decodeBatchedSample(SampleType type, ReadResult& result);
+  void checkRPMLimit();
+  float sampleLevel(SampleType type) const;
+  ReadResult readSimSample(SampleType type);
+  void updateFuelMapIndex(uint8_t newFuelMapIndex);
+  void publishFrame();
+  void notifyDataReady();
+  qint64 runReplayPass();
+  void publishReplayFrame(TelemetryFrame& frame);
   bool connectToECU();
   unsigned int convertSpeed(unsigned int speedMph) const;
   int convertTemperature(int tempF) const;
   static ReadResult mergeResult(ReadResult total, ReadResult single);
   static ReadResult mergeResult(ReadResult total, bool single);
-  bool isDueForMeasurement(SampleType type);
   bool isSampleAppropriateForMode(SampleType type) const;
-  void processQueuedRequest();
+  static RequestClass requestClass(QueueableRequest req);
+  int queuedRequestCount() const;
+  bool hasQueuedRequest();
+  bool takeQueuedRequest(bool includeBulk, std::pair<QueueableRequest, int>& req);
+  void processQueuedRequest(const std::pair<QueueableRequest, int>& req);
+  void serviceQueuedRequests();
+  void startROMImage();
+  bool startROMComparison();
+  void readROMChunk();
+  void readROMSample();
+  bool readROMBlock(int offset, int length, uint8_t* buffer);
+  void finishROMPass();
+  void completeROMImage();
+  void abortROMImage();
+  static bool isROMChecksumValid(const QByteArray& image);
   void readFaultCodes();
   void clearFaultCodes();
-  bool readFuelMap(unsigned int fuelMapId);
-  void readROMImage();
+  bool readFuelMap(unsigned int fuelMapId, bool announce = true);
+  bool isPrefetchPending() const;
+  void prefetchFuelData();
   void runFuelPump();
   void driveIACMotor(int steps);
   void readRPMTable();
+  bool readTuneIdentity();
+  void loadCachedFuelMaps();
   void readTuneRevID();
   void readBatteryBackedMem();
 };
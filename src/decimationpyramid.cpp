@@ -0,0 +1,139 @@
+#include "decimationpyramid.h"
+
+/**
+ * Discards all of the samples.
+ */
+void DecimationPyramid::clear()
+{
+  m_samples.clear();
+  m_levels.clear();
+}
+
+/**
+ * Reserves space for the given number of samples, so that loading a long
+ * series doesn't repeatedly grow the storage.
+ */
+void DecimationPyramid::reserve(int count)
+{
+  m_samples.reserve(count);
+}
+
+/**
+ * Adds a sample to the end of the series, and folds it into the summary
+ * entries that cover it. The last entry of each level may cover fewer than
+ * s_fanOut entries of the level below until more samples arrive.
+ */
+void DecimationPyramid::append(float value)
+{
+  int index = m_samples.size();
+  int childCount = index + 1;
+
+  m_samples.append(value);
+
+  for (int level = 0; childCount > 1; level++)
+  {
+    index /= s_fanOut;
+    childCount = (childCount + s_fanOut - 1) / s_fanOut;
+
+    if (m_levels.size() <= level)
+    {
+      // a new level starts once the level below has a second entry, and its
+      // first entry covers both of them
+      const MinMax first = entryAt(level - 1, 0);
+      const MinMax second = entryAt(level - 1, 1);
+      m_levels.append(QVector<MinMax>());
+      m_levels[level].append({ qMin(first.min, second.min), qMax(first.max, second.max) });
+    }
+    else if (m_levels[level].size() <= index)
+    {
+      m_levels[level].append({ value, value });
+    }
+    else
+    {
+      MinMax& entry = m_levels[level][index];
+      entry.min = qMin(entry.min, value);
+      entry.max = qMax(entry.max, value);
+    }
+  }
+}
+
+/**
+ * Discards the oldest samples. The positions of the summary entries all
+ * shift, so the summaries are rebuilt from the samples that remain; callers
+ * should trim in large steps rather than one sample at a time.
+ */
+void DecimationPyramid::removeFirst(int count)
+{
+  const QVector<float> remaining = m_samples.mid(qMin(count, m_samples.size()));
+
+  clear();
+  reserve(remaining.size());
+  for (float value : remaining)
+  {
+    append(value);
+  }
+}
+
+/**
+ * Returns an entry of the given summary level, where level -1 stands for the
+ * samples themselves.
+ */
+DecimationPyramid::MinMax DecimationPyramid::entryAt(int level, int index) const
+{
+  if (level < 0)
+  {
+    const float sample = m_samples.at(index);
+    return { sample, sample };
+  }
+
+  return m_levels.at(level).at(index);
+}
+
+/**
+ * Finds the lowest and highest samples in a range of positions. Starting at
+ * the samples themselves, the entries at either end of the range that don't
+ * fill a whole entry of the next level up are taken individually, and the
+ * remainder of the range is handed up to the next level.
+ * @param from Position of the first sample in the range
+ * @param to Position just past the last sample in the range
+ * @param min Lowered to the smallest sample in the range
+ * @param max Raised to the largest sample in the range
+ * @return True if the range held any samples, false otherwise
+ */
+bool DecimationPyramid::range(int from, int to, float& min, float& max) const
+{
+  from = qMax(from, 0);
+  to = qMin(to, m_samples.size());
+
+  if (from >= to)
+  {
+    return false;
+  }
+
+  int level = -1;
+
+  while (from < to)
+  {
+    while ((from < to) && (((from % s_fanOut) != 0) || (level + 1 >= m_levels.size())))
+    {
+      const MinMax entry = entryAt(level, from);
+      min = qMin(min, entry.min);
+      max = qMax(max, entry.max);
+      from++;
+    }
+
+    while ((from < to) && ((to % s_fanOut) != 0))
+    {
+      to--;
+      const MinMax entry = entryAt(level, to);
+      min = qMin(min, entry.min);
+      max = qMax(max, entry.max);
+    }
+
+    from /= s_fanOut;
+    to /= s_fanOut;
+    level++;
+  }
+
+  return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <QVector>
+
+/**
+ * Min/max summary of a series of samples, for plotting a series far longer
+ * than the plot is wide. Level 0 holds the samples themselves; every level
+ * above it holds the lowest and highest value of each run of s_fanOut
+ * entries of the level below. The lowest and highest values over any range
+ * of samples can then be found by combining at most a few entries from each
+ * level, however long the range is.
+ *
+ * Samples are addressed by their position in the series; mapping a span of
+ * time to a range of positions is left to the owner, since several series
+ * recorded together can share one set of timestamps.
+ */
+class DecimationPyramid
+{
+public:
+  void clear();
+  void reserve(int count);
+  void append(float value);
+  void removeFirst(int count);
+  int size() const
+  {
+    return m_samples.size();
+  }
+
+  float at(int index) const
+  {
+    return m_samples.at(index);
+  }
+
+  bool range(int from, int to, float& min, float& max) const;
+
+private:
+  struct MinMax
+  {
+    float min;
+    float max;
+  };
+
+  static const int s_fanOut = 8;
+
+  QVector<float> m_samples;
+  QVector<QVector<MinMax>> m_levels;
+
+  MinMax entryAt(int level, int index) const;
+};
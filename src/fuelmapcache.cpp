@@ -0,0 +1,142 @@
+#include <string.h>
+#include <QDir>
+#include <QSettings>
+#include "fuelmapcache.h"
+#include "romimagecache.h"
+
+/**
+ * Constructor. The maps are kept with the cached ROM images.
+ */
+FuelMapCache::FuelMapCache() :
+  m_dir(RomImageCache::defaultDirectory())
+{
+}
+
+QString FuelMapCache::filePath() const
+{
+  return m_dir + QDir::separator() + "fuelmaps.ini";
+}
+
+/**
+ * Looks up a fuel map read previously from the ECU with the given key.
+ * @param key Key returned by RomImageCache::keyFor()
+ * @param fuelMapId ID of the fuel map (0 through 5)
+ * @return True if the map was found, false otherwise
+ */
+bool FuelMapCache::loadMap(const QString& key, unsigned int fuelMapId,
+                           QByteArray& data, uint16_t& adjFactor, uint8_t& rowScaler) const
+{
+  QSettings cache(filePath(), QSettings::IniFormat);
+  cache.beginGroup(key);
+
+  const QByteArray map = cache.value(QString("Map%1").arg(fuelMapId)).toByteArray();
+  const bool status = (map.size() == 128) && cache.contains(QString("AdjFactor%1").arg(fuelMapId));
+
+  if (status)
+  {
+    data = map;
+    adjFactor = cache.value(QString("AdjFactor%1").arg(fuelMapId)).toUInt();
+    rowScaler = cache.value(QString("RowScaler%1").arg(fuelMapId)).toUInt();
+  }
+
+  return status;
+}
+
+/**
+ * Looks up the MAF row scaler read previously from the ECU with the given key.
+ */
+bool FuelMapCache::loadMAFScaler(const QString& key, uint16_t& mafScaler) const
+{
+  QSettings cache(filePath(), QSettings::IniFormat);
+  const QString name = key + "/MAFScaler";
+  const bool status = cache.contains(name);
+
+  if (status)
+  {
+    mafScaler = cache.value(name).toUInt();
+  }
+
+  return status;
+}
+
+/**
+ * Looks up the RPM table read previously from the ECU with the given key.
+ */
+bool FuelMapCache::loadRPMTable(const QString& key, c14cux_rpmtable& table) const
+{
+  QSettings cache(filePath(), QSettings::IniFormat);
+  const QByteArray bytes = cache.value(key + "/RPMTable").toByteArray();
+  const bool status = (bytes.size() == (int)sizeof(table));
+
+  if (status)
+  {
+    memcpy(&table, bytes.constData(), sizeof(table));
+  }
+
+  return status;
+}
+
+/**
+ * Saves a fuel map along with its adjustment factor and row scaler, and the
+ * ECU's MAF row scaler. Nothing is written if the cache already holds the
+ * same values, so that periodic refreshes of the map don't rewrite the file.
+ * @return True if the cache holds the given values afterwards
+ */
+bool FuelMapCache::storeMap(const QString& key, unsigned int fuelMapId,
+                            const QByteArray& data, uint16_t adjFactor, uint8_t rowScaler, uint16_t mafScaler)
+{
+  QByteArray cachedData;
+  uint16_t cachedAdjFactor = 0;
+  uint8_t cachedRowScaler = 0;
+  uint16_t cachedMAFScaler = 0;
+
+  if (loadMap(key, fuelMapId, cachedData, cachedAdjFactor, cachedRowScaler) &&
+      loadMAFScaler(key, cachedMAFScaler) &&
+      (cachedData == data) && (cachedAdjFactor == adjFactor) &&
+      (cachedRowScaler == rowScaler) && (cachedMAFScaler == mafScaler))
+  {
+    return true;
+  }
+
+  if (!QDir().mkpath(m_dir))
+  {
+    return false;
+  }
+
+  QSettings cache(filePath(), QSettings::IniFormat);
+  cache.beginGroup(key);
+  cache.setValue(QString("Map%1").arg(fuelMapId), data);
+  cache.setValue(QString("AdjFactor%1").arg(fuelMapId), adjFactor);
+  cache.setValue(QString("RowScaler%1").arg(fuelMapId), rowScaler);
+  cache.setValue("MAFScaler", mafScaler);
+  cache.endGroup();
+  cache.sync();
+
+  return (cache.status() == QSettings::NoError);
+}
+
+/**
+ * Saves the RPM table that labels the columns of the fuel maps.
+ * @return True if the cache holds the given table afterwards
+ */
+bool FuelMapCache::storeRPMTable(const QString& key, const c14cux_rpmtable& table)
+{
+  const QByteArray bytes(reinterpret_cast<const char*>(&table), sizeof(table));
+  c14cux_rpmtable cached;
+
+  if (loadRPMTable(key, cached) && (memcmp(&cached, &table, sizeof(table)) == 0))
+  {
+    return true;
+  }
+
+  if (!QDir().mkpath(m_dir))
+  {
+    return false;
+  }
+
+  QSettings cache(filePath(), QSettings::IniFormat);
+  cache.setValue(key + "/RPMTable", bytes);
+  cache.sync();
+
+  return (cache.status() == QSettings::NoError);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <QString>
+#include <QByteArray>
+#include "comm14cux.h"
+
+/**
+ * A local store of the fuel maps and related tables read from each ECU. The
+ * maps live in ROM, so the tune number, checksum fixer, and ident that identify
+ * the ROM also identify its maps; once those values have been read (a few
+ * bytes), any maps seen before can be shown without reading them again.
+ */
+class FuelMapCache
+{
+public:
+  FuelMapCache();
+
+  void setDirectory(const QString& dir)
+  {
+    m_dir = dir;
+  }
+
+  QString directory() const
+  {
+    return m_dir;
+  }
+
+  bool loadMap(const QString& key, unsigned int fuelMapId,
+               QByteArray& data, uint16_t& adjFactor, uint8_t& rowScaler) const;
+  bool loadMAFScaler(const QString& key, uint16_t& mafScaler) const;
+  bool loadRPMTable(const QString& key, c14cux_rpmtable& table) const;
+
+  bool storeMap(const QString& key, unsigned int fuelMapId,
+                const QByteArray& data, uint16_t adjFactor, uint8_t rowScaler, uint16_t mafScaler);
+  bool storeRPMTable(const QString& key, const c14cux_rpmtable& table);
+
+private:
+  QString m_dir;
+
+  QString filePath() const;
+};
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+#include <QFile>
+#include <QList>
+#include <QTextStream>
+#include "fuelmapcellstats.h"
+
+/**
+ * Shares a frame between the cells around its map position and adds it to
+ * their totals. A weighting that points past the last row or column is
+ * folded back into the edge cell.
+ */
+void FuelMapCellStats::addFrame(const TelemetryFrame& frame)
+{
+  double dwellMs = 0.0;
+
+  if (m_haveLastTimestamp)
+  {
+    dwellMs = qBound((qint64)0, frame.timestampMs - m_lastTimestampMs, s_maxDwellStepMs);
+  }
+  m_lastTimestampMs = frame.timestampMs;
+  m_haveLastTimestamp = true;
+
+  QVector<FuelMapCellTotals>& cells = m_maps[frame.currentFuelMapIndex];
+  if (cells.isEmpty())
+  {
+    cells.resize(s_rows * s_columns);
+  }
+
+  const int row = qBound(0, frame.fuelMapRowIndex, s_rows - 1);
+  const int col = qBound(0, frame.fuelMapColumnIndex, s_columns - 1);
+  const int nextRow = qMin(row + 1, s_rows - 1);
+  const int nextCol = qMin(col + 1, s_columns - 1);
+  const double rowFraction = qBound(0, frame.fuelMapRowWeighting, 15) / 16.0;
+  const double colFraction = qBound(0, frame.fuelMapColumnWeighting, 15) / 16.0;
+  const bool closedLoop = (frame.feedbackMode == C14CUX_FeedbackMode_ClosedLoop);
+
+  const int cellRows[4] = { row, row, nextRow, nextRow };
+  const int cellCols[4] = { col, nextCol, col, nextCol };
+  const double weights[4] = { (1.0 - rowFraction) * (1.0 - colFraction),
+                              (1.0 - rowFraction) * colFraction,
+                              rowFraction * (1.0 - colFraction),
+                              rowFraction * colFraction };
+
+  for (int idx = 0; idx < 4; idx++)
+  {
+    if (weights[idx] > 0.0)
+    {
+      addToCell(cells[(cellRows[idx] * s_columns) + cellCols[idx]], frame,
+                weights[idx], weights[idx] * dwellMs, closedLoop);
+    }
+  }
+}
+
+/**
+ * Adds a share of a frame to a cell's totals. The trim means and variances
+ * are kept with the weighted form of Welford's method, which stays accurate
+ * over any number of frames.
+ */
+void FuelMapCellStats::addToCell(FuelMapCellTotals& cell, const TelemetryFrame& frame,
+                                 double weight, double dwellMs, bool closedLoop)
+{
+  cell.dwellMs += dwellMs;
+  cell.weight += weight;
+  cell.mafSum += weight * frame.mafReading;
+
+  if (closedLoop)
+  {
+    cell.trimWeight += weight;
+
+    const double oddDelta = frame.lambdaTrimOdd - cell.trimOddMean;
+    cell.trimOddMean += (weight / cell.trimWeight) * oddDelta;
+    cell.trimOddM2 += weight * oddDelta * (frame.lambdaTrimOdd - cell.trimOddMean);
+
+    const double evenDelta = frame.lambdaTrimEven - cell.trimEvenMean;
+    cell.trimEvenMean += (weight / cell.trimWeight) * evenDelta;
+    cell.trimEvenM2 += weight * evenDelta * (frame.lambdaTrimEven - cell.trimEvenMean);
+  }
+}
+
+/**
+ * Discards everything accumulated so far.
+ */
+void FuelMapCellStats::reset()
+{
+  m_maps.clear();
+  m_haveLastTimestamp = false;
+}
+
+/**
+ * Indicates whether any frames have been accumulated for a fuel map.
+ */
+bool FuelMapCellStats::hasData(int fuelMapIndex) const
+{
+  return m_maps.contains(fuelMapIndex);
+}
+
+/**
+ * Returns the totals for one cell of a fuel map.
+ */
+FuelMapCellTotals FuelMapCellStats::cell(int fuelMapIndex, int row, int column) const
+{
+  const QVector<FuelMapCellTotals> cells = m_maps.value(fuelMapIndex);
+  return cells.isEmpty() ? FuelMapCellTotals() : cells.at((row * s_columns) + column);
+}
+
+/**
+ * Reduces one of the statistics for each cell of a fuel map to a level for
+ * display, in row-major order. Levels run from 0 to 1, except for the mean
+ * trim, which runs from -1 to 1 so that lean and rich cells can be told
+ * apart. Dwell time is shown on a square-root scale so that the cells that
+ * are passed through briefly still show up next to the one the engine idles
+ * in. A cell with no data (or no closed-loop data, for the trim statistics)
+ * is given a level of NaN.
+ */
+QVector<float> FuelMapCellStats::overlayLevels(int fuelMapIndex, FuelMapOverlay overlay) const
+{
+  const QVector<FuelMapCellTotals> cells = m_maps.value(fuelMapIndex);
+  QVector<float> levels(s_rows * s_columns, NAN);
+  QVector<double> values(s_rows * s_columns, 0.0);
+  double largest = 0.0;
+
+  if (cells.isEmpty() || (overlay == FuelMapOverlay_None))
+  {
+    return levels;
+  }
+
+  for (int idx = 0; idx < cells.size(); idx++)
+  {
+    const FuelMapCellTotals& cell = cells.at(idx);
+    const bool trim = (overlay == FuelMapOverlay_LambdaTrimMean) || (overlay == FuelMapOverlay_LambdaTrimStdDev);
+
+    if ((trim && (cell.trimWeight <= 0.0)) || (cell.weight <= 0.0))
+    {
+      continue;
+    }
+
+    switch (overlay)
+    {
+    case FuelMapOverlay_Dwell:
+      values[idx] = std::sqrt(cell.dwellMs);
+      break;
+    case FuelMapOverlay_LambdaTrimMean:
+      values[idx] = (cell.trimOddMean + cell.trimEvenMean) / 2.0;
+      break;
+    case FuelMapOverlay_LambdaTrimStdDev:
+      values[idx] = std::sqrt((cell.trimOddVariance() + cell.trimEvenVariance()) / 2.0);
+      break;
+    case FuelMapOverlay_MAF:
+      values[idx] = cell.mafMean();
+      break;
+    default:
+      break;
+    }
+
+    levels[idx] = 0.0f;
+    largest = qMax(largest, std::fabs(values[idx]));
+  }
+
+  // MAF is already a fraction of full scale; everything else is scaled to the largest cell
+  const double scale = (overlay == FuelMapOverlay_MAF) ? 1.0 : largest;
+
+  for (int idx = 0; idx < levels.size(); idx++)
+  {
+    if (!std::isnan(levels[idx]) && (scale > 0.0))
+    {
+      levels[idx] = (float)qBound(-1.0, values[idx] / scale, 1.0);
+    }
+  }
+
+  return levels;
+}
+
+/**
+ * Writes the totals of every visited cell of every fuel map to a CSV file.
+ * @return True if the file was written
+ */
+bool FuelMapCellStats::exportCsv(const QString& path) const
+{
+  QFile file(path);
+
+  if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+  {
+    return false;
+  }
+
+  QTextStream out(&file);
+  QList<int> maps = m_maps.keys();
+  std::sort(maps.begin(), maps.end());
+
+  out << "fuelMap,row,column,dwellS,frames,mafMeanPct,"
+         "closedLoopFrames,lambdaTrimOddMean,lambdaTrimOddSD,lambdaTrimEvenMean,lambdaTrimEvenSD" << Qt::endl;
+
+  foreach (int map, maps)
+  {
+    const QVector<FuelMapCellTotals> cells = m_maps.value(map);
+
+    for (int idx = 0; idx < cells.size(); idx++)
+    {
+      const FuelMapCellTotals& cell = cells.at(idx);
+
+      if (cell.weight > 0.0)
+      {
+        out << map << "," << (idx / s_columns) << "," << (idx % s_columns) << ","
+            << QString::number(cell.dwellMs / 1000.0, 'f', 2) << ","
+            << QString::number(cell.weight, 'f', 1) << ","
+            << QString::number(cell.mafMean() * 100.0, 'f', 1) << ","
+            << QString::number(cell.trimWeight, 'f', 1) << ","
+            << QString::number(cell.trimOddMean, 'f', 1) << ","
+            << QString::number(std::sqrt(cell.trimOddVariance()), 'f', 1) << ","
+            << QString::number(cell.trimEvenMean, 'f', 1) << ","
+            << QString::number(std::sqrt(cell.trimEvenVariance()), 'f', 1) << Qt::endl;
+      }
+    }
+  }
+
+  return (out.status() == QTextStream::Ok);
+}
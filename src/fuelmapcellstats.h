@@ -0,0 +1,73 @@
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "commonunits.h"
+#include "telemetryframe.h"
+
+/**
+ * Running totals for one cell of a fuel map.
+ */
+struct FuelMapCellTotals
+{
+  double dwellMs = 0.0;        // time spent in the cell, shared out by weighting
+  double weight = 0.0;         // number of frames, shared out by weighting
+  double mafSum = 0.0;         // sum of weighted MAF readings (as fractions of full scale)
+  double trimWeight = 0.0;     // weight of the frames taken in closed loop
+  double trimOddMean = 0.0;
+  double trimOddM2 = 0.0;      // sum of weighted squared differences from the mean
+  double trimEvenMean = 0.0;
+  double trimEvenM2 = 0.0;
+
+  double mafMean() const
+  {
+    return (weight > 0.0) ? (mafSum / weight) : 0.0;
+  }
+
+  double trimOddVariance() const
+  {
+    return (trimWeight > 0.0) ? (trimOddM2 / trimWeight) : 0.0;
+  }
+
+  double trimEvenVariance() const
+  {
+    return (trimWeight > 0.0) ? (trimEvenM2 / trimWeight) : 0.0;
+  }
+};
+
+/**
+ * Accumulates, for every cell of every fuel map, how long the engine has run
+ * in that cell and what the lambda trims and MAF did while it was there. Each
+ * frame is shared between the four cells around the interpolated map position
+ * in proportion to the row and column weightings, in the same way that the
+ * ECU blends the four cells' values.
+ *
+ * The lambda trims are only accumulated while the ECU is in closed loop,
+ * since they are held steady otherwise and would only dilute the figures.
+ */
+class FuelMapCellStats
+{
+public:
+  static const int s_rows = 8;
+  static const int s_columns = 16;
+
+  void addFrame(const TelemetryFrame& frame);
+  void reset();
+
+  bool hasData(int fuelMapIndex) const;
+  FuelMapCellTotals cell(int fuelMapIndex, int row, int column) const;
+  QVector<float> overlayLevels(int fuelMapIndex, FuelMapOverlay overlay) const;
+  bool exportCsv(const QString& path) const;
+
+private:
+  // A longer gap between frames is taken to be a pause in the data (such as
+  // a dropped connection) rather than time spent in the cell.
+  static constexpr qint64 s_maxDwellStepMs = 1000;
+
+  QHash<int, QVector<FuelMapCellTotals>> m_maps;
+  qint64 m_lastTimestampMs = 0;
+  bool m_haveLastTimestamp = false;
+
+  static void addToCell(FuelMapCellTotals& cell, const TelemetryFrame& frame,
+                        double weight, double dwellMs, bool closedLoop);
+};
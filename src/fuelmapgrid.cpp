@@ -1,33 +1,35 @@
+#include <cmath>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QFontMetrics>
 #include "fuelmapgrid.h"
-#include <QTableWidgetItem>
-#include <QColor>
-#include <QFont>
-#include <QHeaderView>
 
 FuelMapGrid::FuelMapGrid(QWidget* parent) :
-  QTableWidget(parent)
+  QWidget(parent)
 {
-  setStyleSheet("QTableWidget::item { padding: 0px }");
-  horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
-  horizontalHeader()->setVisible(true);
-  verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
-  verticalHeader()->setVisible(false);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 }
 
 void FuelMapGrid::setup(int numberBase)
 {
   m_numberBase = numberBase;
-  QTableWidgetItem* item = nullptr;
-  for (unsigned int col = 0; col < columnCount(); col++)
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
   {
-    setHorizontalHeaderItem(col, new QTableWidgetItem(""));
-    for (unsigned int row = 0; row < rowCount(); row++)
-    {
-      item = new QTableWidgetItem("");
-      item->setTextAlignment(Qt::AlignCenter);
-      item->setFlags(Qt::NoItemFlags);
-      setItem(row, col, item);
-    }
+    m_columnLabels[col].clear();
+  }
+  invalidateAll();
+}
+
+/**
+ * Sets the heading of a column (the engine speed at which it applies.)
+ */
+void FuelMapGrid::setColumnLabel(int col, const QString& label)
+{
+  if ((col >= 0) && (col < FUEL_MAP_COLUMNS) && (m_columnLabels[col] != label))
+  {
+    m_columnLabels[col] = label;
+    m_headerDirty = true;
+    update(headerRect(col));
   }
 }
 
@@ -37,7 +39,7 @@ void FuelMapGrid::moveCellHighlight(int row, int rowWeight, int col, int colWeig
   m_activeRowWeight = rowWeight;
   m_activeCol = col;
   m_activeColWeight = colWeight;
-  clearCellHighlight();
+  m_softHighlight = soft;
 
   if (soft)
   {
@@ -67,13 +69,8 @@ void FuelMapGrid::moveCellHighlightHard()
   }
 
   // We're only highlighting a single cell (not a block of four).
-  m_lastCellHighlight[0].first = highlightedRow;
-  m_lastCellHighlight[0].second = highlightedCol;
-  m_lastCellHighlightCount = 1;
-
-  QTableWidgetItem* const cell = item(highlightedRow, highlightedCol);
-  cell->setBackground(Qt::black);
-  cell->setForeground(Qt::white);
+  const CellHighlight cell = { highlightedRow, highlightedCol, Qt::black, Qt::white };
+  setHighlight(&cell, 1);
 }
 
 void FuelMapGrid::moveCellHighlightSoft()
@@ -94,95 +91,152 @@ void FuelMapGrid::moveCellHighlightSoft()
   shadePercentage[2] = 1.0 - (leftPercent * bottomPercent);
   shadePercentage[3] = 1.0 - (rightPercent * bottomPercent);
 
-  // Save the row/column positions for the fuel map cells that will be highlighted.
-  m_lastCellHighlight[0].first = m_activeRow;
-  m_lastCellHighlight[0].second = m_activeCol;
-  m_lastCellHighlight[1].first = m_activeRow;
-  m_lastCellHighlight[1].second = m_activeCol + 1;
-  m_lastCellHighlight[2].first = m_activeRow + 1;
-  m_lastCellHighlight[2].second = m_activeCol;
-  m_lastCellHighlight[3].first = m_activeRow + 1;
-  m_lastCellHighlight[3].second = m_activeCol + 1;
-  m_lastCellHighlightCount = 4;
-
-  // Set the shaded color as the background for the highlighted cells.
-  for (int idx = 0; idx < m_lastCellHighlightCount; idx++)
-  {
-    const int row = m_lastCellHighlight[idx].first;
-    const int col = m_lastCellHighlight[idx].second;
-    QTableWidgetItem* const cell = item(row, col);
-    if (cell)
+  const int rows[NUM_ACTIVE_FUEL_MAP_CELLS] = { m_activeRow, m_activeRow, m_activeRow + 1, m_activeRow + 1 };
+  const int cols[NUM_ACTIVE_FUEL_MAP_CELLS] = { m_activeCol, m_activeCol + 1, m_activeCol, m_activeCol + 1 };
+  CellHighlight cells[NUM_ACTIVE_FUEL_MAP_CELLS];
+  int count = 0;
+
+  // Shade each of the block of four cells that lies within the map.
+  for (int idx = 0; idx < NUM_ACTIVE_FUEL_MAP_CELLS; idx++)
+  {
+    const int row = rows[idx];
+    const int col = cols[idx];
+    if ((row >= 0) && (row < FUEL_MAP_ROWS) && (col >= 0) && (col < FUEL_MAP_COLUMNS))
     {
       const QColor& currentColor = m_cellColors[row][col];
       QColor newColor;
       newColor.setRgb(currentColor.red() * shadePercentage[idx],
                       currentColor.green() * shadePercentage[idx],
                       currentColor.blue() * shadePercentage[idx]);
-      cell->setBackground(newColor);
-      cell->setForeground((newColor.value() > 128) ? Qt::black : Qt::white);
+      cells[count++] = { row, col, newColor, (newColor.value() > 128) ? Qt::black : Qt::white };
+    }
+  }
+
+  setHighlight(cells, count);
+}
+
+/**
+ * Replaces the highlighted cells, and schedules a repaint of only the cells
+ * whose appearance changes as a result.
+ */
+void FuelMapGrid::setHighlight(const CellHighlight* cells, int count)
+{
+  bool changed[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS] = {};
+
+  if (m_highlightShown)
+  {
+    for (int idx = 0; idx < m_highlightCount; idx++)
+    {
+      changed[m_highlight[idx].row][m_highlight[idx].col] = true;
+    }
+  }
+
+  for (int idx = 0; idx < count; idx++)
+  {
+    const CellHighlight& cell = cells[idx];
+    bool same = false;
+
+    // a cell that stays highlighted with the same colors doesn't need repainting
+    for (int old = 0; m_highlightShown && (old < m_highlightCount); old++)
+    {
+      if ((m_highlight[old].row == cell.row) && (m_highlight[old].col == cell.col))
+      {
+        same = (m_highlight[old].background == cell.background) &&
+               (m_highlight[old].foreground == cell.foreground);
+        changed[cell.row][cell.col] = !same;
+      }
+    }
+
+    if (!same)
+    {
+      changed[cell.row][cell.col] = true;
+    }
+  }
+
+  // the old highlights are only replaced once every new cell has been compared with them
+  for (int idx = 0; idx < count; idx++)
+  {
+    m_highlight[idx] = cells[idx];
+  }
+  m_highlightCount = count;
+  m_highlightShown = true;
+
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
+  {
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+    {
+      if (changed[row][col])
+      {
+        update(cellRect(row, col));
+      }
     }
   }
 }
 
 void FuelMapGrid::clearCellHighlight()
 {
-  for (int idx = 0; idx < m_lastCellHighlightCount; idx++)
+  if (m_highlightShown)
   {
-    const int row = m_lastCellHighlight[idx].first;
-    const int col = m_lastCellHighlight[idx].second;
-    if ((row >= 0) && (row < rowCount()) &&
-        (col >= 0) && (col < columnCount()))
+    m_highlightShown = false;
+    for (int idx = 0; idx < m_highlightCount; idx++)
     {
-      QTableWidgetItem* cell = item(row, col);
-      cell->setBackground(m_cellColors[row][col]);
-      cell->setForeground(Qt::black);
+      update(cellRect(m_highlight[idx].row, m_highlight[idx].col));
     }
   }
 }
 
 void FuelMapGrid::restoreCellHighlight()
 {
-  moveCellHighlight(m_activeRow, m_activeRowWeight, m_activeCol, m_activeColWeight, (m_lastCellHighlightCount == 4));
+  moveCellHighlight(m_activeRow, m_activeRowWeight, m_activeCol, m_activeColWeight, m_softHighlight);
 }
 
+/**
+ * Takes new fuel map contents. Only the cells whose values have changed are
+ * drawn again.
+ */
 void FuelMapGrid::setData(const QByteArray& data)
 {
-  const int numRows = rowCount();
-  const int numCols = columnCount();
-  QTableWidgetItem* cellItem = nullptr;
-  unsigned char byte = 0;
+  if (data.size() < (FUEL_MAP_ROWS * FUEL_MAP_COLUMNS))
+  {
+    return;
+  }
 
-  clearCellHighlight();
-  for (int row = 0; row < numRows; row++)
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
   {
-    for (int col = 0; col < numCols; col++)
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
     {
-      cellItem = item(row, col);
-      if (cellItem)
-      {
-        // retrieve the fuel map value at the current row/col
-        byte = data.at(row * numCols + col);
+      // retrieve the fuel map value at the current row/col
+      const unsigned char byte = data.at(row * FUEL_MAP_COLUMNS + col);
 
-        if (m_numberBase == 16)
-        {
-          cellItem->setText(QString("%1").arg(byte, 2, 16, QChar('0')).toUpper());
-        }
-        else if (m_numberBase == 10)
+      if (!m_haveData || (byte != m_values[row][col]))
+      {
+        m_values[row][col] = byte;
+        m_mapColors[row][col] = getColorForFuelMapCell(byte);
+        if (!m_overlayActive)
         {
-          cellItem->setText(QString("%1").arg(byte));
+          m_cellColors[row][col] = m_mapColors[row][col];
         }
-        m_cellColors[row][col] = getColorForFuelMapCell(byte);
-        cellItem->setBackground(m_cellColors[row][col]);
-        cellItem->setForeground(Qt::black);
+        invalidateCell(row, col);
       }
     }
   }
-  restoreCellHighlight();
+
+  m_haveData = true;
+
+  // a soft highlight's shading depends on the colors of the cells beneath it
+  if (m_highlightShown)
+  {
+    restoreCellHighlight();
+  }
 }
 
 void FuelMapGrid::setNumberBase(int base)
 {
-  m_numberBase = base;
+  if (base != m_numberBase)
+  {
+    m_numberBase = base;
+    invalidateAll();
+  }
 }
 
 QColor FuelMapGrid::getColorForFuelMapCell(unsigned char value) const
@@ -190,3 +244,282 @@ QColor FuelMapGrid::getColorForFuelMapCell(unsigned char value) const
   return QColor::fromRgb(255, (value / 2 * -1) + 255, 255.0 - value);
 }
 
+/**
+ * Colors the cells by the given levels (in row-major order) in place of the
+ * fuel map values. Positive levels shade from white toward red, negative
+ * levels toward blue, and cells with no level (NaN) are grey. The values in
+ * the cells are still those of the fuel map.
+ */
+void FuelMapGrid::setOverlay(const QVector<float>& levels)
+{
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
+  {
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+    {
+      const int idx = (row * FUEL_MAP_COLUMNS) + col;
+      const QColor color = getColorForOverlayLevel((idx < levels.size()) ? levels.at(idx) : NAN);
+
+      if (color != m_cellColors[row][col])
+      {
+        m_cellColors[row][col] = color;
+        invalidateCell(row, col);
+      }
+    }
+  }
+
+  m_overlayActive = true;
+  if (m_highlightShown)
+  {
+    restoreCellHighlight();
+  }
+}
+
+/**
+ * Returns to coloring the cells by the fuel map values.
+ */
+void FuelMapGrid::clearOverlay()
+{
+  if (m_overlayActive)
+  {
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+      {
+        m_cellColors[row][col] = m_mapColors[row][col];
+        invalidateCell(row, col);
+      }
+    }
+
+    m_overlayActive = false;
+    if (m_highlightShown)
+    {
+      restoreCellHighlight();
+    }
+  }
+}
+
+QColor FuelMapGrid::getColorForOverlayLevel(float level) const
+{
+  if (std::isnan(level))
+  {
+    return QColor::fromRgb(224, 224, 224);
+  }
+
+  const int fade = 255 - (int)(qMin(std::fabs(level), 1.0f) * 255.0f);
+  return (level >= 0.0f) ? QColor::fromRgb(255, fade, fade) : QColor::fromRgb(fade, fade, 255);
+}
+
+QSize FuelMapGrid::sizeHint() const
+{
+  const QFontMetrics metrics(font());
+  return QSize(FUEL_MAP_COLUMNS * (metrics.horizontalAdvance("0000") + 6),
+               (FUEL_MAP_ROWS + 1) * (metrics.height() + 6));
+}
+
+QSize FuelMapGrid::minimumSizeHint() const
+{
+  const QFontMetrics metrics(font());
+  return QSize(FUEL_MAP_COLUMNS * (metrics.horizontalAdvance("00") + 2),
+               (FUEL_MAP_ROWS + 1) * (metrics.height() + 1));
+}
+
+int FuelMapGrid::headerHeight() const
+{
+  return QFontMetrics(font()).height() + 4;
+}
+
+/**
+ * Returns the area of a cell. The columns and rows share out the width and
+ * height as evenly as whole pixels allow.
+ */
+QRect FuelMapGrid::cellRect(int row, int col) const
+{
+  const int header = headerHeight();
+  const int body = height() - header;
+  const int left = (col * width()) / FUEL_MAP_COLUMNS;
+  const int right = ((col + 1) * width()) / FUEL_MAP_COLUMNS;
+  const int top = header + ((row * body) / FUEL_MAP_ROWS);
+  const int bottom = header + (((row + 1) * body) / FUEL_MAP_ROWS);
+
+  return QRect(left, top, right - left, bottom - top);
+}
+
+QRect FuelMapGrid::headerRect(int col) const
+{
+  const int left = (col * width()) / FUEL_MAP_COLUMNS;
+  const int right = ((col + 1) * width()) / FUEL_MAP_COLUMNS;
+
+  return QRect(left, 0, right - left, headerHeight());
+}
+
+QString FuelMapGrid::cellText(int row, int col) const
+{
+  if (!m_haveData)
+  {
+    return QString();
+  }
+  else if (m_numberBase == 16)
+  {
+    return QString("%1").arg(m_values[row][col], 2, 16, QChar('0')).toUpper();
+  }
+
+  return QString::number(m_values[row][col]);
+}
+
+/**
+ * Marks a cell to be drawn into the cache again, and schedules a repaint of it.
+ */
+void FuelMapGrid::invalidateCell(int row, int col)
+{
+  m_cellDirty[row][col] = true;
+  m_anyCellDirty = true;
+  update(cellRect(row, col));
+}
+
+/**
+ * Discards the cache, so that the whole grid is drawn again.
+ */
+void FuelMapGrid::invalidateAll()
+{
+  m_cacheValid = false;
+  update();
+}
+
+/**
+ * The cache is drawn again at the new size when the widget is next painted.
+ */
+void FuelMapGrid::resizeEvent(QResizeEvent* event)
+{
+  QWidget::resizeEvent(event);
+  m_cacheValid = false;
+}
+
+/**
+ * A change of font or palette affects every cell.
+ */
+void FuelMapGrid::changeEvent(QEvent* event)
+{
+  if ((event->type() == QEvent::FontChange) || (event->type() == QEvent::PaletteChange) ||
+      (event->type() == QEvent::StyleChange))
+  {
+    invalidateAll();
+  }
+  QWidget::changeEvent(event);
+}
+
+/**
+ * Brings the cached image of the map up to date, drawing all of it if the
+ * widget's size has changed, or otherwise just the cells and headings that
+ * have changed.
+ */
+void FuelMapGrid::updateCache()
+{
+  const qreal ratio = devicePixelRatioF();
+  const QSize pixelSize = size() * ratio;
+
+  if (m_cache.size() != pixelSize)
+  {
+    m_cache = QPixmap(pixelSize);
+    m_cache.setDevicePixelRatio(ratio);
+    m_cacheValid = false;
+  }
+
+  if (m_cacheValid && !m_anyCellDirty && !m_headerDirty)
+  {
+    return;
+  }
+
+  QPainter painter(&m_cache);
+
+  if (!m_cacheValid)
+  {
+    m_cache.fill(Qt::transparent);
+  }
+  painter.setFont(font());
+
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    if (!m_cacheValid || m_headerDirty)
+    {
+      drawHeader(painter, col);
+    }
+
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      if (!m_cacheValid || m_cellDirty[row][col])
+      {
+        drawCell(painter, row, col, m_cellColors[row][col], Qt::black);
+        m_cellDirty[row][col] = false;
+      }
+    }
+  }
+
+  m_cacheValid = true;
+  m_anyCellDirty = false;
+  m_headerDirty = false;
+}
+
+/**
+ * Draws one cell: its background, its value, and the grid lines along its
+ * right and bottom edges.
+ */
+void FuelMapGrid::drawCell(QPainter& painter, int row, int col,
+                           const QColor& background, const QColor& foreground) const
+{
+  const QRect rect = cellRect(row, col);
+
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  painter.fillRect(rect, background.isValid() ? background : QColor(Qt::transparent));
+  painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+  painter.setPen(palette().color(QPalette::Mid));
+  painter.drawLine(rect.topRight(), rect.bottomRight());
+  painter.drawLine(rect.bottomLeft(), rect.bottomRight());
+
+  painter.setPen(foreground);
+  painter.drawText(rect.adjusted(0, 0, -1, -1), Qt::AlignCenter, cellText(row, col));
+}
+
+/**
+ * Draws the heading of one column.
+ */
+void FuelMapGrid::drawHeader(QPainter& painter, int col) const
+{
+  const QRect rect = headerRect(col);
+
+  painter.fillRect(rect, palette().button());
+  painter.setPen(palette().color(QPalette::Mid));
+  painter.drawLine(rect.topRight(), rect.bottomRight());
+  painter.drawLine(rect.bottomLeft(), rect.bottomRight());
+  painter.setPen(palette().color(QPalette::ButtonText));
+  painter.drawText(rect.adjusted(0, 0, -1, -1), Qt::AlignCenter, m_columnLabels[col]);
+}
+
+/**
+ * Copies the damaged area from the cache, then draws any highlighted cells
+ * that fall within it.
+ */
+void FuelMapGrid::paintEvent(QPaintEvent* event)
+{
+  const QRect damaged = event->rect();
+  const qreal ratio = devicePixelRatioF();
+
+  updateCache();
+
+  QPainter painter(this);
+  painter.drawPixmap(damaged.topLeft(), m_cache,
+                     QRect(damaged.topLeft() * ratio, damaged.size() * ratio));
+
+  if (m_highlightShown)
+  {
+    painter.setFont(font());
+    for (int idx = 0; idx < m_highlightCount; idx++)
+    {
+      const CellHighlight& cell = m_highlight[idx];
+      if (damaged.intersects(cellRect(cell.row, cell.col)))
+      {
+        drawCell(painter, cell.row, cell.col, cell.background, cell.foreground);
+      }
+    }
+  }
+}
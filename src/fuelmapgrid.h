@@ -1,12 +1,24 @@
 #pragma once
-#include <QTableWidget>
+#include <QWidget>
 #include <QByteArray>
+#include <QColor>
+#include <QPixmap>
+#include <QString>
+#include <QVector>
 
 #define NUM_ACTIVE_FUEL_MAP_CELLS 4
 #define FUEL_MAP_ROWS 8
 #define FUEL_MAP_COLUMNS 16
 
-class FuelMapGrid : public QTableWidget
+/**
+ * Shows a fuel map as a grid of colored cells, with the engine speed of each
+ * column along the top and a highlight over the cell (or block of four
+ * cells) in use. The map is drawn into a cached pixmap, and only the cells
+ * whose contents change are drawn into it again. Moving the highlight
+ * repaints just the cells that it leaves and enters, by copying them from
+ * the cache and drawing the highlighted cells over it.
+ */
+class FuelMapGrid : public QWidget
 {
   Q_OBJECT
 public:
@@ -17,19 +29,61 @@ public:
   void setData(const QByteArray& data);
   void setNumberBase(int base);
   void setup(int numberBase);
+  void setColumnLabel(int col, const QString& label);
+  void setOverlay(const QVector<float>& levels);
+  void clearOverlay();
+
+  QSize sizeHint() const;
+  QSize minimumSizeHint() const;
+
+protected:
+  void paintEvent(QPaintEvent* event);
+  void resizeEvent(QResizeEvent* event);
+  void changeEvent(QEvent* event);
 
 private:
+  struct CellHighlight
+  {
+    int row;
+    int col;
+    QColor background;
+    QColor foreground;
+  };
+
+  unsigned char m_values[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS] = {};
+  bool m_haveData = false;
+  QString m_columnLabels[FUEL_MAP_COLUMNS];
   QColor m_cellColors[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS];
-  QPair<int,int> m_lastCellHighlight[NUM_ACTIVE_FUEL_MAP_CELLS];
+  QColor m_mapColors[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS];
+  bool m_overlayActive = false;
+  CellHighlight m_highlight[NUM_ACTIVE_FUEL_MAP_CELLS];
+  int m_highlightCount = 0;
+  bool m_highlightShown = false;
+  bool m_softHighlight = false;
   int m_numberBase = 16;
   int m_activeRow = 0;
   int m_activeRowWeight = 0;
   int m_activeCol = 0;
   int m_activeColWeight = 0;
-  int m_lastCellHighlightCount = 0;
 
+  QPixmap m_cache;
+  bool m_cacheValid = false;
+  bool m_cellDirty[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS] = {};
+  bool m_anyCellDirty = false;
+  bool m_headerDirty = false;
+
+  int headerHeight() const;
+  QRect cellRect(int row, int col) const;
+  QRect headerRect(int col) const;
+  QString cellText(int row, int col) const;
+  void invalidateCell(int row, int col);
+  void invalidateAll();
+  void updateCache();
+  void drawCell(QPainter& painter, int row, int col, const QColor& background, const QColor& foreground) const;
+  void drawHeader(QPainter& painter, int col) const;
+  void setHighlight(const CellHighlight* cells, int count);
   void moveCellHighlightHard();
   void moveCellHighlightSoft();
   QColor getColorForFuelMapCell(unsigned char value) const;
+  QColor getColorForOverlayLevel(float level) const;
 };
-
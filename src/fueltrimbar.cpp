@@ -16,11 +16,15 @@ FuelTrimBar::FuelTrimBar(QWidget* parent) :
 /**
  * Call update() when the value changes; this avoids the problem of the
  * bar not getting repainted when a small value (< 3 and > -3) is set.
+ * Setting the value that is already displayed does nothing.
  */
 void FuelTrimBar::setValue(int value)
 {
-  QProgressBar::setValue(value);
-  update();
+  if (value != this->value())
+  {
+    QProgressBar::setValue(value);
+    update();
+  }
 }
 
 /**
@@ -0,0 +1,237 @@
+#include <cstdio>
+#include <QCoreApplication>
+#include <QStringList>
+#include "headlesssession.h"
+#include "samplesettings.h"
+
+/**
+ * Constructor. Takes ownership of the interface object, which is moved to its
+ * own worker thread when the session is started.
+ * @param cux Interface to the 14CUX
+ * @param logName Base name for the log file
+ * @param logSettings Format and timestamp style of the log
+ * @param retrySecs Seconds to wait before retrying a failed or lost
+ *  connection, or zero to exit instead
+ */
+HeadlessSession::HeadlessSession(CUXInterface* cux, const QString& logName, const LogSettings& logSettings,
+                                 int retrySecs, QObject* parent) :
+  QObject(parent),
+  m_cux(cux),
+  m_logger(*cux),
+  m_logName(logName),
+  m_status(stderr),
+  m_retrySecs(retrySecs)
+{
+  m_logger.setSettings(logSettings);
+
+  m_retryTimer.setSingleShot(true);
+  connect(&m_retryTimer, &QTimer::timeout, this, &HeadlessSession::requestToStartPolling);
+
+  connect(m_cux, &CUXInterface::dataReady,                this, &HeadlessSession::onDataReady);
+  connect(m_cux, &CUXInterface::connected,                this, &HeadlessSession::onConnect);
+  connect(m_cux, &CUXInterface::disconnected,             this, &HeadlessSession::onDisconnect);
+  connect(m_cux, &CUXInterface::failedToConnect,          this, &HeadlessSession::onFailedToConnect);
+  connect(m_cux, &CUXInterface::interfaceReadyForPolling, this, &HeadlessSession::onInterfaceReady);
+  connect(m_cux, &CUXInterface::fuelMapIndexHasChanged,   this, &HeadlessSession::onFuelMapIndexChanged);
+  connect(m_cux, &CUXInterface::fuelMapReady,             this, &HeadlessSession::onFuelMapDataReady);
+
+  connect(this, &HeadlessSession::requestToStartPolling, m_cux, &CUXInterface::onStartPollingRequest);
+  connect(this, &HeadlessSession::requestThreadShutdown, m_cux, &CUXInterface::onShutdownThreadRequest);
+}
+
+/**
+ * Destructor. Shuts down the worker thread (if it is still running) before
+ * deleting the interface object.
+ */
+HeadlessSession::~HeadlessSession()
+{
+  shutdown();
+  delete m_cux;
+  delete m_cuxThread;
+}
+
+/**
+ * Starts the worker thread. Polling begins once the thread signals that the
+ * interface is ready.
+ */
+void HeadlessSession::start()
+{
+  if (m_cuxThread == nullptr)
+  {
+    m_cuxThread = new QThread();
+    m_cux->moveToThread(m_cuxThread);
+    connect(m_cuxThread, &QThread::started, m_cux, &CUXInterface::onParentThreadStarted);
+    m_cuxThread->start();
+  }
+}
+
+/**
+ * Closes the log and stops the worker thread. Called when the application's
+ * event loop has exited.
+ */
+void HeadlessSession::shutdown()
+{
+  if (!m_shuttingDown)
+  {
+    m_shuttingDown = true;
+    m_retryTimer.stop();
+    m_logger.closeLog();
+
+    if (m_cuxThread && m_cuxThread->isRunning())
+    {
+      emit requestThreadShutdown();
+      m_cuxThread->wait(2000);
+    }
+
+    if (m_isLogging)
+    {
+      m_status << "Logged " << m_framesLogged << " frames to " << m_logger.getLogPath() << Qt::endl;
+      if (m_logger.getDroppedFrames() > 0)
+      {
+        m_status << "Dropped " << m_logger.getDroppedFrames() << " frames that arrived faster than the log "
+                 << "could be written" << Qt::endl;
+      }
+      reportReadRates();
+    }
+  }
+}
+
+/**
+ * Prints the rate at which each reading was being read when logging stopped.
+ */
+void HeadlessSession::reportReadRates()
+{
+  QStringList rates;
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const float rate = m_cux->getAchievedRate((SampleType)type);
+    if (rate > 0.0f)
+    {
+      rates.append(QString("%1 %2 Hz").arg(SampleSettings::shortName((SampleType)type)).arg(rate, 0, 'f', 1));
+    }
+  }
+
+  if (!rates.isEmpty())
+  {
+    m_status << "Read rates: " << rates.join(", ") << Qt::endl;
+  }
+}
+
+/**
+ * Responds to the worker thread being ready by asking it to connect.
+ */
+void HeadlessSession::onInterfaceReady()
+{
+  emit requestToStartPolling();
+}
+
+/**
+ * Opens the log file the first time that a connection is made. The log is kept
+ * open across reconnections so that one session produces one log.
+ */
+void HeadlessSession::onConnect()
+{
+  m_status << "Connected to " << m_cux->getSerialDevice() << Qt::endl;
+
+  if (!m_isLogging)
+  {
+    if (m_logger.openLog(m_logName))
+    {
+      m_isLogging = true;
+      m_status << "Logging to " << m_logger.getLogPath() << Qt::endl;
+    }
+    else
+    {
+      m_status << "Failed to open log file (" << m_logger.getLogPath() << ")" << Qt::endl;
+      QCoreApplication::exit(1);
+    }
+  }
+}
+
+/**
+ * Responds to the connection being closed. Unless we're shutting down, this
+ * means the link was lost, so a reconnection is scheduled.
+ */
+void HeadlessSession::onDisconnect()
+{
+  m_requestedTuneID = false;
+  m_logger.onDisconnect();
+  m_cux->invalidateFuelMapData();
+
+  if (!m_shuttingDown)
+  {
+    m_status << "Disconnected" << Qt::endl;
+    retryOrQuit();
+  }
+}
+
+/**
+ * Reports a failed connection attempt and schedules another one.
+ */
+void HeadlessSession::onFailedToConnect(QString dev)
+{
+  m_status << "Failed to connect to " << dev << Qt::endl;
+  retryOrQuit();
+}
+
+/**
+ * Retries the connection after the configured delay, or exits if retries
+ * are disabled.
+ */
+void HeadlessSession::retryOrQuit()
+{
+  if (m_retrySecs > 0)
+  {
+    m_retryTimer.start(m_retrySecs * 1000);
+  }
+  else
+  {
+    QCoreApplication::exit(1);
+  }
+}
+
+/**
+ * Hands every frame published by the interface thread to the logger.
+ */
+void HeadlessSession::onDataReady()
+{
+  TelemetryFrame frame;
+
+  while (m_cux->takeFrame(frame))
+  {
+    m_logger.logData(frame);
+    m_framesLogged++;
+  }
+
+  // the tune ID is needed for the static data log
+  if (!m_requestedTuneID)
+  {
+    m_cux->enqueueRequest(QueueableRequest_TuneRevID);
+    m_requestedTuneID = true;
+  }
+}
+
+/**
+ * Requests the contents of the newly selected fuel map, if they haven't
+ * already been read, so that they can be written to the static data log.
+ */
+void HeadlessSession::onFuelMapIndexChanged(unsigned int fuelMapId)
+{
+  if (m_cux->getFuelMap(fuelMapId) == nullptr)
+  {
+    m_cux->enqueueRequest(QueueableRequest_FuelMapData, fuelMapId);
+  }
+  else
+  {
+    m_logger.onFuelMapDataReady(fuelMapId);
+  }
+}
+
+/**
+ * Passes along the notification that fuel map data is available.
+ */
+void HeadlessSession::onFuelMapDataReady(unsigned int fuelMapId)
+{
+  m_logger.onFuelMapDataReady(fuelMapId);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QTextStream>
+#include "cuxinterface.h"
+#include "logger.h"
+#include "logsettings.h"
+
+/**
+ * Drives the 14CUX interface and the logger without any widgets, for
+ * unattended logging from the command line. This plays the part that
+ * MainWindow plays in the GUI: it owns the worker thread, requests the
+ * one-shot data that the static log needs, and hands every frame to the logger.
+ */
+class HeadlessSession : public QObject
+{
+  Q_OBJECT
+
+public:
+  HeadlessSession(CUXInterface* cux, const QString& logName, const LogSettings& logSettings,
+                  int retrySecs, QObject* parent = nullptr);
+  ~HeadlessSession();
+
+  void start();
+  void shutdown();
+
+signals:
+  void requestToStartPolling();
+  void requestThreadShutdown();
+
+private slots:
+  void onInterfaceReady();
+  void onConnect();
+  void onDisconnect();
+  void onFailedToConnect(QString dev);
+  void onDataReady();
+  void onFuelMapIndexChanged(unsigned int fuelMapId);
+  void onFuelMapDataReady(unsigned int fuelMapId);
+
+private:
+  CUXInterface* m_cux;
+  QThread* m_cuxThread = nullptr;
+  Logger m_logger;
+  QString m_logName;
+  QTimer m_retryTimer;
+  QTextStream m_status;
+  const int m_retrySecs;
+  bool m_isLogging = false;
+  bool m_requestedTuneID = false;
+  bool m_shuttingDown = false;
+  unsigned long m_framesLogged = 0;
+
+  void retryOrQuit();
+  void reportReadRates();
+};
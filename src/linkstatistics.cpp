@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <limits>
+#include <QDateTime>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include "linkstatistics.h"
+#include "samplesettings.h"
+
+/**
+ * Returns the average read time, in milliseconds.
+ */
+float ChannelStatistics::meanLatencyMs() const
+{
+  const unsigned int count = successes + failures;
+  return (count > 0) ? (float)(totalLatencyMs / count) : 0.0f;
+}
+
+/**
+ * Returns an upper bound on the given percentile of read time, taken from
+ * the histogram (so it is only as precise as the bucket boundaries.)
+ * @param fraction Percentile as a fraction, e.g. 0.95
+ */
+float ChannelStatistics::latencyPercentileMs(float fraction) const
+{
+  const unsigned int count = successes + failures;
+  const unsigned int target = (unsigned int)(count * fraction);
+  unsigned int seen = 0;
+
+  for (int bucket = 0; bucket < s_latencyBucketCount; bucket++)
+  {
+    seen += latencyHistogram[bucket];
+    if ((seen > target) && (seen > 0))
+    {
+      return std::min(LinkStatistics::bucketUpperBoundMs(bucket), maxLatencyMs);
+    }
+  }
+
+  return maxLatencyMs;
+}
+
+/**
+ * Returns the average time taken by a pass of the polling loop, in milliseconds.
+ */
+float LinkStatisticsSnapshot::meanPassMs() const
+{
+  return (passCount > 0) ? (float)(totalPassMs / passCount) : 0.0f;
+}
+
+/**
+ * Constructor. Starts the clock that measures the length of the session.
+ */
+LinkStatistics::LinkStatistics()
+{
+  m_clock.start();
+}
+
+/**
+ * Returns the upper bound of a latency histogram bucket. The buckets double in
+ * width, from under 0.5 ms to over 512 ms.
+ */
+float LinkStatistics::bucketUpperBoundMs(int bucket)
+{
+  return (bucket < ChannelStatistics::s_latencyBucketCount - 1) ?
+    (0.5f * (float)(1 << bucket)) : std::numeric_limits<float>::infinity();
+}
+
+/**
+ * Clears all the counters. Called when a new connection is made.
+ */
+void LinkStatistics::reset()
+{
+  QMutexLocker locker(&m_lock);
+  m_stats = LinkStatisticsSnapshot();
+  m_clock.restart();
+}
+
+/**
+ * Records one read of a sample type.
+ * @param type Sample type that was read
+ * @param success True if the read succeeded
+ * @param latencyMs Time spent on the read
+ */
+void LinkStatistics::recordRead(SampleType type, bool success, float latencyMs)
+{
+  QMutexLocker locker(&m_lock);
+  ChannelStatistics& channel = m_stats.channels[type];
+  int bucket = 0;
+
+  while ((bucket < ChannelStatistics::s_latencyBucketCount - 1) && (latencyMs >= bucketUpperBoundMs(bucket)))
+  {
+    bucket++;
+  }
+
+  if (success)
+  {
+    channel.successes++;
+  }
+  else
+  {
+    channel.failures++;
+  }
+
+  channel.latencyHistogram[bucket]++;
+  channel.totalLatencyMs += latencyMs;
+  channel.maxLatencyMs = std::max(channel.maxLatencyMs, latencyMs);
+}
+
+/**
+ * Records the time taken by one pass of the polling loop.
+ */
+void LinkStatistics::recordPass(float durationMs)
+{
+  QMutexLocker locker(&m_lock);
+  m_stats.passCount++;
+  m_stats.totalPassMs += durationMs;
+  m_stats.lastPassMs = durationMs;
+  m_stats.maxPassMs = std::max(m_stats.maxPassMs, durationMs);
+}
+
+/**
+ * Records the number of requests waiting in the queue.
+ */
+void LinkStatistics::recordQueueDepth(int depth)
+{
+  QMutexLocker locker(&m_lock);
+  m_stats.queueDepth = depth;
+  m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, depth);
+}
+
+/**
+ * Returns a copy of the counters.
+ */
+LinkStatisticsSnapshot LinkStatistics::snapshot() const
+{
+  QMutexLocker locker(&m_lock);
+  LinkStatisticsSnapshot stats = m_stats;
+  stats.elapsedMs = m_clock.elapsed();
+  return stats;
+}
+
+/**
+ * Sets the file to which a report is appended when the connection is closed,
+ * or an empty string for no report.
+ */
+void LinkStatistics::setReportPath(const QString& path)
+{
+  QMutexLocker locker(&m_lock);
+  m_reportPath = path;
+}
+
+/**
+ * Returns the file to which a report is appended when the connection is closed.
+ */
+QString LinkStatistics::reportPath() const
+{
+  QMutexLocker locker(&m_lock);
+  return m_reportPath;
+}
+
+/**
+ * Appends a plain-text report of the statistics to a file.
+ * @return True if the report was written
+ */
+bool LinkStatistics::writeReport(const LinkStatisticsSnapshot& stats, const QString& path)
+{
+  QFile file(path);
+
+  if (!file.open(QFile::WriteOnly | QFile::Append | QFile::Text))
+  {
+    return false;
+  }
+
+  QTextStream out(&file);
+  out << "# Link statistics at " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")
+      << " after " << QString::number(stats.elapsedMs / 1000.0, 'f', 1) << " s" << Qt::endl;
+  out << "# passes " << stats.passCount
+      << ", mean pass " << QString::number(stats.meanPassMs(), 'f', 2) << " ms"
+      << ", max pass " << QString::number(stats.maxPassMs, 'f', 2) << " ms"
+      << ", max queue depth " << stats.maxQueueDepth
+      << ", dropped frames " << stats.droppedFrames << Qt::endl;
+  out << "reading,rateHz,successes,failures,meanMs,p95Ms,maxMs,deadlineMisses,maxLateMs";
+  for (int bucket = 0; bucket < ChannelStatistics::s_latencyBucketCount - 1; bucket++)
+  {
+    out << ",lt" << bucketUpperBoundMs(bucket) << "ms";
+  }
+  out << ",over" << Qt::endl;
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const ChannelStatistics& channel = stats.channels[type];
+
+    if ((channel.successes + channel.failures) > 0)
+    {
+      out << SampleSettings::shortName((SampleType)type) << ","
+          << QString::number(channel.rateHz, 'f', 2) << ","
+          << channel.successes << ","
+          << channel.failures << ","
+          << QString::number(channel.meanLatencyMs(), 'f', 2) << ","
+          << QString::number(channel.latencyPercentileMs(0.95f), 'f', 2) << ","
+          << QString::number(channel.maxLatencyMs, 'f', 2) << ","
+          << channel.deadlineMisses << ","
+          << channel.maxLatenessMs;
+      for (int bucket = 0; bucket < ChannelStatistics::s_latencyBucketCount; bucket++)
+      {
+        out << "," << channel.latencyHistogram[bucket];
+      }
+      out << Qt::endl;
+    }
+  }
+
+  out << Qt::endl;
+  return (out.status() == QTextStream::Ok);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include "commonunits.h"
+
+/**
+ * Counters for the reads of one sample type.
+ */
+struct ChannelStatistics
+{
+  static const int s_latencyBucketCount = 12;
+
+  unsigned int successes = 0;
+  unsigned int failures = 0;
+  unsigned int latencyHistogram[s_latencyBucketCount] = {};
+  double totalLatencyMs = 0.0;
+  float maxLatencyMs = 0.0f;
+  float rateHz = 0.0f;
+  unsigned int deadlineMisses = 0;
+  qint64 maxLatenessMs = 0;
+
+  float meanLatencyMs() const;
+  float latencyPercentileMs(float fraction) const;
+};
+
+/**
+ * Everything that is known about the performance of the link at one moment.
+ */
+struct LinkStatisticsSnapshot
+{
+  ChannelStatistics channels[SampleType_NumSampleTypes];
+  unsigned int passCount = 0;
+  double totalPassMs = 0.0;
+  float maxPassMs = 0.0f;
+  float lastPassMs = 0.0f;
+  int queueDepth = 0;
+  int maxQueueDepth = 0;
+  unsigned int droppedFrames = 0;
+  qint64 elapsedMs = 0;
+
+  float meanPassMs() const;
+};
+
+/**
+ * Lightweight instrumentation of the polling loop: a latency histogram and
+ * success/failure counts for each sample type, the time taken by each pass of
+ * the loop, and the depth of the request queue. Recording is done on the
+ * interface thread; snapshots may be taken from any thread.
+ */
+class LinkStatistics
+{
+public:
+  LinkStatistics();
+
+  static float bucketUpperBoundMs(int bucket);
+
+  void reset();
+  void recordRead(SampleType type, bool success, float latencyMs);
+  void recordPass(float durationMs);
+  void recordQueueDepth(int depth);
+  LinkStatisticsSnapshot snapshot() const;
+
+  void setReportPath(const QString& path);
+  QString reportPath() const;
+  static bool writeReport(const LinkStatisticsSnapshot& stats, const QString& path);
+
+private:
+  mutable QMutex m_lock;
+  QElapsedTimer m_clock;
+  LinkStatisticsSnapshot m_stats;
+  QString m_reportPath;
+};
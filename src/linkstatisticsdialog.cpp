@@ -0,0 +1,154 @@
+#include <QDir>
+#include <QHeaderView>
+#include "linkstatisticsdialog.h"
+#include "samplesettings.h"
+
+/**
+ * Constructor. Creates the widgets; the statistics are refreshed periodically
+ * while the dialog is visible.
+ */
+LinkStatisticsDialog::LinkStatisticsDialog(QString title, CUXInterface& cux, QWidget* parent) :
+  QDialog(parent),
+  m_cux(cux),
+  m_reportPath(QString("logs") + QDir::separator() + "linkstats.txt")
+{
+  this->setWindowTitle(title);
+  setupWidgets();
+
+  m_refreshTimer.setInterval(500);
+  connect(&m_refreshTimer, &QTimer::timeout, this, &LinkStatisticsDialog::refresh);
+}
+
+/**
+ * Creates the table of per-reading statistics and the summary labels, and
+ * places them on the form.
+ */
+void LinkStatisticsDialog::setupWidgets()
+{
+  const QStringList headers = { "Reading", "Rate (Hz)", "Reads", "Failures",
+                                "Mean (ms)", "95% (ms)", "Max (ms)", "Late", "Max late (ms)" };
+
+  m_grid = new QGridLayout(this);
+
+  m_table = new QTableWidget(SampleType_NumSampleTypes, headers.size(), this);
+  m_table->setHorizontalHeaderLabels(headers);
+  m_table->verticalHeader()->hide();
+  m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_table->setSelectionMode(QAbstractItemView::NoSelection);
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    setCell(type, 0, SampleSettings::shortName((SampleType)type));
+  }
+  m_table->resizeColumnsToContents();
+  m_table->setMinimumWidth(m_table->horizontalHeader()->length() + 40);
+  m_grid->addWidget(m_table, 0, 0, 1, 3);
+
+  m_passLabel = new QLabel(this);
+  m_queueLabel = new QLabel(this);
+  m_droppedLabel = new QLabel(this);
+  m_grid->addWidget(m_passLabel, 1, 0, 1, 3);
+  m_grid->addWidget(m_queueLabel, 2, 0, 1, 3);
+  m_grid->addWidget(m_droppedLabel, 3, 0, 1, 3);
+
+  m_reportCheckbox = new QCheckBox(QString("Append statistics to %1 when disconnecting").arg(m_reportPath), this);
+  m_reportCheckbox->setChecked(!m_cux.getStatisticsReportPath().isEmpty());
+  m_grid->addWidget(m_reportCheckbox, 4, 0, 1, 3);
+  connect(m_reportCheckbox, &QCheckBox::toggled, this, &LinkStatisticsDialog::onReportToggled);
+
+  m_resetButton = new QPushButton("Reset", this);
+  m_grid->addWidget(m_resetButton, 5, 1);
+  connect(m_resetButton, &QPushButton::clicked, this, &LinkStatisticsDialog::onResetClicked);
+
+  m_closeButton = new QPushButton("Close", this);
+  m_grid->addWidget(m_closeButton, 5, 2);
+  connect(m_closeButton, &QPushButton::clicked, this, &QDialog::accept);
+}
+
+/**
+ * Sets the text of a table cell, creating the cell if necessary.
+ */
+void LinkStatisticsDialog::setCell(int row, int column, const QString& text)
+{
+  QTableWidgetItem* item = m_table->item(row, column);
+
+  if (item == nullptr)
+  {
+    item = new QTableWidgetItem();
+    item->setTextAlignment((column == 0) ? (Qt::AlignLeft | Qt::AlignVCenter) : (Qt::AlignRight | Qt::AlignVCenter));
+    m_table->setItem(row, column, item);
+  }
+
+  item->setText(text);
+}
+
+/**
+ * Starts refreshing the statistics when the dialog is shown.
+ */
+void LinkStatisticsDialog::showEvent(QShowEvent* event)
+{
+  QDialog::showEvent(event);
+  refresh();
+  m_refreshTimer.start();
+}
+
+/**
+ * Stops refreshing the statistics when the dialog is hidden.
+ */
+void LinkStatisticsDialog::hideEvent(QHideEvent* event)
+{
+  m_refreshTimer.stop();
+  QDialog::hideEvent(event);
+}
+
+/**
+ * Takes a fresh snapshot of the statistics and updates the display.
+ */
+void LinkStatisticsDialog::refresh()
+{
+  const LinkStatisticsSnapshot stats = m_cux.getLinkStatistics();
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const ChannelStatistics& channel = stats.channels[type];
+    const unsigned int reads = channel.successes + channel.failures;
+
+    setCell(type, 1, QString::number(channel.rateHz, 'f', 1));
+    setCell(type, 2, QString::number(reads));
+    setCell(type, 3, QString::number(channel.failures));
+    setCell(type, 4, (reads > 0) ? QString::number(channel.meanLatencyMs(), 'f', 1) : "-");
+    setCell(type, 5, (reads > 0) ? QString::number(channel.latencyPercentileMs(0.95f), 'f', 1) : "-");
+    setCell(type, 6, (reads > 0) ? QString::number(channel.maxLatencyMs, 'f', 1) : "-");
+    setCell(type, 7, QString::number(channel.deadlineMisses));
+    setCell(type, 8, (reads > 0) ? QString::number(channel.maxLatenessMs) : "-");
+  }
+
+  m_passLabel->setText(QString("Loop passes: %1 (mean %2 ms, last %3 ms, max %4 ms)")
+                       .arg(stats.passCount)
+                       .arg(stats.meanPassMs(), 0, 'f', 1)
+                       .arg(stats.lastPassMs, 0, 'f', 1)
+                       .arg(stats.maxPassMs, 0, 'f', 1));
+  m_queueLabel->setText(QString("Request queue depth: %1 (max %2)").arg(stats.queueDepth).arg(stats.maxQueueDepth));
+  m_droppedLabel->setText(QString("Dropped display frames: %1").arg(stats.droppedFrames));
+}
+
+/**
+ * Clears the statistics.
+ */
+void LinkStatisticsDialog::onResetClicked()
+{
+  m_cux.resetLinkStatistics();
+  refresh();
+}
+
+/**
+ * Turns the report file on or off.
+ */
+void LinkStatisticsDialog::onReportToggled(bool checked)
+{
+  if (checked && !QDir("logs").exists())
+  {
+    QDir().mkdir("logs");
+  }
+
+  m_cux.setStatisticsReportPath(checked ? m_reportPath : QString());
+}
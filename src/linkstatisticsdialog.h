@@ -0,0 +1,50 @@
+#pragma once
+#include <QDialog>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLabel>
+#include <QString>
+#include <QTableWidget>
+#include <QTimer>
+#include "cuxinterface.h"
+
+/**
+ * A dialog that shows live statistics for the serial link: the rate, read
+ * time, and failures of each reading, along with the time taken by each pass
+ * of the polling loop and the depth of the request queue.
+ */
+class LinkStatisticsDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  LinkStatisticsDialog(QString title, CUXInterface& cux, QWidget* parent = nullptr);
+
+protected:
+  void showEvent(QShowEvent* event);
+  void hideEvent(QHideEvent* event);
+
+private slots:
+  void refresh();
+  void onResetClicked();
+  void onReportToggled(bool checked);
+
+private:
+  CUXInterface& m_cux;
+  QTimer m_refreshTimer;
+
+  QGridLayout* m_grid;
+  QTableWidget* m_table;
+  QLabel* m_passLabel;
+  QLabel* m_queueLabel;
+  QLabel* m_droppedLabel;
+  QCheckBox* m_reportCheckbox;
+  QPushButton* m_resetButton;
+  QPushButton* m_closeButton;
+
+  const QString m_reportPath;
+
+  void setupWidgets();
+  void setCell(int row, int column, const QString& text);
+};
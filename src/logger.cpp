@@ -5,14 +5,39 @@
 
 /**
  * Constructor. Sets the 14CUX interface class pointer as
- * well as log directory and log file extension.
+ * well as log directory and log file extension, and starts the thread that
+ * writes the data log.
  */
-Logger::Logger(CUXInterface& cuxIFace, OptionsDialog& options) :
+Logger::Logger(CUXInterface& cuxIFace) :
   m_cux(cuxIFace),
-  m_options(options),
   m_logExtension(".txt"),
+  m_binaryLogExtension(".rglog"),
   m_logDir("logs")
 {
+  m_writer = new LogWriter();
+  m_writer->moveToThread(&m_writerThread);
+  m_writerThread.setObjectName("LogWriter");
+  m_writerThread.start();
+}
+
+/**
+ * Destructor. Closes the log and stops the writer thread.
+ */
+Logger::~Logger()
+{
+  closeLog();
+  m_writerThread.quit();
+  m_writerThread.wait();
+  delete m_writer;
+}
+
+/**
+ * Sets the log format, timestamp style, and road speed adjustment. A change
+ * of format takes effect the next time a log is opened.
+ */
+void Logger::setSettings(const LogSettings& settings)
+{
+  m_settings = settings;
 }
 
 /**
@@ -24,37 +49,37 @@ bool Logger::openLog(QString fileName)
   bool success = false;
   unsigned int fmRow = 0;
   unsigned int fmCol = 0;
-  bool alreadyExists = false;
 
-  m_lastAttemptedLog = m_logDir + QDir::separator() + fileName + m_logExtension;
+  const bool binary = (m_settings.format == LogFormat_Binary);
+
+  m_lastAttemptedLog = m_logDir + QDir::separator() + fileName + (binary ? m_binaryLogExtension : m_logExtension);
   m_lastAttemptedStaticLog = m_logDir + QDir::separator() + fileName + "_static" + m_logExtension;
 
   // if the 'logs' directory exists, or if we're able to create it...
-  if (!m_logFile.isOpen() && (QDir(m_logDir).exists() || QDir().mkdir(m_logDir)))
+  if (!m_logOpen && (QDir(m_logDir).exists() || QDir().mkdir(m_logDir)))
   {
-    // set the name of the log file and open it for writing
-    alreadyExists = QFileInfo(m_lastAttemptedLog).exists();
-    m_logFile.setFileName(m_lastAttemptedLog);
-
-    if (m_logFile.open(QFile::WriteOnly | QFile::Append))
+    // The data log is opened by the writer in its own thread. This waits for
+    // it, but only behind whatever the writer is doing for a previous log.
+    const QString path = m_lastAttemptedLog;
+    const LogSettings settings = m_settings;
+    QMetaObject::invokeMethod(m_writer, [this, path, settings, &success]()
     {
-      m_logFileStream.setDevice(&m_logFile);
+      success = m_writer->open(path, settings);
+    }, Qt::BlockingQueuedConnection);
 
-      if (!alreadyExists)
-      {
-        m_logFileStream << "#datetime,roadSpeed,engineSpeed,waterTemp,fuelTemp," <<
-                        "throttlePos,mafPercentage,idleBypassPos,mainVoltage," <<
-                        "currentFuelMapIndex,currentFuelMapRow,currentFuelMapCol," <<
-                        "targetIdle,lambdaTrimOdd,lambdaTrimEven,pulseWidthMs" << Qt::endl;
-      }
+    m_logOpen = success;
+    m_droppedAtOpen = m_writer->getDroppedFrames();
 
-      success = true;
+    // a segmented log is identified by its manifest, which lists the segments
+    if (success && ((m_settings.segmentMaxMB > 0) || (m_settings.segmentMaxMinutes > 0)))
+    {
+      m_lastAttemptedLog = LogManifest::pathFor(m_lastAttemptedLog);
     }
 
     // if that worked, attempt to open a file for the static/one-shot data
     if (success)
     {
-      alreadyExists = QFileInfo(m_lastAttemptedStaticLog).exists();
+      const bool alreadyExists = QFileInfo(m_lastAttemptedStaticLog).exists();
       m_staticLogFile.setFileName(m_lastAttemptedStaticLog);
 
       if (m_staticLogFile.open(QFile::WriteOnly | QFile::Append))
@@ -86,52 +111,39 @@ bool Logger::openLog(QString fileName)
 }
 
 /**
- * Close the log file(s).
+ * Close the log file(s). Any frames still queued for the data log are written
+ * out first.
  */
 void Logger::closeLog()
 {
-  m_logFile.close();
+  if (m_logOpen)
+  {
+    QMetaObject::invokeMethod(m_writer, [this]()
+    {
+      m_writer->close();
+    }, Qt::BlockingQueuedConnection);
+    m_logOpen = false;
+  }
+
   m_staticLogFile.close();
 }
 
 /**
- * Commands the logger to query the 14CUX interface for the currently
- * buffered data, and write it to the file.
+ * Hands a single frame of data (captured by the 14CUX interface during one
+ * poll) to the writer thread. This never waits for the disk; if the writer
+ * has fallen too far behind, the frame is dropped and counted.
+ * @param frame Set of readings to log
  */
-void Logger::logData()
+void Logger::logData(const TelemetryFrame& frame)
 {
   // One of two flags that must be set to allow logging of static data.
   // This one keeps track of the receipt of firmware build identifiers (tune ID, etc.)
   // and the other keeps track of the receipt of actual fuel map data.
   m_miscStaticDataIsReady = true;
 
-  if (m_logFile.isOpen() && (m_logFileStream.status() == QTextStream::Ok))
+  if (m_logOpen)
   {
-    double roadSpeed = m_cux.getRoadSpeed();
-
-    if (m_options.getSpeedoAdjust())
-    {
-      roadSpeed *= m_options.getSpeedoMultiplier();
-      roadSpeed += m_options.getSpeedoOffset();
-    }
-
-    m_logFileStream << getTimestamp(false) << ","
-                    << roadSpeed << ","
-                    << m_cux.getEngineSpeedRPM() << ","
-                    << m_cux.getCoolantTemp() << ","
-                    << m_cux.getFuelTemp() << ","
-                    << m_cux.getThrottlePos() << ","
-                    << m_cux.getMAFReading() << ","
-                    << m_cux.getIdleBypassPos() << ","
-                    << m_cux.getMainVoltage() << ","
-                    << m_cux.getCurrentFuelMapIndex() << ","
-                    << getRowWithWeighting() << ","
-                    << getColWithWeighting() << ","
-                    << m_cux.getTargetIdleSpeed() << ","
-                    << m_cux.getLambdaTrimOdd() << ","
-                    << m_cux.getLambdaTrimEven() << ","
-                    << m_cux.getInjectorPulseWidthMs()
-                    << Qt::endl;
+    m_writer->enqueue(frame);
   }
 
   if (!m_staticDataLogged &&
@@ -144,42 +156,33 @@ void Logger::logData()
 }
 
 /**
- * Gets the timestamp string used when writing a log entry.
- * Depending on settings, the time will either represent an absolute time or
- * a delta time (against the time of the first log entry.)
+ * Returns the number of frames that have been dropped from the current (or
+ * most recent) log because the writer couldn't keep up.
  */
-QString Logger::getTimestamp(bool forStaticData)
+unsigned int Logger::getDroppedFrames() const
 {
-  if (!m_timeOfFirstDataSet)
-  {
-    m_timeOfFirstData = QDateTime::currentDateTime();
-    m_timeOfFirstDataSet = true;
-  }
-
-  QString timestampStr;
+  return m_writer->getDroppedFrames() - m_droppedAtOpen;
+}
 
-  if (m_options.logTimesMsecsFromZero())
-  {
-    if (forStaticData)
-    {
-      // Because the static data does not reflect parametrics that change dynamically
-      // while the engine is running, we will always log it with a timestamp of 0
-      // milliseconds in this mode.
-      timestampStr = "0";
-    }
-    else
-    {
-      // For dynamic data, log it with the displacement in milliseconds from the
-      // first dynamic data log entry.
-      timestampStr = QString::number(m_timeOfFirstData.msecsTo(QDateTime::currentDateTime()));
-    }
-  }
-  else
-  {
-    timestampStr = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz");
-  }
+/**
+ * Indicates whether frames are arriving faster than the writer can store
+ * them, i.e. that the queue is at least three-quarters full.
+ */
+bool Logger::isBackedUp() const
+{
+  return (m_writer->getBacklog() >= (logQueueSize * 3 / 4));
+}
 
-  return timestampStr;
+/**
+ * Gets the timestamp string used when writing the static data log. Because
+ * the static data does not reflect parametrics that change dynamically while
+ * the engine is running, it is always logged with a timestamp of 0
+ * milliseconds when times are logged relative to the first entry.
+ */
+QString Logger::getStaticTimestamp() const
+{
+  return m_settings.timesMsecsFromZero ? QString("0") :
+         QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz");
 }
 
 /**
@@ -202,7 +205,7 @@ void Logger::logStaticData(unsigned int fuelMapId)
       mafCoTrim = m_cux.getCOTrimVoltage();
     }
 
-    m_staticLogFileStream << getTimestamp(true) << ","
+    m_staticLogFileStream << getStaticTimestamp() << ","
                           << Qt::uppercasedigits
                           << m_cux.getTune() << ","
                           << Qt::hex << m_cux.getIdent() << ","
@@ -251,26 +254,6 @@ void Logger::onFuelMapDataReady(unsigned int fuelMapId)
   }
 }
 
-/**
- * Gets a fractional value that describes the current fuel map row index considering
- * the weighting.
- */
-float Logger::getRowWithWeighting() const
-{
-  return ((float)m_cux.getFuelMapRowIndex() +
-          ((float)m_cux.getFuelMapRowWeighting() / 16.0));
-}
-
-/**
- * Gets a fractional value that describes the current fuel map column index considering
- * the weighting.
- */
-float Logger::getColWithWeighting() const
-{
-  return ((float)m_cux.getFuelMapColumnIndex() +
-          ((float)m_cux.getFuelMapColumnWeighting() / 16.0));
-}
-
 /**
  * Returns the full path to the last log that we attempted to open.
  * @return Full path to last log file
@@ -3,43 +3,48 @@
 #include <QFile>
 #include <QTextStream>
 #include <QMutex>
-#include <QDateTime>
+#include <QThread>
 #include "cuxinterface.h"
-#include "optionsdialog.h"
+#include "logsettings.h"
+#include "logwriter.h"
+#include "telemetryframe.h"
 
 class Logger
 {
 public:
-  Logger(CUXInterface& cuxIFace, OptionsDialog& options);
+  Logger(CUXInterface& cuxIFace);
+  ~Logger();
+  void setSettings(const LogSettings& settings);
   bool openLog(QString fileName);
   void closeLog();
-  void logData();
+  void logData(const TelemetryFrame& frame);
   QString getLogPath();
   void onFuelMapDataReady(unsigned int fuelMapId);
   void onDisconnect();
+  unsigned int getDroppedFrames() const;
+  bool isBackedUp() const;
 
 private:
   bool m_fuelMapDataIsReady = false;
   bool m_miscStaticDataIsReady = false;
   unsigned int m_fuelMapId = 0;
   CUXInterface& m_cux;
-  OptionsDialog& m_options;
+  LogSettings m_settings;
   QString m_logExtension;
+  QString m_binaryLogExtension;
   QString m_logDir;
-  QFile m_logFile;
+  QThread m_writerThread;
+  LogWriter* m_writer = nullptr;
+  bool m_logOpen = false;
+  unsigned int m_droppedAtOpen = 0;
   QFile m_staticLogFile;
-  QTextStream m_logFileStream;
   QTextStream m_staticLogFileStream;
   QString m_lastAttemptedLog;
   QString m_lastAttemptedStaticLog;
   bool m_staticDataLogged = false;
-  QDateTime m_timeOfFirstData;
-  bool m_timeOfFirstDataSet = false;
 
   void logStaticData(unsigned int fuelMapId);
-  float getRowWithWeighting() const;
-  float getColWithWeighting() const;
-  QString getTimestamp(bool forStaticData);
+  QString getStaticTimestamp() const;
 
   QMutex m_staticLogLock;
 };
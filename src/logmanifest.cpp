@@ -0,0 +1,150 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include "logmanifest.h"
+
+/**
+ * Returns the path of the manifest for a log; logs/name.txt has its manifest
+ * in logs/name.manifest.
+ */
+QString LogManifest::pathFor(const QString& logPath)
+{
+  const QFileInfo info(logPath);
+  return info.path() + QDir::separator() + info.completeBaseName() + ".manifest";
+}
+
+/**
+ * Indicates whether a path names a manifest rather than a log file.
+ */
+bool LogManifest::isManifest(const QString& path)
+{
+  return (QFileInfo(path).suffix() == "manifest");
+}
+
+/**
+ * Returns the path of a numbered segment of a log; the first segment of
+ * logs/name.txt is logs/name_001.txt.
+ */
+QString LogManifest::segmentPath(const QString& logPath, int number)
+{
+  const QFileInfo info(logPath);
+  return QString("%1%2%3_%4.%5").arg(info.path()).arg(QDir::separator()).arg(info.completeBaseName())
+                                .arg(number, 3, 10, QChar('0')).arg(info.suffix());
+}
+
+/**
+ * Reads the manifest at the given path. A manifest that doesn't exist yet is
+ * loaded as an empty list of segments.
+ * @return True if the manifest was read or didn't exist, false if it couldn't be read
+ */
+bool LogManifest::load(const QString& path)
+{
+  m_path = path;
+  m_segments.clear();
+
+  QSettings manifest(path, QSettings::IniFormat);
+  const int count = manifest.beginReadArray("Segments");
+
+  for (int i = 0; i < count; i++)
+  {
+    manifest.setArrayIndex(i);
+
+    LogSegment segment;
+    segment.fileName = manifest.value("File").toString();
+    segment.firstTimestampMs = manifest.value("FirstTimestampMs", 0).toLongLong();
+    segment.lastTimestampMs = manifest.value("LastTimestampMs", 0).toLongLong();
+    segment.frames = manifest.value("Frames", 0).toULongLong();
+    segment.closed = manifest.value("Closed", true).toBool();
+    m_segments.append(segment);
+  }
+
+  manifest.endArray();
+
+  return (manifest.status() == QSettings::NoError);
+}
+
+/**
+ * Writes the manifest out in full. QSettings replaces the file in a single
+ * step, so a reader never sees a partly written manifest.
+ * @return True on success, false otherwise
+ */
+bool LogManifest::save() const
+{
+  QSettings manifest(m_path, QSettings::IniFormat);
+
+  manifest.remove("Segments");
+  manifest.beginWriteArray("Segments", m_segments.size());
+
+  for (int i = 0; i < m_segments.size(); i++)
+  {
+    const LogSegment& segment = m_segments.at(i);
+
+    manifest.setArrayIndex(i);
+    manifest.setValue("File", segment.fileName);
+    manifest.setValue("FirstTimestampMs", segment.firstTimestampMs);
+    manifest.setValue("LastTimestampMs", segment.lastTimestampMs);
+    manifest.setValue("Frames", segment.frames);
+    manifest.setValue("Closed", segment.closed);
+  }
+
+  manifest.endArray();
+  manifest.sync();
+
+  return (manifest.status() == QSettings::NoError);
+}
+
+/**
+ * Returns the full path to one of the segments.
+ */
+QString LogManifest::filePath(const LogSegment& segment) const
+{
+  return QFileInfo(m_path).path() + QDir::separator() + segment.fileName;
+}
+
+/**
+ * Returns the path from which a segment can be read. Segments compressed
+ * with zstd can't be read directly, but one that has since been decompressed
+ * next to its compressed copy (with "zstd -d", for example) is read from
+ * there.
+ * @return Path to the segment, or an empty string if it is only available compressed
+ */
+QString LogManifest::readablePath(const LogSegment& segment) const
+{
+  const QString path = filePath(segment);
+  const QString compressedSuffix(".zst");
+
+  if (path.endsWith(compressedSuffix))
+  {
+    const QString decompressed = path.left(path.size() - compressedSuffix.size());
+    return QFileInfo::exists(decompressed) ? decompressed : QString();
+  }
+
+  return path;
+}
+
+/**
+ * Returns the segments that may hold frames from the given period, in the
+ * order in which they were written. A segment that is still open (or was
+ * never closed) is always included, since its recorded span may be behind
+ * what is actually in the file.
+ * @param fromMs Start of the period (msecs since epoch)
+ * @param toMs End of the period (msecs since epoch)
+ */
+QVector<LogSegment> LogManifest::segmentsBetween(qint64 fromMs, qint64 toMs) const
+{
+  QVector<LogSegment> matches;
+
+  foreach (const LogSegment& segment, m_segments)
+  {
+    const bool overlaps = (segment.frames > 0) &&
+                          (segment.firstTimestampMs <= toMs) &&
+                          (segment.lastTimestampMs >= fromMs);
+
+    if (overlaps || !segment.closed)
+    {
+      matches.append(segment);
+    }
+  }
+
+  return matches;
+}
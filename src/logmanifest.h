@@ -0,0 +1,55 @@
+#pragma once
+#include <QString>
+#include <QVector>
+
+/**
+ * One file of a segmented log, and the span of time that it covers.
+ */
+struct LogSegment
+{
+  QString fileName;              // name of the file, in the manifest's directory
+  qint64 firstTimestampMs = 0;   // wall-clock time of the first frame (msecs since epoch)
+  qint64 lastTimestampMs = 0;    // wall-clock time of the last frame
+  quint64 frames = 0;
+  bool closed = false;           // false while the segment is still being written
+};
+
+/**
+ * Index of the segments that make up a log that is split across several
+ * files. The manifest sits next to the segments as <name>.manifest, in INI
+ * format, and records the time span of each segment so that a tool looking
+ * for a particular period only needs to open the segments that cover it.
+ */
+class LogManifest
+{
+public:
+  static QString pathFor(const QString& logPath);
+  static QString segmentPath(const QString& logPath, int number);
+  static bool isManifest(const QString& path);
+
+  bool load(const QString& path);
+  bool save() const;
+
+  QString path() const
+  {
+    return m_path;
+  }
+
+  QVector<LogSegment>& segments()
+  {
+    return m_segments;
+  }
+
+  const QVector<LogSegment>& segments() const
+  {
+    return m_segments;
+  }
+
+  QString filePath(const LogSegment& segment) const;
+  QString readablePath(const LogSegment& segment) const;
+  QVector<LogSegment> segmentsBetween(qint64 fromMs, qint64 toMs) const;
+
+private:
+  QString m_path;
+  QVector<LogSegment> m_segments;
+};
@@ -0,0 +1,854 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QList>
+#include <QSaveFile>
+#include "logreplaysource.h"
+#include "logmanifest.h"
+
+namespace
+{
+// Powers of ten that are exactly representable as doubles. A decimal with no
+// more than 15 significant digits, scaled by one of these, converts with a
+// single correctly rounded operation.
+const double s_exactPow10[] =
+  { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+}
+
+/**
+ * Destructor. Closes the segments of a segmented log.
+ */
+LogReplaySource::~LogReplaySource()
+{
+  closeSegments();
+}
+
+/**
+ * Opens a log for replay, determining its format from its content, and loads
+ * or builds the seek index. If a static data log with the matching name
+ * exists, the tune ID and fuel map contents are loaded from it as well.
+ * @param path Path to the log file (.txt or .rglog), or to the manifest of a
+ *  segmented log
+ * @return True if the log was opened and contains at least one record
+ */
+bool LogReplaySource::open(const QString& path)
+{
+  QFile probe(path);
+  bool status = false;
+
+  m_index.clear();
+  m_havePending = false;
+  m_error.clear();
+  closeSegments();
+
+  if (LogManifest::isManifest(path))
+  {
+    return openManifest(path);
+  }
+
+  if (!probe.open(QFile::ReadOnly))
+  {
+    m_error = probe.errorString();
+    return false;
+  }
+
+  m_binary = (probe.peek(4) == "RGBL");
+  probe.close();
+
+  if (m_binary)
+  {
+    status = m_binaryReader.open(path);
+    if (!status)
+    {
+      m_error = m_binaryReader.errorString();
+    }
+  }
+  else
+  {
+    status = mapTextLog(path);
+  }
+
+  if (status && !loadIndex(path))
+  {
+    status = m_binary ? buildBinaryIndex() : buildTextIndex();
+    if (status && !m_index.isEmpty())
+    {
+      saveIndex(path);
+    }
+  }
+
+  if (status && m_index.isEmpty())
+  {
+    m_error = "Log contains no data";
+    status = false;
+  }
+
+  if (status)
+  {
+    loadStaticData(path);
+    seek(m_firstTimestampMs);
+  }
+
+  return status;
+}
+
+/**
+ * Opens every segment listed in a manifest, in the order in which they were
+ * written. A segment that is still being written may not hold any frames
+ * yet, and is left out. Segments that have been compressed can't be read, so
+ * opening a log with a compressed segment fails unless that segment has been
+ * decompressed next to its compressed copy.
+ * @param path Path to the manifest
+ * @return True if the segments were opened and at least one holds a record
+ */
+bool LogReplaySource::openManifest(const QString& path)
+{
+  LogManifest manifest;
+
+  if (!manifest.load(path))
+  {
+    m_error = "Unable to read the log manifest";
+    return false;
+  }
+
+  const QVector<LogSegment> segments = manifest.segmentsBetween(std::numeric_limits<qint64>::min(),
+                                                                std::numeric_limits<qint64>::max());
+
+  foreach (const LogSegment& segment, segments)
+  {
+    const QString segmentPath = manifest.readablePath(segment);
+
+    if (segmentPath.isEmpty())
+    {
+      m_error = QString("%1 is compressed; compressed segments must be decompressed (with zstd -d) "
+                        "before they can be read").arg(segment.fileName);
+      break;
+    }
+
+    LogReplaySource* source = new LogReplaySource();
+    if (source->open(segmentPath))
+    {
+      m_segments.append(source);
+    }
+    else
+    {
+      const bool empty = (segment.frames == 0);
+
+      if (!empty)
+      {
+        m_error = segment.fileName + ": " + source->errorString();
+      }
+      delete source;
+
+      if (!empty)
+      {
+        break;
+      }
+    }
+  }
+
+  if (m_error.isEmpty() && m_segments.isEmpty())
+  {
+    m_error = "Log contains no data";
+  }
+
+  if (!m_error.isEmpty())
+  {
+    closeSegments();
+    return false;
+  }
+
+  m_firstTimestampMs = m_segments.first()->firstTimestampMs();
+  m_lastTimestampMs = m_segments.last()->lastTimestampMs();
+  loadStaticData(path);
+  seek(m_firstTimestampMs);
+
+  return true;
+}
+
+/**
+ * Closes the segments of a segmented log, if one is open.
+ */
+void LogReplaySource::closeSegments()
+{
+  qDeleteAll(m_segments);
+  m_segments.clear();
+  m_segment = 0;
+}
+
+/**
+ * Maps a text log into memory. If the file can't be mapped, it is read into
+ * memory instead.
+ */
+bool LogReplaySource::mapTextLog(const QString& path)
+{
+  m_textFile.close();
+  m_textFile.setFileName(path);
+  m_textCopy.clear();
+  m_text = nullptr;
+  m_textSize = 0;
+  m_textPos = 0;
+  m_cachedDateValid = false;
+
+  if (!m_textFile.open(QFile::ReadOnly))
+  {
+    m_error = m_textFile.errorString();
+    return false;
+  }
+
+  m_textSize = m_textFile.size();
+  m_text = (m_textSize > 0) ? (const char*)m_textFile.map(0, m_textSize) : nullptr;
+
+  if (m_text == nullptr)
+  {
+    m_textCopy = m_textFile.readAll();
+    m_text = m_textCopy.constData();
+    m_textSize = m_textCopy.size();
+  }
+
+  return true;
+}
+
+/**
+ * Builds a sparse index of a text log. Rather than reading every line, this
+ * jumps through the file in fixed steps and parses only the timestamp of the
+ * first complete line after each step, so the cost depends on the size of the
+ * file in steps rather than in lines. The last stretch is read line by line
+ * to find the final timestamp.
+ */
+bool LogReplaySource::buildTextIndex()
+{
+  const char* line = nullptr;
+  int length = 0;
+  qint64 offset = 0;
+  qint64 timestampMs = 0;
+
+  for (qint64 step = 0; step < m_textSize; step += s_textIndexStrideBytes)
+  {
+    // start from the beginning of the first line that begins at or after the step
+    m_textPos = step;
+    if (step > 0)
+    {
+      const void* newline = memchr(m_text + step - 1, '\n', (size_t)(m_textSize - step + 1));
+      if (newline == nullptr)
+      {
+        break;
+      }
+      m_textPos = ((const char*)newline - m_text) + 1;
+    }
+
+    // take the first line in this step that has a usable timestamp
+    while ((m_textPos < step + s_textIndexStrideBytes) && nextTextLine(offset, line, length))
+    {
+      const char* comma = (const char*)memchr(line, ',', length);
+
+      if ((line[0] != '#') && (comma != nullptr) && parseTextTimestamp(line, (int)(comma - line), timestampMs))
+      {
+        if (m_index.isEmpty() || (offset > m_index.last().offset))
+        {
+          m_index.append({ timestampMs, offset });
+        }
+        break;
+      }
+    }
+  }
+
+  if (!m_index.isEmpty())
+  {
+    m_firstTimestampMs = m_index.first().timestampMs;
+    m_lastTimestampMs = m_index.last().timestampMs;
+
+    m_textPos = m_index.last().offset;
+    while (nextTextLine(offset, line, length))
+    {
+      const char* comma = (const char*)memchr(line, ',', length);
+
+      if ((line[0] != '#') && (comma != nullptr) && parseTextTimestamp(line, (int)(comma - line), timestampMs))
+      {
+        m_lastTimestampMs = timestampMs;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Reads through the whole binary log once, noting the timestamp and offset of
+ * every keyframe (which is where decoding can be restarted.)
+ */
+bool LogReplaySource::buildBinaryIndex()
+{
+  BinaryLogRecord rec;
+  qint64 offset = m_binaryReader.pos();
+  bool first = true;
+
+  while (m_binaryReader.readNext(rec))
+  {
+    if (first)
+    {
+      m_firstTimestampMs = rec.timestampMs;
+      first = false;
+    }
+    m_lastTimestampMs = rec.timestampMs;
+
+    if (rec.keyframe)
+    {
+      m_index.append({ rec.timestampMs, offset });
+    }
+    offset = m_binaryReader.pos();
+  }
+
+  return true;
+}
+
+/**
+ * Returns the path of the file in which the index of a log is kept.
+ */
+QString LogReplaySource::indexPathFor(const QString& path)
+{
+  return path + ".idx";
+}
+
+/**
+ * Loads the index saved by an earlier open of the same log. The index is
+ * only used if the log's size and modification time haven't changed since
+ * it was saved.
+ * @return True if a current index was loaded
+ */
+bool LogReplaySource::loadIndex(const QString& path)
+{
+  QFile file(indexPathFor(path));
+  const QFileInfo logInfo(path);
+  bool status = false;
+
+  if (file.open(QFile::ReadOnly))
+  {
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 logSize = 0;
+    qint64 logModifiedMs = 0;
+    bool binary = false;
+    quint32 count = 0;
+
+    in.setVersion(QDataStream::Qt_5_12);
+    in >> magic >> version >> logSize >> logModifiedMs >> binary;
+
+    if ((magic == s_indexMagic) &&
+        (version == s_indexVersion) &&
+        (logSize == logInfo.size()) &&
+        (logModifiedMs == logInfo.lastModified().toMSecsSinceEpoch()) &&
+        (binary == m_binary))
+    {
+      in >> m_firstTimestampMs >> m_lastTimestampMs >> count;
+
+      m_index.resize(count);
+      for (quint32 idx = 0; idx < count; idx++)
+      {
+        in >> m_index[idx].timestampMs >> m_index[idx].offset;
+      }
+
+      status = (in.status() == QDataStream::Ok);
+    }
+  }
+
+  if (!status)
+  {
+    m_index.clear();
+  }
+
+  return status;
+}
+
+/**
+ * Saves the index next to the log. Failure (on read-only media, for example)
+ * only means that the index will be built again next time.
+ */
+void LogReplaySource::saveIndex(const QString& path) const
+{
+  QSaveFile file(indexPathFor(path));
+  const QFileInfo logInfo(path);
+
+  if (file.open(QFile::WriteOnly))
+  {
+    QDataStream out(&file);
+
+    out.setVersion(QDataStream::Qt_5_12);
+    out << s_indexMagic << s_indexVersion
+        << (qint64)logInfo.size() << (qint64)logInfo.lastModified().toMSecsSinceEpoch() << m_binary
+        << m_firstTimestampMs << m_lastTimestampMs << (quint32)m_index.size();
+
+    foreach (const IndexEntry& entry, m_index)
+    {
+      out << entry.timestampMs << entry.offset;
+    }
+
+    file.commit();
+  }
+}
+
+/**
+ * Positions the replay so that the next frame returned is the first one
+ * recorded at or after the given time. The index is used to jump close to
+ * the target, so only a handful of records need to be decoded.
+ * @param timestampMs Target time, on the same clock as the log's timestamps
+ */
+bool LogReplaySource::seek(qint64 timestampMs)
+{
+  if (!m_segments.isEmpty())
+  {
+    // start in the last segment that begins at or before the target
+    m_segment = 0;
+    while ((m_segment + 1 < m_segments.size()) &&
+           (m_segments.at(m_segment + 1)->firstTimestampMs() <= timestampMs))
+    {
+      m_segment++;
+    }
+
+    return m_segments.at(m_segment)->seek(timestampMs);
+  }
+
+  if (m_index.isEmpty())
+  {
+    return false;
+  }
+
+  // find the last index entry at or before the target
+  auto it = std::upper_bound(m_index.constBegin(), m_index.constEnd(), timestampMs,
+                             [](qint64 ts, const IndexEntry& entry) { return ts < entry.timestampMs; });
+  if (it != m_index.constBegin())
+  {
+    --it;
+  }
+
+  bool ok = true;
+  if (m_binary)
+  {
+    ok = m_binaryReader.seek(it->offset);
+  }
+  else
+  {
+    m_textPos = it->offset;
+  }
+  m_havePending = false;
+
+  if (ok)
+  {
+    while (readRaw(m_pending))
+    {
+      if (m_pending.timestampMs >= timestampMs)
+      {
+        m_havePending = true;
+        break;
+      }
+    }
+  }
+
+  return ok;
+}
+
+/**
+ * Returns the next recorded frame.
+ * @return True if a frame was returned; false at the end of the log
+ */
+bool LogReplaySource::next(TelemetryFrame& frame)
+{
+  if (!m_segments.isEmpty())
+  {
+    while (!m_segments.at(m_segment)->next(frame))
+    {
+      if (m_segment + 1 >= m_segments.size())
+      {
+        return false;
+      }
+
+      m_segment++;
+      m_segments.at(m_segment)->seek(m_segments.at(m_segment)->firstTimestampMs());
+    }
+
+    return true;
+  }
+
+  if (m_havePending)
+  {
+    frame = m_pending;
+    m_havePending = false;
+    return true;
+  }
+
+  return readRaw(frame);
+}
+
+/**
+ * Decodes the next record from the log file, skipping any lines that cannot
+ * be parsed.
+ */
+bool LogReplaySource::readRaw(TelemetryFrame& frame)
+{
+  if (m_binary)
+  {
+    BinaryLogRecord rec;
+    if (m_binaryReader.readNext(rec))
+    {
+      frameFromBinaryRecord(rec, frame);
+      return true;
+    }
+  }
+  else
+  {
+    qint64 offset = 0;
+    const char* line = nullptr;
+    int length = 0;
+
+    while (nextTextLine(offset, line, length))
+    {
+      if ((line[0] != '#') && parseTextLine(line, length, frame))
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Finds the next non-blank line of a text log, starting at the current read
+ * position, and moves the position past it. The line points into the mapped
+ * log, and excludes the line ending.
+ * @param offset Set to the offset of the start of the line
+ * @param line Set to the start of the line
+ * @param length Set to the length of the line
+ * @return True if a line was found; false at the end of the log
+ */
+bool LogReplaySource::nextTextLine(qint64& offset, const char*& line, int& length)
+{
+  while (m_textPos < m_textSize)
+  {
+    const char* start = m_text + m_textPos;
+    const char* newline = (const char*)memchr(start, '\n', (size_t)(m_textSize - m_textPos));
+    const char* end = newline ? newline : (m_text + m_textSize);
+
+    offset = m_textPos;
+    m_textPos = (end - m_text) + (newline ? 1 : 0);
+
+    while ((end > start) && ((end[-1] == '\r') || (end[-1] == ' ')))
+    {
+      end--;
+    }
+
+    if (end > start)
+    {
+      line = start;
+      length = (int)(end - start);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Parses the timestamp field of a text log line, which is either an absolute
+ * date/time or a number of milliseconds from the start of the log. The time
+ * of the most recent whole second is kept, so that a run of lines from the
+ * same second needs only the milliseconds to be parsed.
+ */
+bool LogReplaySource::parseTextTimestamp(const char* field, int length, qint64& timestampMs)
+{
+  const int prefixLength = (int)sizeof(m_cachedDatePrefix);
+  bool ok = false;
+
+  if (memchr(field, '_', length) == nullptr)
+  {
+    double value = 0.0;
+    ok = parseNumber(field, length, value);
+    timestampMs = (qint64)value;
+  }
+  else if ((length == prefixLength + 4) && (field[prefixLength] == '.'))
+  {
+    const int msecs = parseInt(field + prefixLength + 1, 3);
+
+    if (!m_cachedDateValid || (memcmp(field, m_cachedDatePrefix, prefixLength) != 0))
+    {
+      const QDateTime time =
+        QDateTime::fromString(QString::fromLatin1(field, prefixLength), "yyyy-MM-dd_hh:mm:ss");
+
+      m_cachedDateValid = time.isValid();
+      m_cachedDateMs = time.toMSecsSinceEpoch();
+      memcpy(m_cachedDatePrefix, field, prefixLength);
+    }
+
+    ok = m_cachedDateValid;
+    timestampMs = m_cachedDateMs + msecs;
+  }
+  else
+  {
+    const QDateTime time = QDateTime::fromString(QString::fromLatin1(field, length), "yyyy-MM-dd_hh:mm:ss.zzz");
+    ok = time.isValid();
+    timestampMs = time.toMSecsSinceEpoch();
+  }
+
+  return ok;
+}
+
+/**
+ * Parses a line of the text log into a frame. The columns are in the order
+ * written by TextLogFormatter::appendFrame().
+ */
+bool LogReplaySource::parseTextLine(const char* line, int length, TelemetryFrame& frame)
+{
+  const int fieldCount = 16;
+  const char* fields[fieldCount];
+  int lengths[fieldCount];
+  int count = 0;
+  const char* start = line;
+  const char* end = line + length;
+
+  while ((count < fieldCount) && (start <= end))
+  {
+    const char* comma = (const char*)memchr(start, ',', end - start);
+    const char* fieldEnd = comma ? comma : end;
+
+    fields[count] = start;
+    lengths[count] = (int)(fieldEnd - start);
+    count++;
+    start = fieldEnd + 1;
+  }
+
+  if ((count < fieldCount) || !parseTextTimestamp(fields[0], lengths[0], frame.timestampMs))
+  {
+    return false;
+  }
+
+  double values[fieldCount] = { 0.0 };
+  for (int idx = 1; idx < fieldCount; idx++)
+  {
+    parseNumber(fields[idx], lengths[idx], values[idx]);
+  }
+
+  const float row = (float)values[10];
+  const float col = (float)values[11];
+
+  frame.roadSpeed = (unsigned int)qRound(values[1]);
+  frame.engineSpeedRPM = parseInt(fields[2], lengths[2]);
+  frame.coolantTemp = parseInt(fields[3], lengths[3]);
+  frame.fuelTemp = parseInt(fields[4], lengths[4]);
+  frame.throttlePos = (float)values[5];
+  frame.mafReading = (float)values[6];
+  frame.idleBypassPos = (float)values[7];
+  frame.mainVoltage = (float)values[8];
+  frame.currentFuelMapIndex = parseInt(fields[9], lengths[9]);
+  frame.fuelMapRowIndex = (int)row;
+  frame.fuelMapRowWeighting = qRound((row - (int)row) * 16.0);
+  frame.fuelMapColumnIndex = (int)col;
+  frame.fuelMapColumnWeighting = qRound((col - (int)col) * 16.0);
+  frame.targetIdleSpeed = parseInt(fields[12], lengths[12]);
+  frame.lambdaTrimOdd = parseInt(fields[13], lengths[13]);
+  frame.lambdaTrimEven = parseInt(fields[14], lengths[14]);
+  frame.injectorPulseWidthMs = (float)values[15];
+
+  return true;
+}
+
+/**
+ * Parses a decimal number in place. Plain decimals of up to 15 significant
+ * digits (which is everything the logger writes, apart from the odd value in
+ * exponent form) are converted directly; anything else is handed to Qt's
+ * conversion.
+ * @return True if the field held a number, false otherwise (in which case
+ *  the value is set to 0)
+ */
+bool LogReplaySource::parseNumber(const char* field, int length, double& value)
+{
+  int idx = 0;
+  bool negative = false;
+  bool point = false;
+  bool anyDigits = false;
+  quint64 mantissa = 0;
+  int significant = 0;
+  int scale = 0;
+
+  if ((idx < length) && ((field[idx] == '-') || (field[idx] == '+')))
+  {
+    negative = (field[idx] == '-');
+    idx++;
+  }
+
+  for (; idx < length; idx++)
+  {
+    const char c = field[idx];
+
+    if ((c >= '0') && (c <= '9'))
+    {
+      anyDigits = true;
+      mantissa = mantissa * 10 + (c - '0');
+      if (mantissa > 0)
+      {
+        significant++;
+      }
+      if (point)
+      {
+        scale--;
+      }
+      if (significant > 15)
+      {
+        break;
+      }
+    }
+    else if ((c == '.') && !point)
+    {
+      point = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if ((idx < length) || !anyDigits || (scale < -22))
+  {
+    bool ok = false;
+    value = QByteArray::fromRawData(field, length).toDouble(&ok);
+    return ok;
+  }
+
+  value = (double)mantissa / s_exactPow10[-scale];
+  if (negative)
+  {
+    value = -value;
+  }
+
+  return true;
+}
+
+/**
+ * Parses a decimal integer in place, returning 0 if the field isn't one.
+ */
+int LogReplaySource::parseInt(const char* field, int length)
+{
+  int idx = 0;
+  bool negative = false;
+  qint64 value = 0;
+
+  if ((idx < length) && (field[idx] == '-'))
+  {
+    negative = true;
+    idx++;
+  }
+
+  if (idx == length)
+  {
+    return 0;
+  }
+
+  for (; idx < length; idx++)
+  {
+    if ((field[idx] < '0') || (field[idx] > '9') || (value > 0x7fffffff))
+    {
+      return 0;
+    }
+    value = value * 10 + (field[idx] - '0');
+  }
+
+  return (int)(negative ? -value : value);
+}
+
+/**
+ * Fills a frame from a binary log record, matching the columns by name so that
+ * logs with a different set of columns can still be replayed.
+ */
+void LogReplaySource::frameFromBinaryRecord(const BinaryLogRecord& rec, TelemetryFrame& frame) const
+{
+  const BinaryLogHeader& header = m_binaryReader.header();
+
+  frame.timestampMs = rec.timestampMs;
+
+  for (int idx = 0; idx < header.columns.size(); idx++)
+  {
+    const BinaryLogColumn& column = header.columns.at(idx);
+    const qint32 raw = rec.values.at(idx);
+    const float value = (column.type == BinaryLogValueType_Float) ? BinaryLogFormat::bitsToFloat(raw) : (float)raw;
+    const QString& name = column.name;
+
+    if (name == "roadSpeed")                { frame.roadSpeed = (unsigned int)raw; }
+    else if (name == "engineSpeed")         { frame.engineSpeedRPM = raw; }
+    else if (name == "waterTemp")           { frame.coolantTemp = raw; }
+    else if (name == "fuelTemp")            { frame.fuelTemp = raw; }
+    else if (name == "throttlePos")         { frame.throttlePos = value; }
+    else if (name == "mafPercentage")       { frame.mafReading = value; }
+    else if (name == "idleBypassPos")       { frame.idleBypassPos = value; }
+    else if (name == "mainVoltage")         { frame.mainVoltage = value; }
+    else if (name == "currentFuelMapIndex") { frame.currentFuelMapIndex = raw; }
+    else if (name == "targetIdle")          { frame.targetIdleSpeed = raw; }
+    else if (name == "lambdaTrimOdd")
+    {
+      frame.lambdaTrimOdd = raw;
+      frame.lambdaTrimType = (column.source == SampleType_LambdaTrimLong) ?
+                             C14CUX_LambdaTrimType_LongTerm : C14CUX_LambdaTrimType_ShortTerm;
+    }
+    else if (name == "lambdaTrimEven")      { frame.lambdaTrimEven = raw; }
+    else if (name == "pulseWidthMs")        { frame.injectorPulseWidthMs = value; }
+    else if (name == "currentFuelMapRow")
+    {
+      frame.fuelMapRowIndex = (int)value;
+      frame.fuelMapRowWeighting = qRound((value - (int)value) * 16.0);
+    }
+    else if (name == "currentFuelMapCol")
+    {
+      frame.fuelMapColumnIndex = (int)value;
+      frame.fuelMapColumnWeighting = qRound((value - (int)value) * 16.0);
+    }
+  }
+}
+
+/**
+ * Loads the first entry of the static data log (<name>_static.txt) that
+ * accompanies the log being replayed, if there is one.
+ */
+void LogReplaySource::loadStaticData(const QString& path)
+{
+  const QFileInfo info(path);
+  QFile staticFile(info.path() + "/" + info.completeBaseName() + "_static.txt");
+
+  m_static = ReplayStaticData();
+
+  if (!staticFile.open(QFile::ReadOnly))
+  {
+    return;
+  }
+
+  while (!staticFile.atEnd() && !m_static.valid)
+  {
+    const QByteArray line = staticFile.readLine().trimmed();
+    const QList<QByteArray> fields = line.split(',');
+    const int firstMapField = 9;
+
+    if (line.startsWith('#') || (fields.size() < firstMapField + 128))
+    {
+      continue;
+    }
+
+    // The tune number is written in decimal, and the remaining identifiers in hex.
+    m_static.tune = fields.at(1).toUShort(nullptr, 10);
+    m_static.ident = fields.at(2).toUShort(nullptr, 16);
+    m_static.checksumFixer = fields.at(3).toUShort(nullptr, 16);
+    m_static.fuelMapId = fields.at(4).toUInt(nullptr, 10);
+    m_static.fuelMapAdjFactor = fields.at(5).toUShort(nullptr, 16);
+    m_static.rowScaler = fields.at(6).toUShort(nullptr, 16);
+    m_static.mafScaler = fields.at(7).toUShort(nullptr, 16);
+
+    m_static.fuelMap.resize(128);
+    for (int idx = 0; idx < 128; idx++)
+    {
+      m_static.fuelMap[idx] = (char)fields.at(firstMapField + idx).toUShort(nullptr, 16);
+    }
+
+    m_static.valid = true;
+  }
+}
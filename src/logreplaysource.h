@@ -0,0 +1,117 @@
+#pragma once
+#include <QString>
+#include <QFile>
+#include <QVector>
+#include <QByteArray>
+#include "binarylogreader.h"
+#include "telemetryframe.h"
+
+/**
+ * One-shot data (tune ID, fuel map contents, etc.) recovered from the static
+ * data log that accompanies a recorded session.
+ */
+struct ReplayStaticData
+{
+  bool valid = false;
+  uint16_t tune = 0;
+  uint16_t ident = 0;
+  uint8_t checksumFixer = 0;
+  unsigned int fuelMapId = 0;
+  uint16_t fuelMapAdjFactor = 0;
+  uint8_t rowScaler = 0;
+  uint16_t mafScaler = 0;
+  QByteArray fuelMap;
+};
+
+/**
+ * Reads frames back out of a log written by Logger, either in the text (CSV)
+ * format or the binary format. A sparse index of timestamps and file offsets
+ * is built when the log is first opened and saved alongside it (as
+ * <log>.idx), so that seeking to any point in a long log only requires
+ * decoding a few records, and reopening it requires no scan at all.
+ *
+ * Text logs are memory-mapped. Indexing one only parses the timestamp of a
+ * line every few tens of kilobytes, and the remaining fields of a line are
+ * only parsed when the frame is actually read.
+ *
+ * A segmented log is opened through its manifest; each segment is read by a
+ * LogReplaySource of its own, and they are played back in the order in which
+ * they were written as though they were one log.
+ */
+class LogReplaySource
+{
+public:
+  ~LogReplaySource();
+
+  bool open(const QString& path);
+  bool next(TelemetryFrame& frame);
+  bool seek(qint64 timestampMs);
+
+  qint64 firstTimestampMs() const
+  {
+    return m_firstTimestampMs;
+  }
+
+  qint64 lastTimestampMs() const
+  {
+    return m_lastTimestampMs;
+  }
+
+  const ReplayStaticData& staticData() const
+  {
+    return m_static;
+  }
+
+  QString errorString() const
+  {
+    return m_error;
+  }
+
+private:
+  struct IndexEntry
+  {
+    qint64 timestampMs;
+    qint64 offset;
+  };
+
+  static const qint64 s_textIndexStrideBytes = 64 * 1024;
+  static const quint32 s_indexMagic = 0x58494752; // "RGIX"
+  static const quint32 s_indexVersion = 1;
+
+  bool m_binary = false;
+  QFile m_textFile;
+  const char* m_text = nullptr;
+  qint64 m_textSize = 0;
+  qint64 m_textPos = 0;
+  QByteArray m_textCopy;
+  char m_cachedDatePrefix[19];
+  qint64 m_cachedDateMs = 0;
+  bool m_cachedDateValid = false;
+  BinaryLogReader m_binaryReader;
+  QVector<IndexEntry> m_index;
+  qint64 m_firstTimestampMs = 0;
+  qint64 m_lastTimestampMs = 0;
+  bool m_havePending = false;
+  TelemetryFrame m_pending;
+  ReplayStaticData m_static;
+  QString m_error;
+  QVector<LogReplaySource*> m_segments;
+  int m_segment = 0;
+
+  bool openManifest(const QString& path);
+  void closeSegments();
+  bool mapTextLog(const QString& path);
+  bool buildTextIndex();
+  bool buildBinaryIndex();
+  bool loadIndex(const QString& path);
+  void saveIndex(const QString& path) const;
+  static QString indexPathFor(const QString& path);
+  bool readRaw(TelemetryFrame& frame);
+  bool nextTextLine(qint64& offset, const char*& line, int& length);
+  bool parseTextLine(const char* line, int length, TelemetryFrame& frame);
+  bool parseTextTimestamp(const char* field, int length, qint64& timestampMs);
+  static bool parseNumber(const char* field, int length, double& value);
+  static int parseInt(const char* field, int length);
+  void frameFromBinaryRecord(const BinaryLogRecord& rec, TelemetryFrame& frame) const;
+  void loadStaticData(const QString& path);
+};
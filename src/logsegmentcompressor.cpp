@@ -0,0 +1,120 @@
+#include <QByteArray>
+#include <QFile>
+#include <QSaveFile>
+#ifdef ROVERGAUGE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "logsegmentcompressor.h"
+
+/**
+ * Constructor.
+ * @param path Path to the segment to compress
+ * @param onFinished Called from the pool thread with the result once the
+ *  segment has been compressed (or has failed to be)
+ */
+LogSegmentCompressor::LogSegmentCompressor(const QString& path, std::function<void(bool)> onFinished) :
+  m_path(path),
+  m_onFinished(onFinished)
+{
+}
+
+/**
+ * Returns true if this build is able to compress segments.
+ */
+bool LogSegmentCompressor::isAvailable()
+{
+#ifdef ROVERGAUGE_HAVE_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Returns the path to which a segment is compressed.
+ */
+QString LogSegmentCompressor::compressedPath(const QString& path)
+{
+  return path + ".zst";
+}
+
+/**
+ * Compresses the segment and removes the uncompressed original.
+ */
+void LogSegmentCompressor::run()
+{
+  const bool status = compressFile(m_path, compressedPath(m_path));
+
+  if (status)
+  {
+    QFile::remove(m_path);
+  }
+
+  if (m_onFinished)
+  {
+    m_onFinished(status);
+  }
+}
+
+/**
+ * Compresses a file as a single zstd frame, streaming it through fixed-size
+ * buffers so that large segments don't have to be held in memory. The output
+ * only replaces the destination once it is complete.
+ * @return True on success, false otherwise
+ */
+bool LogSegmentCompressor::compressFile(const QString& srcPath, const QString& dstPath)
+{
+#ifdef ROVERGAUGE_HAVE_ZSTD
+  QFile in(srcPath);
+  QSaveFile out(dstPath);
+  bool status = false;
+
+  if (in.open(QFile::ReadOnly) && out.open(QFile::WriteOnly))
+  {
+    ZSTD_CCtx* ctx = ZSTD_createCCtx();
+    QByteArray inBuf((int)ZSTD_CStreamInSize(), 0);
+    QByteArray outBuf((int)ZSTD_CStreamOutSize(), 0);
+    bool lastChunk = false;
+
+    ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, s_compressionLevel);
+    ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+    status = true;
+
+    while (status && !lastChunk)
+    {
+      const qint64 bytesRead = in.read(inBuf.data(), inBuf.size());
+      if (bytesRead < 0)
+      {
+        status = false;
+        break;
+      }
+
+      lastChunk = in.atEnd();
+      ZSTD_inBuffer input = { inBuf.constData(), (size_t)bytesRead, 0 };
+      bool chunkDone = false;
+
+      while (status && !chunkDone)
+      {
+        ZSTD_outBuffer output = { outBuf.data(), (size_t)outBuf.size(), 0 };
+        const size_t remaining =
+          ZSTD_compressStream2(ctx, &output, &input, lastChunk ? ZSTD_e_end : ZSTD_e_continue);
+
+        status = !ZSTD_isError(remaining) &&
+                 (out.write(outBuf.constData(), (qint64)output.pos) == (qint64)output.pos);
+
+        // the final chunk is done once the frame has been completely flushed
+        chunkDone = lastChunk ? (remaining == 0) : (input.pos == input.size);
+      }
+    }
+
+    ZSTD_freeCCtx(ctx);
+    status = status && out.commit();
+  }
+
+  return status;
+#else
+  Q_UNUSED(srcPath)
+  Q_UNUSED(dstPath)
+  return false;
+#endif
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <functional>
+#include <QRunnable>
+#include <QString>
+
+/**
+ * Compresses a closed log segment with zstd, in a thread pool, so that the
+ * thread writing the log never waits on it. The compressed copy is written
+ * next to the original as <segment>.zst, and the original is removed once
+ * the copy is complete. Compression is only available if RoverGauge was
+ * built with zstd.
+ */
+class LogSegmentCompressor : public QRunnable
+{
+public:
+  LogSegmentCompressor(const QString& path, std::function<void(bool)> onFinished);
+
+  static bool isAvailable();
+  static QString compressedPath(const QString& path);
+  static bool compressFile(const QString& srcPath, const QString& dstPath);
+
+  void run() override;
+
+private:
+  static const int s_compressionLevel = 3;
+
+  QString m_path;
+  std::function<void(bool)> m_onFinished;
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include "commonunits.h"
+
+/**
+ * Settings that affect how readings are written to the log. These are kept
+ * separate from the options dialog so that the logger can also be driven
+ * without any widget code (as in the command-line logger.)
+ */
+struct LogSettings
+{
+  LogFormat format = LogFormat_Text;
+  bool timesMsecsFromZero = false;
+  bool speedoAdjust = false;
+  double speedoMultiplier = 1.0;
+  int speedoOffset = 0;
+  LogSyncPolicy syncPolicy = LogSyncPolicy_Interval;
+  int syncIntervalMs = 5000;
+  int segmentMaxMB = 0;          // start a new segment at this size (0: never)
+  int segmentMaxMinutes = 0;     // start a new segment at this age (0: never)
+  bool compressSegments = false;
+};
@@ -0,0 +1,458 @@
+#include <QFileInfo>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "logsegmentcompressor.h"
+#include "logwriter.h"
+
+/**
+ * Constructor. Wakeups may be requested from the producer's thread; the
+ * queued connection ensures that the queue is always drained in the writer's
+ * own thread.
+ */
+LogWriter::LogWriter(QObject* parent) :
+  QObject(parent)
+{
+  connect(this, &LogWriter::wakeRequested, this, &LogWriter::onWake, Qt::QueuedConnection);
+}
+
+/**
+ * Destructor. Waits for any segments that are still being compressed.
+ */
+LogWriter::~LogWriter()
+{
+  close();
+  m_compressPool.waitForDone();
+}
+
+/**
+ * Hands a frame to the writer. Must only be called from a single producer
+ * thread. The writer is woken early if the queue is more than half full.
+ * @return True if the frame was queued; false if the queue was full and the
+ *  frame was dropped
+ */
+bool LogWriter::enqueue(const TelemetryFrame& frame)
+{
+  const bool status = m_frames.push(frame);
+
+  if ((m_frames.size() >= (logQueueSize / 2)) && !m_wakePending.exchange(true))
+  {
+    emit wakeRequested();
+  }
+
+  return status;
+}
+
+/**
+ * Opens the data log for appending, writing the column header if the file is
+ * new. If the settings call for a segmented log, the path is used as the
+ * pattern for the names of the segments and of the manifest, and numbering
+ * continues after any segments that were written to the same log before.
+ * Must be called in the writer's thread.
+ * @param path Path to the log file
+ * @param settings Format, timestamp style, speedometer adjustment, sync
+ *  policy, and segmenting
+ * @return True if the log was opened; false otherwise
+ */
+bool LogWriter::open(const QString& path, const LogSettings& settings)
+{
+  bool success = false;
+
+  // discard anything left over from a previous log
+  TelemetryFrame stale;
+  while (m_frames.pop(stale))
+  {
+  }
+
+  m_settings = settings;
+  m_textFormatter.setSettings(settings);
+  m_logPath = path;
+  m_segmented = (m_settings.segmentMaxMB > 0) || (m_settings.segmentMaxMinutes > 0);
+
+  if (m_drainTimer == nullptr)
+  {
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setInterval(s_drainIntervalMs);
+    connect(m_drainTimer, &QTimer::timeout, this, &LogWriter::onDrainTimer);
+  }
+
+  if (m_segmented)
+  {
+    QMutexLocker lock(&m_manifestLock);
+    m_manifest.load(LogManifest::pathFor(path));
+
+    // a segment left open by a previous session will never be written again
+    for (LogSegment& segment : m_manifest.segments())
+    {
+      segment.closed = true;
+    }
+  }
+
+  success = m_segmented ? openSegment() : openFile(path);
+
+  if (success)
+  {
+    m_sinceFlush.start();
+    m_sinceSync.start();
+    m_drainTimer->start();
+  }
+
+  return success;
+}
+
+/**
+ * Writes out every queued frame and closes the data log. Must be called in
+ * the writer's thread.
+ */
+void LogWriter::close()
+{
+  if (m_drainTimer)
+  {
+    m_drainTimer->stop();
+  }
+
+  if (m_logFile.isOpen() || m_binaryLog.isOpen())
+  {
+    drain();
+
+    if (m_segmented)
+    {
+      closeSegment();
+    }
+    else
+    {
+      closeFile();
+    }
+  }
+}
+
+/**
+ * Opens a single file of the data log.
+ * @param path Path to the file
+ * @return True if the file was opened; false otherwise
+ */
+bool LogWriter::openFile(const QString& path)
+{
+  bool success = false;
+
+  if (m_settings.format == LogFormat_Binary)
+  {
+    // The binary log carries the speedometer adjustment and timestamp style
+    // in its header, so that a later conversion to text matches what the
+    // text logger would have written.
+    quint16 flags = 0;
+    if (m_settings.speedoAdjust)
+    {
+      flags |= BinaryLogFlag_SpeedoAdjust;
+    }
+    if (m_settings.timesMsecsFromZero)
+    {
+      flags |= BinaryLogFlag_TimesFromZero;
+    }
+
+    success = m_binaryLog.open(path, flags, m_settings.speedoMultiplier, m_settings.speedoOffset);
+  }
+  else
+  {
+    const bool alreadyExists = QFileInfo(path).exists();
+    m_logFile.setFileName(path);
+
+    // rows are collected in our own buffer, so QFile's buffer would only add a copy
+    if (m_logFile.open(QFile::WriteOnly | QFile::Append | QFile::Unbuffered))
+    {
+      m_textBuffer.resize(0);
+      m_textBuffer.reserve(s_textFlushBytes + 1024);
+
+      if (!alreadyExists)
+      {
+        m_textBuffer.append(TextLogFormatter::header);
+      }
+
+      success = true;
+    }
+  }
+
+  return success;
+}
+
+/**
+ * Writes out everything that is buffered for the current file and closes it.
+ */
+void LogWriter::closeFile()
+{
+  flush(true);
+  m_logFile.close();
+  m_binaryLog.close();
+}
+
+/**
+ * Starts the next segment of a segmented log, and adds it to the manifest.
+ * @return True if the segment was opened; false otherwise
+ */
+bool LogWriter::openSegment()
+{
+  QString path;
+  bool success = false;
+
+  {
+    QMutexLocker lock(&m_manifestLock);
+    path = LogManifest::segmentPath(m_logPath, m_manifest.segments().size() + 1);
+  }
+
+  if (openFile(path))
+  {
+    m_segment = LogSegment();
+    m_segment.fileName = QFileInfo(path).fileName();
+    m_sinceSegmentStart.start();
+
+    QMutexLocker lock(&m_manifestLock);
+    m_manifest.segments().append(m_segment);
+    m_manifest.save();
+    success = true;
+  }
+
+  return success;
+}
+
+/**
+ * Closes the current segment of a segmented log and records its final span
+ * in the manifest. If compression is enabled, the segment is then handed to
+ * the compression pool.
+ */
+void LogWriter::closeSegment()
+{
+  const QString path = m_manifest.filePath(m_segment);
+
+  closeFile();
+  m_segment.closed = true;
+  saveManifest();
+
+  if (m_settings.compressSegments && LogSegmentCompressor::isAvailable())
+  {
+    const QString manifestPath = m_manifest.path();
+    const QString fileName = m_segment.fileName;
+
+    m_compressPool.start(new LogSegmentCompressor(path, [this, manifestPath, fileName](bool success)
+    {
+      onSegmentCompressed(manifestPath, fileName, success);
+    }));
+  }
+}
+
+/**
+ * Indicates whether the current segment has reached its size or age limit.
+ * A segment that has no frames yet is never closed, so that a long gap in
+ * the data doesn't leave a trail of empty segments.
+ */
+bool LogWriter::isRotationDue() const
+{
+  bool due = false;
+
+  if (m_segment.frames > 0)
+  {
+    const qint64 size = m_binaryLog.isOpen() ? m_binaryLog.size() : (m_logFile.size() + m_textBuffer.size());
+
+    due = ((m_settings.segmentMaxMB > 0) && (size >= m_settings.segmentMaxMB * s_bytesPerMB)) ||
+          ((m_settings.segmentMaxMinutes > 0) &&
+           (m_sinceSegmentStart.elapsed() >= m_settings.segmentMaxMinutes * 60000LL));
+  }
+
+  return due;
+}
+
+/**
+ * Copies the span of the current segment into the manifest and writes the
+ * manifest out.
+ */
+void LogWriter::saveManifest()
+{
+  QMutexLocker lock(&m_manifestLock);
+
+  if (!m_manifest.segments().isEmpty())
+  {
+    m_manifest.segments().last() = m_segment;
+  }
+  m_manifest.save();
+}
+
+/**
+ * Records the compressed name of a segment in its manifest. Called from the
+ * compression pool; the log that the segment belongs to may have been closed
+ * (and another opened) in the meantime.
+ * @param manifestPath Path to the manifest of the log that the segment belongs to
+ * @param fileName Name of the segment before it was compressed
+ * @param success True if the segment was compressed
+ */
+void LogWriter::onSegmentCompressed(const QString& manifestPath, const QString& fileName, bool success)
+{
+  if (success)
+  {
+    QMutexLocker lock(&m_manifestLock);
+    LogManifest other;
+    const bool current = (m_manifest.path() == manifestPath);
+    LogManifest& manifest = current ? m_manifest : other;
+
+    if (!current)
+    {
+      other.load(manifestPath);
+    }
+
+    for (LogSegment& segment : manifest.segments())
+    {
+      if (segment.fileName == fileName)
+      {
+        segment.fileName = LogSegmentCompressor::compressedPath(fileName);
+      }
+    }
+    manifest.save();
+  }
+}
+
+/**
+ * Drains the queue as soon as it passes the halfway mark.
+ */
+void LogWriter::onWake()
+{
+  m_wakePending = false;
+  drain();
+}
+
+/**
+ * Drains the queue periodically, and writes out and syncs the buffered data
+ * when it is due.
+ */
+void LogWriter::onDrainTimer()
+{
+  drain();
+
+  if (m_segmented && isRotationDue())
+  {
+    closeSegment();
+    if (!openSegment())
+    {
+      m_drainTimer->stop();
+    }
+  }
+  else if (m_sinceFlush.elapsed() >= s_flushIntervalMs)
+  {
+    flush(false);
+  }
+}
+
+/**
+ * Encodes every frame that is waiting in the queue. The encoded records are
+ * buffered, and only reach the file when flush() is called or the buffer fills.
+ */
+void LogWriter::drain()
+{
+  TelemetryFrame frame;
+
+  while (m_frames.pop(frame))
+  {
+    writeFrame(frame);
+  }
+}
+
+/**
+ * Writes buffered records to the file, and forces them onto the disk if the
+ * sync policy calls for it.
+ * @param closing True if the log is about to be closed, in which case any
+ *  policy other than "none" syncs regardless of the interval
+ */
+void LogWriter::flush(bool closing)
+{
+  int handle = -1;
+
+  if (m_binaryLog.isOpen())
+  {
+    m_binaryLog.flush();
+    handle = m_binaryLog.handle();
+  }
+  else if (m_logFile.isOpen())
+  {
+    writeTextBuffer();
+    handle = m_logFile.handle();
+  }
+
+  m_sinceFlush.restart();
+
+  const bool syncDue =
+    (m_settings.syncPolicy == LogSyncPolicy_EveryFlush) ||
+    ((m_settings.syncPolicy == LogSyncPolicy_Interval) &&
+     (closing || (m_sinceSync.elapsed() >= m_settings.syncIntervalMs)));
+
+  if (syncDue && (handle >= 0))
+  {
+    syncToDisk(handle);
+    m_sinceSync.restart();
+
+    // keep the manifest's span of the open segment as current as the data on disk
+    if (m_segmented && !closing)
+    {
+      saveManifest();
+    }
+  }
+}
+
+/**
+ * Writes a single frame of data to the log.
+ * @param frame Set of readings to log
+ */
+void LogWriter::writeFrame(const TelemetryFrame& frame)
+{
+  const bool open = m_binaryLog.isOpen() || m_logFile.isOpen();
+
+  if (m_binaryLog.isOpen())
+  {
+    m_binaryLog.append(frame);
+  }
+  else if (m_logFile.isOpen())
+  {
+    m_textFormatter.appendFrame(m_textBuffer, frame);
+
+    if (m_textBuffer.size() >= s_textFlushBytes)
+    {
+      writeTextBuffer();
+    }
+  }
+
+  if (open && m_segmented)
+  {
+    if (m_segment.frames == 0)
+    {
+      m_segment.firstTimestampMs = frame.timestampMs;
+    }
+    m_segment.lastTimestampMs = frame.timestampMs;
+    m_segment.frames++;
+  }
+}
+
+/**
+ * Writes the formatted rows of the text log to the file. The buffer keeps its
+ * capacity, so it doesn't need to grow again for the next rows.
+ */
+void LogWriter::writeTextBuffer()
+{
+  if (!m_textBuffer.isEmpty())
+  {
+    m_logFile.write(m_textBuffer);
+    m_textBuffer.resize(0);
+  }
+}
+
+/**
+ * Asks the operating system to write a file's data through to the storage
+ * device.
+ * @param handle File descriptor of the open file
+ * @return True on success, false otherwise
+ */
+bool LogWriter::syncToDisk(int handle)
+{
+#ifdef WIN32
+  return (_commit(handle) == 0);
+#else
+  return (fsync(handle) == 0);
+#endif
+}
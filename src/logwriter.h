@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "binarylogwriter.h"
+#include "logmanifest.h"
+#include "logsettings.h"
+#include "spscring.h"
+#include "telemetryframe.h"
+#include "textlogformatter.h"
+
+static const unsigned int logQueueSize = 1024;
+
+/**
+ * Writes frames to the data log from a thread of its own, so that a slow
+ * storage device can't hold up the thread that produces the frames. Frames
+ * are handed over through a fixed-size lock-free queue; if the writer falls
+ * so far behind that the queue fills, new frames are dropped and counted
+ * instead of blocking the producer. The writer drains the queue a few times
+ * a second and lets the text or binary encoder collect the records into large
+ * writes, and can be told how often to force the data onto the disk.
+ *
+ * For long sessions, the log can be split into segments that are closed once
+ * they reach a given size or age. The segments are listed, with the span of
+ * time each covers, in a manifest alongside them, and closed segments can be
+ * compressed in the background.
+ */
+class LogWriter : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LogWriter(QObject* parent = nullptr);
+  ~LogWriter();
+
+  bool enqueue(const TelemetryFrame& frame);
+
+  unsigned int getBacklog() const
+  {
+    return m_frames.size();
+  }
+
+  unsigned int getDroppedFrames() const
+  {
+    return m_frames.droppedCount();
+  }
+
+  bool open(const QString& path, const LogSettings& settings);
+  void close();
+
+signals:
+  void wakeRequested();
+
+private slots:
+  void onWake();
+  void onDrainTimer();
+
+private:
+  static const int s_drainIntervalMs = 250;
+  static const qint64 s_flushIntervalMs = 1000;
+  static const int s_textFlushBytes = 64 * 1024;
+
+  static const qint64 s_bytesPerMB = 1024 * 1024;
+
+  SpscRing<TelemetryFrame, logQueueSize> m_frames;
+  std::atomic<bool> m_wakePending{false};
+  QTimer* m_drainTimer = nullptr;
+  QElapsedTimer m_sinceFlush;
+  QElapsedTimer m_sinceSync;
+  LogSettings m_settings;
+  QFile m_logFile;
+  QByteArray m_textBuffer;
+  TextLogFormatter m_textFormatter;
+  BinaryLogWriter m_binaryLog;
+
+  QString m_logPath;
+  bool m_segmented = false;
+  LogManifest m_manifest;
+  QMutex m_manifestLock;
+  LogSegment m_segment;
+  QElapsedTimer m_sinceSegmentStart;
+  QThreadPool m_compressPool;
+
+  bool openFile(const QString& path);
+  void closeFile();
+  bool openSegment();
+  void closeSegment();
+  bool isRotationDue() const;
+  void saveManifest();
+  void onSegmentCompressed(const QString& manifestPath, const QString& fileName, bool success);
+  void drain();
+  void writeFrame(const TelemetryFrame& frame);
+  void flush(bool closing);
+  void writeTextBuffer();
+  static bool syncToDisk(int handle);
+};
@@ -2,7 +2,9 @@
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 #include <QString>
+#include <QTextStream>
 #include "mainwindow.h"
+#include "logreplaysource.h"
 
 int main(int argc, char* argv[])
 {
@@ -28,6 +30,15 @@ int main(int argc, char* argv[])
   QCommandLineOption simulatedData
     ({"s", "simulated"}, "Simulate a connection to the ECU. Generally used only for internal RoverGauge testing.");
   simulatedData.setFlags(QCommandLineOption::HiddenFromHelp);
+  QCommandLineOption simulationSeedOption
+    ("sim-seed", "Seed for the simulated engine; the same seed gives the same readings.", "n", "1");
+  simulationSeedOption.setFlags(QCommandLineOption::HiddenFromHelp);
+  const QCommandLineOption replayOption
+    ({"r", "replay"}, "Replay a previously recorded log (.txt, .rglog, or the .manifest of a segmented log) instead of connecting to the ECU.", "file");
+  const QCommandLineOption replaySpeedOption
+    ("replay-speed", "Replay speed: 1, 2, 10, or 'max' to replay as fast as possible (default 1.)", "speed", "1");
+  const QCommandLineOption replayStartOption
+    ("replay-start", "Start the replay at this many seconds into the log.", "secs", "0");
 
   parser.addHelpOption();
   parser.addVersionOption();
@@ -36,13 +47,48 @@ int main(int argc, char* argv[])
   parser.addOption(fullscreenOption);
   parser.addOption(doublebaudOption);
   parser.addOption(simulatedData);
+  parser.addOption(simulationSeedOption);
+  parser.addOption(replayOption);
+  parser.addOption(replaySpeedOption);
+  parser.addOption(replayStartOption);
 
   parser.process(a);
 
+  LogReplaySource* replay = nullptr;
+  unsigned int replaySpeed = 1;
+  qint64 replayStartMs = 0;
+
+  if (parser.isSet(replayOption))
+  {
+    QTextStream err(stderr);
+    const QString speedStr = parser.value(replaySpeedOption);
+    bool ok = true;
+
+    replaySpeed = (speedStr == "max") ? 0 : speedStr.toUInt(&ok);
+    replayStartMs = (qint64)(parser.value(replayStartOption).toDouble() * 1000.0);
+    if (!ok || (replaySpeed > 1000))
+    {
+      err << "Invalid replay speed: " << speedStr << Qt::endl;
+      return 1;
+    }
+
+    replay = new LogReplaySource();
+    if (!replay->open(parser.value(replayOption)))
+    {
+      err << "Failed to open " << parser.value(replayOption) << ": " << replay->errorString() << Qt::endl;
+      delete replay;
+      return 1;
+    }
+  }
+
   MainWindow w (parser.isSet(autoconnectOption),
                 parser.isSet(autologOption),
                 parser.isSet(doublebaudOption),
-                parser.isSet(simulatedData));
+                parser.isSet(simulatedData),
+                parser.value(simulationSeedOption).toUInt(),
+                replay,
+                replaySpeed,
+                replayStartMs);
 
   if (parser.isSet(fullscreenOption))
   {
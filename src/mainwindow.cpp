@@ -3,8 +3,11 @@
 #include <QDateTime>
 #include <QThread>
 #include <QFileDialog>
+#include <QActionGroup>
+#include <QMenu>
 #include <QGraphicsOpacityEffect>
 #include <QIcon>
+#include <QScreen>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "faultcodedialog.h"
@@ -41,11 +44,20 @@ const QHash<TemperatureUnits, QString> MainWindow::s_tempUnitSuffix
 
 /**
  * Constructor; sets up main UI
+ * @param simulationSeed Seed for the simulated engine, when simulating a connection
+ * @param replay If non-null, a recorded log that is replayed instead of
+ *  communicating with the ECU (ownership passes to the interface object)
+ * @param replaySpeed Replay speed multiplier, or 0 for as fast as possible
+ * @param replayStartMs Point in the log at which replay starts (msecs from its start)
  */
 MainWindow::MainWindow (bool autoconnect,
                         bool autolog,
                         bool doublebaud,
                         bool simulateConnection,
+                        uint32_t simulationSeed,
+                        LogReplaySource* replay,
+                        unsigned int replaySpeed,
+                        qint64 replayStartMs,
                         QWidget* parent)
   : QMainWindow(parent),
     m_ui(new Ui::MainWindow),
@@ -57,6 +69,7 @@ MainWindow::MainWindow (bool autoconnect,
 {
   // register this special enum type for use in Qt signals/slots
   qRegisterMetaType<c14cux_feedback_mode>("c14cux_feedback_mode");
+  qRegisterMetaType<RomReadStage>("RomReadStage");
 
   m_ui->setupUi(this);
   this->setWindowTitle("RoverGauge " +
@@ -67,16 +80,32 @@ MainWindow::MainWindow (bool autoconnect,
   m_options = new OptionsDialog(this->windowTitle(), this);
   m_cux = new CUXInterface(m_options->getSerialDeviceName(), CUXInterface::getBaudRate(doublebaud),
                            m_options->getSpeedUnits(), m_options->getTemperatureUnits(),
-                           m_options->getRefreshFuelMap(), simulateConnection);
+                           m_options->getRefreshFuelMap(), simulateConnection || (replay != nullptr));
+  m_cux->setSimulationSeed(simulationSeed);
+
+  // a recorded log takes the place of the simulated ECU
+  if (replay)
+  {
+    setupReplayControls(replay->firstTimestampMs(), replay->lastTimestampMs(), replaySpeed);
+    m_cux->setReplaySource(replay, replaySpeed, replayStartMs);
+    this->setWindowTitle(this->windowTitle() + " (replay)");
+  }
 
   m_enabledSamples = m_options->getEnabledSamples();
   m_cux->setEnabledSamples(m_enabledSamples);
+  m_cux->setRateLimits(m_options->getRateLimits());
   m_cux->setReadIntervals(m_options->getReadIntervals());
+  m_cux->setAdaptiveRates(m_options->getAdaptiveRates());
 
   m_iacDialog = new IdleAirControlDialog(this->windowTitle(), *m_cux, this);
-  m_logger = new Logger(*m_cux, *m_options);
+  m_linkStatsDialog = new LinkStatisticsDialog(this->windowTitle(), *m_cux, this);
+  m_stripChartDialog = new StripChartDialog(this->windowTitle(), this);
+  m_logger = new Logger(*m_cux);
+  m_logger->setSettings(m_options->getLogSettings());
 
   m_fuelPumpRefreshTimer.setInterval(1000);
+  m_fuelMapOverlayTimer.setInterval(1000);
+  m_displayRefreshTimer.setSingleShot(true);
 
   connectInterfaceSignals();
   setWindowIcon(QIcon(ICON_PATH));
@@ -130,11 +159,14 @@ void MainWindow::connectInterfaceSignals()
   connect(m_cux, &CUXInterface::notConnected,               this, &MainWindow::onNotConnected);
   connect(m_cux, &CUXInterface::romImageReady,              this, &MainWindow::onROMImageReady);
   connect(m_cux, &CUXInterface::romImageReadFailed,         this, &MainWindow::onROMImageReadFailed);
+  connect(m_cux, &CUXInterface::romImageProgress,           this, &MainWindow::onROMImageProgress);
   connect(m_cux, &CUXInterface::rpmLimitReady,              this, &MainWindow::onRPMLimitReady);
   connect(m_cux, &CUXInterface::rpmTableReady,              this, &MainWindow::onRPMTableReady);
   connect(m_cux, &CUXInterface::feedbackModeHasChanged,     this, &MainWindow::onFeedbackModeChanged);
   connect(m_cux, &CUXInterface::fuelMapIndexHasChanged,     this, &MainWindow::onFuelMapIndexChanged);
   connect(&m_fuelPumpRefreshTimer, &QTimer::timeout, this, &MainWindow::onFuelPumpRunTimer);
+  connect(&m_fuelMapOverlayTimer, &QTimer::timeout, this, &MainWindow::refreshFuelMapOverlay);
+  connect(&m_displayRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshDisplay);
   connect(this, &MainWindow::requestToStartPolling, m_cux, &CUXInterface::onStartPollingRequest);
   connect(this, &MainWindow::requestThreadShutdown, m_cux, &CUXInterface::onShutdownThreadRequest);
 }
@@ -160,9 +192,12 @@ void MainWindow::setupWidgets()
   connect(m_ui->m_idleAirControlAction, &QAction::triggered, this, &MainWindow::onIdleAirControlClicked);
   connect(m_ui->m_showFaultCodesAction, &QAction::triggered, this, &MainWindow::onShowFaultCodesClicked);
   connect(m_ui->m_batteryBackedAction,  &QAction::triggered, this, &MainWindow::onBatteryBackedMemClicked);
+  connect(m_ui->m_linkStatisticsAction, &QAction::triggered, this, &MainWindow::onLinkStatisticsClicked);
+  connect(m_ui->m_stripChartAction,     &QAction::triggered, this, &MainWindow::onStripChartClicked);
   connect(m_ui->m_editSettingsAction,   &QAction::triggered, this, &MainWindow::onEditOptionsClicked);
   connect(m_ui->m_helpContentsAction,   &QAction::triggered, this, &MainWindow::onHelpContentsClicked);
   connect(m_ui->m_helpAboutAction,      &QAction::triggered, this, &MainWindow::onHelpAboutClicked);
+  setupFuelMapOverlayMenu();
 
   // connect button signals
   connect(m_ui->m_connectButton, &QPushButton::clicked, this, &MainWindow::onConnectClicked);
@@ -204,12 +239,15 @@ void MainWindow::setupWidgets()
   m_ui->m_fuelPumpRelayStateLed->setOffColor2(QColor(0, 51, 0));
   m_ui->m_fuelPumpRelayStateLed->setDisabled(true);
 
-  // TODO: can this be done in the FuelMapGrid class?
-  // If it needs to stay here, should the 'QTableWidget'
-  // change to 'FuelMapGrid'?
-  setStyleSheet("QTableWidget {background-color: transparent;}");
   m_ui->m_fuelMapDisplay->setup(m_options->getDisplayNumberBase());
   m_ui->m_logFileNameBox->setText(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh.mm.ss"));
+
+  // keep the space for the backlog warning so that the layout doesn't jump when it appears
+  QSizePolicy backedUpPolicy = m_ui->m_logBackedUpLabel->sizePolicy();
+  backedUpPolicy.setRetainSizeWhenHidden(true);
+  m_ui->m_logBackedUpLabel->setSizePolicy(backedUpPolicy);
+  m_ui->m_logBackedUpLabel->setStyleSheet("QLabel { color: red; }");
+  m_ui->m_logBackedUpLabel->hide();
   m_ui->m_injectorDutyCycleBar->setAlignment(Qt::AlignCenter);
 
   const SpeedUnits speedUnit = m_options->getSpeedUnits();
@@ -392,18 +430,114 @@ void MainWindow::onBatteryBackedMemReadFailed()
 
 /**
  * Moves the highlight for the active cell in the fuel map display, based on the
- * most recent active row/column index data.
+ * row/column index data in the most recent telemetry frame.
  */
 void MainWindow::moveFuelMapCellHighlight()
 {
   m_ui->m_fuelMapDisplay->moveCellHighlight(
-    m_cux->getFuelMapRowIndex(),
-    m_cux->getFuelMapRowWeighting(),
-    m_cux->getFuelMapColumnIndex(),
-    m_cux->getFuelMapColumnWeighting(),
+    m_lastFrame.fuelMapRowIndex,
+    m_lastFrame.fuelMapRowWeighting,
+    m_lastFrame.fuelMapColumnIndex,
+    m_lastFrame.fuelMapColumnWeighting,
     m_options->getSoftHighlight());
 }
 
+/**
+ * Adds a submenu to the Options menu for choosing the statistic shown over
+ * the fuel map, along with items for resetting and exporting the statistics.
+ */
+void MainWindow::setupFuelMapOverlayMenu()
+{
+  const QList<QPair<FuelMapOverlay, QString>> choices =
+  {
+    { FuelMapOverlay_None,              "&None (fuel map values)" },
+    { FuelMapOverlay_Dwell,             "&Time spent in cell" },
+    { FuelMapOverlay_LambdaTrimMean,    "Lambda trim &mean" },
+    { FuelMapOverlay_LambdaTrimStdDev,  "Lambda trim &variation" },
+    { FuelMapOverlay_MAF,               "Mean &MAF reading" }
+  };
+
+  QMenu* menu = new QMenu("Fuel map &overlay", this);
+  QActionGroup* group = new QActionGroup(menu);
+
+  for (const QPair<FuelMapOverlay, QString>& choice : choices)
+  {
+    QAction* action = menu->addAction(choice.second);
+    const FuelMapOverlay overlay = choice.first;
+
+    action->setCheckable(true);
+    action->setChecked(overlay == m_fuelMapOverlay);
+    group->addAction(action);
+    connect(action, &QAction::triggered, this, [this, overlay]() { onFuelMapOverlaySelected(overlay); });
+  }
+
+  menu->addSeparator();
+  connect(menu->addAction("&Reset cell statistics"), &QAction::triggered,
+          this, &MainWindow::onResetCellStatsClicked);
+  connect(menu->addAction("&Export cell statistics..."), &QAction::triggered,
+          this, &MainWindow::onExportCellStatsClicked);
+
+  m_ui->m_optionsMenu->insertMenu(m_ui->m_editSettingsAction, menu);
+}
+
+/**
+ * Redraws the fuel map overlay with the latest statistics for the map in use.
+ */
+void MainWindow::refreshFuelMapOverlay()
+{
+  if (m_fuelMapOverlay == FuelMapOverlay_None)
+  {
+    m_ui->m_fuelMapDisplay->clearOverlay();
+  }
+  else
+  {
+    m_ui->m_fuelMapDisplay->setOverlay(
+      m_cellStats.overlayLevels(m_lastFrame.currentFuelMapIndex, m_fuelMapOverlay));
+  }
+}
+
+/**
+ * Switches the fuel map display between the map values and one of the cell
+ * statistics. The overlay is refreshed once a second while it is shown.
+ */
+void MainWindow::onFuelMapOverlaySelected(FuelMapOverlay overlay)
+{
+  m_fuelMapOverlay = overlay;
+
+  if (overlay == FuelMapOverlay_None)
+  {
+    m_fuelMapOverlayTimer.stop();
+  }
+  else
+  {
+    m_fuelMapOverlayTimer.start();
+  }
+  refreshFuelMapOverlay();
+}
+
+/**
+ * Discards the fuel map cell statistics gathered so far.
+ */
+void MainWindow::onResetCellStatsClicked()
+{
+  m_cellStats.reset();
+  refreshFuelMapOverlay();
+}
+
+/**
+ * Prompts for a file name and writes the fuel map cell statistics to it as CSV.
+ */
+void MainWindow::onExportCellStatsClicked()
+{
+  const QString path =
+    QFileDialog::getSaveFileName(this, "Select output file for fuel map cell statistics:", QString(), "CSV files (*.csv)");
+
+  if (!path.isEmpty() && !m_cellStats.exportCsv(path))
+  {
+    QMessageBox::warning(this, "Error", "Unable to write the fuel map cell statistics to " + path + ".", QMessageBox::Ok);
+  }
+}
+
 /**
  * Uses a fuel map array to populate a 16x8 grid that shows all the fueling
  * values.
@@ -452,13 +586,35 @@ void MainWindow::onFuelMapDataReady(unsigned int fuelMapId)
 }
 
 /**
- * Updates the gauges and indicators with the latest data available from
- * the ECU.
+ * Drains the frames published by the interface thread, passing every frame
+ * to the logger, the strip chart, and the fuel map cell statistics. The
+ * gauges and indicators are only redrawn at the display refresh rate, using
+ * the most recent frame.
  */
 void MainWindow::onDataReady()
 {
-  int rpm = 0;
-  float pulseWidth = 0;
+  TelemetryFrame frame;
+  bool haveFrame = false;
+
+  while (m_cux->takeFrame(frame))
+  {
+    m_logger->logData(frame);
+    m_stripChartDialog->appendFrame(frame);
+    if (m_enabledSamples[SampleType_FuelMapRowCol])
+    {
+      m_cellStats.addFrame(frame);
+    }
+    haveFrame = true;
+  }
+
+  // Any frames published before this signal was delivered have already been
+  // consumed by an earlier call.
+  if (!haveFrame)
+  {
+    return;
+  }
+
+  m_lastFrame = frame;
 
   if (!m_requestedTuneID)
   {
@@ -466,7 +622,68 @@ void MainWindow::onDataReady()
     m_requestedTuneID = true;
   }
 
-  m_ui->m_milLed->setChecked(m_cux->isMILOn());
+  scheduleDisplayRefresh();
+}
+
+/**
+ * Returns the minimum time between display refreshes, derived from the
+ * configured refresh rate or, if none is set, from the refresh rate of the
+ * screen showing the window.
+ */
+int MainWindow::displayRefreshIntervalMs() const
+{
+  qreal hz = m_options->getDisplayRefreshHz();
+
+  if ((hz <= 0) && screen())
+  {
+    hz = screen()->refreshRate();
+  }
+  if (hz <= 0)
+  {
+    hz = 60;
+  }
+
+  return qMax(1, qRound(1000.0 / hz));
+}
+
+/**
+ * Redraws the display right away if a full refresh interval has passed since
+ * the last redraw; otherwise arranges for a single redraw at the end of the
+ * interval, so that any number of frames arriving in between cost one redraw.
+ */
+void MainWindow::scheduleDisplayRefresh()
+{
+  if (m_displayRefreshTimer.isActive())
+  {
+    return;
+  }
+
+  const int intervalMs = displayRefreshIntervalMs();
+  const qint64 elapsedMs = m_sinceDisplayRefresh.isValid() ? m_sinceDisplayRefresh.elapsed() : intervalMs;
+
+  if (elapsedMs >= intervalMs)
+  {
+    refreshDisplay();
+  }
+  else
+  {
+    m_displayRefreshTimer.start(intervalMs - elapsedMs);
+  }
+}
+
+/**
+ * Updates the gauges and indicators with the most recently received frame.
+ */
+void MainWindow::refreshDisplay()
+{
+  const TelemetryFrame& frame = m_lastFrame;
+  int rpm = 0;
+  float pulseWidth = 0;
+
+  m_sinceDisplayRefresh.start();
+
+  m_ui->m_milLed->setChecked(frame.milOn);
+  m_ui->m_logBackedUpLabel->setVisible(m_isLogging && m_logger->isBackedUp());
 
   // if fuel map display updates are enabled...
   if (m_enabledSamples[SampleType_FuelMapRowCol] && m_fuelMapDataIsCurrent)
@@ -476,17 +693,17 @@ void MainWindow::onDataReady()
 
   if (m_enabledSamples[SampleType_Throttle])
   {
-    m_ui->m_throttleBar->setValue(m_cux->getThrottlePos() * 100);
+    m_ui->m_throttleBar->setValue(frame.throttlePos * 100);
   }
 
   if (m_enabledSamples[SampleType_MAF])
   {
-    m_ui->m_mafReadingBar->setValue(m_cux->getMAFReading() * 100);
+    m_ui->m_mafReadingBar->setValue(frame.mafReading * 100);
   }
 
   if (m_enabledSamples[SampleType_IdleBypassPosition])
   {
-    m_ui->m_idleBypassPosBar->setValue(m_cux->getIdleBypassPos() * 100);
+    m_ui->m_idleBypassPosBar->setValue(frame.idleBypassPos * 100);
   }
 
   if (m_enabledSamples[SampleType_RoadSpeed])
@@ -494,44 +711,44 @@ void MainWindow::onDataReady()
     if (m_options->getSpeedoAdjust())
     {
       const int adjustedSpeed =
-        (m_cux->getRoadSpeed() * m_options->getSpeedoMultiplier()) + m_options->getSpeedoOffset();
+        (frame.roadSpeed * m_options->getSpeedoMultiplier()) + m_options->getSpeedoOffset();
       m_ui->m_speedo->setValue(adjustedSpeed);
     }
     else
     {
-      m_ui->m_speedo->setValue((int)m_cux->getRoadSpeed());
+      m_ui->m_speedo->setValue((int)frame.roadSpeed);
     }
   }
 
   if (m_enabledSamples[SampleType_EngineRPM])
   {
-    rpm = m_cux->getEngineSpeedRPM();
+    rpm = frame.engineSpeedRPM;
     m_ui->m_revCounter->setValue(rpm);
   }
 
   if (m_enabledSamples[SampleType_EngineTemperature])
   {
-    m_ui->m_waterTempGauge->setValue(m_cux->getCoolantTemp());
+    m_ui->m_waterTempGauge->setValue(frame.coolantTemp);
   }
 
   if (m_enabledSamples[SampleType_FuelTemperature])
   {
-    m_ui->m_fuelTempGauge->setValue(m_cux->getFuelTemp());
+    m_ui->m_fuelTempGauge->setValue(frame.fuelTemp);
   }
 
   if (m_enabledSamples[SampleType_MainVoltage])
   {
-    m_ui->m_voltage->setText(QString::number(m_cux->getMainVoltage(), 'f', 1) + "V");
+    m_ui->m_voltage->setText(QString::number(frame.mainVoltage, 'f', 1) + "V");
   }
 
   if (m_enabledSamples[SampleType_FuelPumpRelay])
   {
-    m_ui->m_fuelPumpRelayStateLed->setChecked(m_cux->getFuelPumpRelayState());
+    m_ui->m_fuelPumpRelayStateLed->setChecked(frame.fuelPumpRelayOn);
   }
 
   if (m_enabledSamples[SampleType_InjectorPulseWidth])
   {
-    pulseWidth = m_cux->getInjectorPulseWidthMs();
+    pulseWidth = frame.injectorPulseWidthMs;
 
     // if we're also monitoring the engine speed, we can compute the injector duty
     // cycle as a percentage of the time available between spark interrupts
@@ -545,28 +762,121 @@ void MainWindow::onDataReady()
 
   if (m_enabledSamples[SampleType_TargetIdleRPM])
   {
-    const int targetIdleSpeedRPM = m_cux->getTargetIdleSpeed();
+    const int targetIdleSpeedRPM = frame.targetIdleSpeed;
     m_ui->m_targetIdle->setText((targetIdleSpeedRPM > 0) ? QString::number(targetIdleSpeedRPM) : "");
-    m_ui->m_idleModeLed->setChecked(m_cux->getIdleMode());
+    m_ui->m_idleModeLed->setChecked(frame.idleMode);
   }
 
   if ((m_enabledSamples[SampleType_LambdaTrimShort] || m_enabledSamples[SampleType_LambdaTrimLong]) &&
-      (m_cux->getFeedbackMode() == C14CUX_FeedbackMode_ClosedLoop))
+      (frame.feedbackMode == C14CUX_FeedbackMode_ClosedLoop))
   {
-    setLambdaTrimIndicators(m_cux->getLambdaTrimOdd(), m_cux->getLambdaTrimEven());
+    setLambdaTrimIndicators(frame.lambdaTrimOdd, frame.lambdaTrimEven);
   }
 
-  if (m_enabledSamples[SampleType_COTrimVoltage] && (m_cux->getFeedbackMode() == C14CUX_FeedbackMode_OpenLoop))
+  if (m_enabledSamples[SampleType_COTrimVoltage] && (frame.feedbackMode == C14CUX_FeedbackMode_OpenLoop))
   {
-    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(m_cux->getCOTrimVoltage(), 'f', 2) + "V");
+    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(frame.coTrimVoltage, 'f', 2) + "V");
   }
 
   if (m_enabledSamples[SampleType_GearSelection])
   {
-    setGearLabel(m_cux->getGear());
+    setGearLabel(frame.gear);
+  }
+
+  if (m_replayPositionSlider && !m_replayPositionSlider->isSliderDown())
+  {
+    const qint64 positionMs = frame.timestampMs - m_replayFirstMs;
+    m_replayPositionSlider->setValue((int)(positionMs / 1000));
+    setReplayPositionLabel(positionMs);
+  }
+}
+
+/**
+ * Adds a row of controls below the fuel map for moving around in the log
+ * being replayed and changing the replay speed. The position can only be
+ * changed while the replay is running.
+ * @param firstMs Timestamp of the first frame in the log
+ * @param lastMs Timestamp of the last frame in the log
+ * @param speed Initial replay speed multiplier, or 0 for as fast as possible
+ */
+void MainWindow::setupReplayControls(qint64 firstMs, qint64 lastMs, unsigned int speed)
+{
+  static const unsigned int speeds[] = { 1, 2, 10, 0 };
+
+  QHBoxLayout* layout = new QHBoxLayout();
+
+  m_replayFirstMs = firstMs;
+  m_replayDurationMs = qMax<qint64>(0, lastMs - firstMs);
+
+  m_replayPositionSlider = new QSlider(Qt::Horizontal, this);
+  m_replayPositionSlider->setRange(0, (int)(m_replayDurationMs / 1000));
+  m_replayPositionSlider->setPageStep(qMax(1, m_replayPositionSlider->maximum() / 20));
+  m_replayPositionSlider->setEnabled(false);
+  connect(m_replayPositionSlider, &QSlider::actionTriggered, this, &MainWindow::onReplaySliderAction);
+  connect(m_replayPositionSlider, &QSlider::sliderReleased, this, &MainWindow::onReplaySliderReleased);
+
+  m_replayPositionLabel = new QLabel(this);
+  setReplayPositionLabel(0);
+
+  m_replaySpeedBox = new QComboBox(this);
+  for (unsigned int option : speeds)
+  {
+    m_replaySpeedBox->addItem((option > 0) ? QString("%1x").arg(option) : QString("Max"), option);
+  }
+  if (m_replaySpeedBox->findData(speed) < 0)
+  {
+    m_replaySpeedBox->addItem(QString("%1x").arg(speed), speed);
   }
+  m_replaySpeedBox->setCurrentIndex(m_replaySpeedBox->findData(speed));
+  connect(m_replaySpeedBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &MainWindow::onReplaySpeedSelected);
+
+  layout->addWidget(new QLabel("Replay position:", this));
+  layout->addWidget(m_replayPositionSlider, 1);
+  layout->addWidget(m_replayPositionLabel);
+  layout->addWidget(new QLabel("Speed:", this));
+  layout->addWidget(m_replaySpeedBox);
+  m_ui->m_layoutMaster->addLayout(layout);
+}
+
+/**
+ * Shows the replay position and the length of the log as minutes and seconds.
+ */
+void MainWindow::setReplayPositionLabel(qint64 positionMs)
+{
+  const qint64 pos = qBound<qint64>(0, positionMs, m_replayDurationMs) / 1000;
+  const qint64 len = m_replayDurationMs / 1000;
 
-  m_logger->logData();
+  m_replayPositionLabel->setText(QString("%1:%2 / %3:%4")
+                                 .arg(pos / 60).arg(pos % 60, 2, 10, QChar('0'))
+                                 .arg(len / 60).arg(len % 60, 2, 10, QChar('0')));
+}
+
+/**
+ * Jumps to the position selected by clicking on the replay slider's track or
+ * using the keyboard. Dragging is handled when the slider is released.
+ */
+void MainWindow::onReplaySliderAction(int action)
+{
+  if (action != QAbstractSlider::SliderMove)
+  {
+    m_cux->seekReplay((qint64)m_replayPositionSlider->sliderPosition() * 1000);
+  }
+}
+
+/**
+ * Jumps to the position to which the replay slider was dragged.
+ */
+void MainWindow::onReplaySliderReleased()
+{
+  m_cux->seekReplay((qint64)m_replayPositionSlider->sliderPosition() * 1000);
+}
+
+/**
+ * Changes the replay speed.
+ */
+void MainWindow::onReplaySpeedSelected(int index)
+{
+  m_cux->setReplaySpeed(m_replaySpeedBox->itemData(index).toUInt());
 }
 
 /**
@@ -674,6 +984,8 @@ void MainWindow::onEditOptionsClicked()
 
     m_cux->setEnabledSamples(m_enabledSamples);
     m_cux->setReadIntervals(m_options->getReadIntervals());
+    m_cux->setAdaptiveRates(m_options->getAdaptiveRates());
+    m_logger->setSettings(m_options->getLogSettings());
 
     // If the user changed the serial device name and/or the polling
     // interval, stop the timer, re-connect to the 14CUX (if neccessary),
@@ -839,6 +1151,11 @@ void MainWindow::onConnect()
   m_ui->m_commsBadLed->setChecked(false);
   m_ui->m_fuelPumpOneshotButton->setEnabled(true);
   m_ui->m_fuelPumpContinuousButton->setEnabled(true);
+
+  if (m_replayPositionSlider)
+  {
+    m_replayPositionSlider->setEnabled(true);
+  }
 }
 
 /**
@@ -889,9 +1206,18 @@ void MainWindow::onDisconnect()
 
   m_ui->m_fuelMapDisplay->clearCellHighlight();
 
+  m_displayRefreshTimer.stop();
+  m_sinceDisplayRefresh.invalidate();
+
+  if (m_replayPositionSlider)
+  {
+    m_replayPositionSlider->setEnabled(false);
+  }
+
   m_fuelMapDataIsCurrent = false;
   m_cux->invalidateFuelMapData();
   m_requestedTuneID = false;
+  m_lastFrame = TelemetryFrame();
 }
 
 /**
@@ -951,9 +1277,19 @@ void MainWindow::onStopLogging()
 {
   m_isLogging = false;
   m_logger->closeLog();
+  m_ui->m_logBackedUpLabel->hide();
   m_ui->m_logFileNameBox->setEnabled(true);
   m_ui->m_stopLoggingButton->setEnabled(false);
   m_ui->m_startLoggingButton->setEnabled(true);
+
+  const unsigned int dropped = m_logger->getDroppedFrames();
+  if (dropped > 0)
+  {
+    QMessageBox::warning(this, "Warning",
+                         QString("%1 samples were left out of the log because they arrived faster than "
+                                 "they could be written to the disk.").arg(dropped),
+                         QMessageBox::Ok);
+  }
 }
 
 /**
@@ -1008,9 +1344,9 @@ void MainWindow::onFailedToConnect(QString dev)
  */
 void MainWindow::onNotConnected()
 {
-  if (m_pleaseWaitBox)
+  if (m_romProgressDialog)
   {
-    m_pleaseWaitBox->hide();
+    m_romProgressDialog->hide();
   }
 
   QMessageBox::warning(
@@ -1023,8 +1359,19 @@ void MainWindow::onNotConnected()
  */
 void MainWindow::onSaveROMImageSelected()
 {
-  sendROMImageRequest(
-    QString("Read the ROM image from the ECU? This will take approximately 25 seconds."));
+  const int bytesRead = m_cux->getROMImageBytesRead();
+
+  if ((bytesRead > 0) && (bytesRead < CUXInterface::getROMImageSize()))
+  {
+    sendROMImageRequest(
+      QString("Resume reading the ROM image from the ECU? %1 of %2 bytes have already been read.")
+      .arg(bytesRead).arg(CUXInterface::getROMImageSize()));
+  }
+  else
+  {
+    sendROMImageRequest(
+      QString("Read the ROM image from the ECU? This will take approximately 25 seconds."));
+  }
 }
 
 /**
@@ -1038,17 +1385,21 @@ void MainWindow::sendROMImageRequest(QString prompt)
     if (QMessageBox::question(this, "Confirm", prompt,
                               QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
     {
-      if (m_pleaseWaitBox == nullptr)
+      if (m_romProgressDialog == nullptr)
       {
-        m_pleaseWaitBox = new QMessageBox(
-          QMessageBox::Information, "In Progress",
-          QString("Please wait while the ROM image is read.\n\n"),
-          QMessageBox::Ok, this, Qt::Dialog);
-        m_pleaseWaitBox->setStandardButtons(QMessageBox::Cancel);
-        connect(m_pleaseWaitBox, &QMessageBox::finished, this, &MainWindow::onROMReadCancelled);
+        m_romProgressDialog = new QProgressDialog(this);
+        m_romProgressDialog->setWindowTitle("In Progress");
+        m_romProgressDialog->setAutoReset(false);
+        m_romProgressDialog->setAutoClose(false);
+        m_romProgressDialog->setMinimumDuration(0);
+        connect(m_romProgressDialog, &QProgressDialog::canceled, this, &MainWindow::onROMReadCancelled);
       }
 
-      m_pleaseWaitBox->show();
+      m_romProgressDialog->reset();
+      m_romProgressDialog->setLabelText("Reading the ROM image...");
+      m_romProgressDialog->setRange(0, CUXInterface::getROMImageSize());
+      m_romProgressDialog->setValue(m_cux->getROMImageBytesRead());
+      m_romProgressDialog->show();
       m_cux->enqueueRequest(QueueableRequest_ROMImage);
     }
   }
@@ -1059,21 +1410,51 @@ void MainWindow::sendROMImageRequest(QString prompt)
 }
 
 /**
- * Sets a flag that indicates we should ignore any ROM image that is returned.
+ * Stops the ROM read. The blocks read so far are kept, so that the next
+ * request picks up where this one left off.
  */
 void MainWindow::onROMReadCancelled()
 {
+  m_romProgressDialog->hide();
   m_cux->cancelRead();
 }
 
+/**
+ * Updates the progress dialog as blocks of the ROM image are read.
+ * @param bytesRead Number of bytes read so far in the current stage
+ * @param totalBytes Number of bytes to be read in the current stage
+ * @param stage Whether the image is being read, read again because it failed
+ *  its checksum, or compared with a cached image from the same tune
+ */
+void MainWindow::onROMImageProgress(int bytesRead, int totalBytes, RomReadStage stage)
+{
+  if (m_romProgressDialog && m_romProgressDialog->isVisible())
+  {
+    switch (stage)
+    {
+    case RomReadStage_Verifying:
+      m_romProgressDialog->setLabelText("The ROM image checksum is incorrect. Reading it again to verify...");
+      break;
+    case RomReadStage_Comparing:
+      m_romProgressDialog->setLabelText("Comparing the ROM with a previously saved image of this tune...");
+      break;
+    default:
+      m_romProgressDialog->setLabelText("Reading the ROM image...");
+      break;
+    }
+    m_romProgressDialog->setRange(0, totalBytes);
+    m_romProgressDialog->setValue(bytesRead);
+  }
+}
+
 /**
  * Prompts the user for a file in which to save the ROM image.
  */
 void MainWindow::onROMImageReady()
 {
-  if (m_pleaseWaitBox)
+  if (m_romProgressDialog)
   {
-    m_pleaseWaitBox->hide();
+    m_romProgressDialog->hide();
   }
 
   const QByteArray& promData = m_cux->getROMImage();
@@ -1108,13 +1489,15 @@ void MainWindow::onROMImageReady()
  */
 void MainWindow::onROMImageReadFailed()
 {
-  if (m_pleaseWaitBox)
+  if (m_romProgressDialog)
   {
-    m_pleaseWaitBox->hide();
+    m_romProgressDialog->hide();
   }
 
   QMessageBox::warning(
-    this, "Error", "Communications error. ROM image could not be read.", QMessageBox::Ok);
+    this, "Error", "Communications error. ROM image could not be read.\n\n"
+    "If the ECU is still connected, select \"Save ROM image\" again to resume from where the read stopped.",
+    QMessageBox::Ok);
 }
 
 /**
@@ -1153,6 +1536,22 @@ void MainWindow::onIdleAirControlClicked()
   m_iacDialog->show();
 }
 
+/**
+ * Displays the link statistics dialog.
+ */
+void MainWindow::onLinkStatisticsClicked()
+{
+  m_linkStatsDialog->show();
+}
+
+/**
+ * Displays the strip chart.
+ */
+void MainWindow::onStripChartClicked()
+{
+  m_stripChartDialog->show();
+}
+
 /**
  * Queues a request to read the fault codes.
  */
@@ -1244,7 +1643,7 @@ void MainWindow::onRPMTableReady()
 
   for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
   {
-    m_ui->m_fuelMapDisplay->horizontalHeaderItem(col)->setText(QString::number(table.rpm[col]));
+    m_ui->m_fuelMapDisplay->setColumnLabel(col, QString::number(table.rpm[col]));
   }
 }
 
@@ -5,6 +5,7 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QProgressBar>
+#include <QProgressDialog>
 #include <QLabel>
 #include <QFile>
 #include <QLineEdit>
@@ -12,20 +13,27 @@
 #include <QThread>
 #include <QFrame>
 #include <QTableWidget>
+#include <QSlider>
+#include <QComboBox>
 #include <QHash>
 #include <QMap>
 #include <QPair>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QShortcut>
 #include <QGraphicsOpacityEffect>
 #include <analogwidgets/manometer.h>
 #include <qledindicator/qledindicator.h>
 #include "optionsdialog.h"
 #include "idleaircontroldialog.h"
+#include "linkstatisticsdialog.h"
+#include "stripchartdialog.h"
 #include "cuxinterface.h"
 #include "aboutbox.h"
 #include "logger.h"
+#include "fuelmapcellstats.h"
 #include "commonunits.h"
+#include "telemetryframe.h"
 #include "helpviewer.h"
 
 namespace Ui
@@ -42,6 +50,10 @@ public:
               bool autolog,
               bool doublebaud,
               bool simulateConnection,
+              uint32_t simulationSeed = 1,
+              LogReplaySource* replay = nullptr,
+              unsigned int replaySpeed = 1,
+              qint64 replayStartMs = 0,
               QWidget* parent = nullptr);
   ~MainWindow();
 
@@ -63,6 +75,7 @@ public slots:
   void onRPMTableReady();
   void onROMImageReady();
   void onROMImageReadFailed();
+  void onROMImageProgress(int bytesRead, int totalBytes, RomReadStage stage);
   void onInterfaceReady();
   void onNotConnected();
   void onFeedbackModeChanged(c14cux_feedback_mode mode);
@@ -83,8 +96,10 @@ private:
   CUXInterface* m_cux = nullptr;
   OptionsDialog* m_options = nullptr;
   IdleAirControlDialog* m_iacDialog = nullptr;
+  LinkStatisticsDialog* m_linkStatsDialog = nullptr;
+  StripChartDialog* m_stripChartDialog = nullptr;
   AboutBox* m_aboutBox = nullptr;
-  QMessageBox* m_pleaseWaitBox = nullptr;
+  QProgressDialog* m_romProgressDialog = nullptr;
   HelpViewer* m_helpViewerDialog = nullptr;
   bool m_doubleBaudRate;
   bool m_requestedTuneID = false;
@@ -93,6 +108,19 @@ private:
   QShortcut m_shortcutStopLogging;
 
   Logger* m_logger = nullptr;
+  TelemetryFrame m_lastFrame;
+  QTimer m_displayRefreshTimer;
+  QElapsedTimer m_sinceDisplayRefresh;
+
+  FuelMapCellStats m_cellStats;
+  FuelMapOverlay m_fuelMapOverlay = FuelMapOverlay_None;
+  QTimer m_fuelMapOverlayTimer;
+
+  QSlider* m_replayPositionSlider = nullptr;
+  QLabel* m_replayPositionLabel = nullptr;
+  QComboBox* m_replaySpeedBox = nullptr;
+  qint64 m_replayFirstMs = 0;
+  qint64 m_replayDurationMs = 0;
 
   QGraphicsOpacityEffect* m_waterTempGaugeOpacity = nullptr;
   QGraphicsOpacityEffect* m_fuelTempGaugeOpacity = nullptr;
@@ -128,6 +156,13 @@ private:
   void setLambdaWidgetsForFeedbackMode(c14cux_feedback_mode mode, bool coTrimEnabled, bool lambdaEnabled);
   void setSpeedoLabel();
   void moveFuelMapCellHighlight();
+  void setupFuelMapOverlayMenu();
+  void refreshFuelMapOverlay();
+  int displayRefreshIntervalMs() const;
+  void scheduleDisplayRefresh();
+  void refreshDisplay();
+  void setupReplayControls(qint64 firstMs, qint64 lastMs, unsigned int speed);
+  void setReplayPositionLabel(qint64 positionMs);
 
 private slots:
   void onSaveROMImageSelected();
@@ -143,6 +178,14 @@ private slots:
   void onFuelPumpRunTimer();
   void onFuelPumpContinuous();
   void onIdleAirControlClicked();
+  void onLinkStatisticsClicked();
+  void onStripChartClicked();
+  void onReplaySliderAction(int action);
+  void onReplaySliderReleased();
+  void onReplaySpeedSelected(int index);
+  void onFuelMapOverlaySelected(FuelMapOverlay overlay);
+  void onResetCellStatsClicked();
+  void onExportCellStatsClicked();
   void onShowFaultCodesClicked();
   void onBatteryBackedMemClicked();
   void onLambdaTrimButtonClicked(QAbstractButton* button);
@@ -1,9 +1,13 @@
 #include <QSettings>
 #include "ui_optionsdialog.h"
 #include "optionsdialog.h"
+#include "samplesettings.h"
 #include "serialdevenumerator.h"
 #include "comm14cux.h"
 
+// refresh rates offered in the display refresh box, in the order listed there
+const int OptionsDialog::s_displayRefreshChoices[] = { 0, 60, 30, 15 };
+
 /**
  * Constructor; sets up the options-dialog UI and sets settings-file field names.
  */
@@ -14,6 +18,14 @@ OptionsDialog::OptionsDialog(QString title, QWidget* parent) : QDialog(parent),
   m_settingRefreshFuelMap("RefreshFuelMap"),
   m_settingSoftHighlight("SoftHighlight"),
   m_settingLogTimesMsecsFromZero("LogTimesMsecsFromZero"),
+  m_settingLogFormat("LogFormat"),
+  m_settingLogSyncPolicy("LogSyncPolicy"),
+  m_settingLogSyncIntervalMs("LogSyncIntervalMs"),
+  m_settingLogSegmentMaxMB("LogSegmentMaxMB"),
+  m_settingLogSegmentMaxMinutes("LogSegmentMaxMinutes"),
+  m_settingLogCompressSegments("LogCompressSegments"),
+  m_settingAdaptiveRates("AdaptiveSampleRates"),
+  m_settingDisplayRefreshHz("DisplayRefreshHz"),
   m_settingSpeedUnits("SpeedUnits"),
   m_settingDisplayNumBase("FuelMapDisplayNumberBase"),
   m_settingTemperatureUnits("TemperatureUnits"),
@@ -25,21 +37,7 @@ OptionsDialog::OptionsDialog(QString title, QWidget* parent) : QDialog(parent),
 {
   m_ui->setupUi(this);
 
-  m_sampleTypeNames[SampleType_EngineTemperature] = "SampleType_EngineTemperature";
-  m_sampleTypeNames[SampleType_RoadSpeed] = "SampleType_RoadSpeed";
-  m_sampleTypeNames[SampleType_EngineRPM] = "SampleType_EngineRPM";
-  m_sampleTypeNames[SampleType_FuelTemperature] = "SampleType_FuelTemperature";
-  m_sampleTypeNames[SampleType_MAF] = "SampleType_MAF";
-  m_sampleTypeNames[SampleType_Throttle] = "SampleType_Throttle";
-  m_sampleTypeNames[SampleType_IdleBypassPosition] = "SampleType_IdleBypassPosition";
-  m_sampleTypeNames[SampleType_TargetIdleRPM] = "SampleType_TargetIdleRPM";
-  m_sampleTypeNames[SampleType_GearSelection] = "SampleType_GearSelection";
-  m_sampleTypeNames[SampleType_MainVoltage] = "SampleType_MainVoltage";
-  m_sampleTypeNames[SampleType_LambdaTrimLong] = "SampleType_LambdaTrim";
-  m_sampleTypeNames[SampleType_COTrimVoltage] = "SampleType_COTrimVoltage";
-  m_sampleTypeNames[SampleType_FuelMapData] = "SampleType_FuelMap";
-  m_sampleTypeNames[SampleType_FuelPumpRelay] = "SampleType_FuelPumpRelay";
-  m_sampleTypeNames[SampleType_InjectorPulseWidth] = "SampleType_InjectorPulseWidth";
+  m_sampleTypeNames = SampleSettings::enableSettingNames();
 
   m_sampleTypeLabels[SampleType_EngineTemperature] = "Engine temperature";
   m_sampleTypeLabels[SampleType_RoadSpeed] = "Road speed";
@@ -57,27 +55,8 @@ OptionsDialog::OptionsDialog(QString title, QWidget* parent) : QDialog(parent),
   m_sampleTypeLabels[SampleType_FuelPumpRelay] = "Fuel pump relay";
   m_sampleTypeLabels[SampleType_InjectorPulseWidth] = "Injector pulse width / duty cycle";
 
-  // We try to keep the nonzero intervals prime to avoid statistical
-  // clustering of read calls to the library.
-  m_readIntervalsMs[SampleType_EngineTemperature]  = 1499;
-  m_readIntervalsMs[SampleType_RoadSpeed]          = 997;
-  m_readIntervalsMs[SampleType_EngineRPM]          = 0;
-  m_readIntervalsMs[SampleType_FuelTemperature]    = 1801;
-  m_readIntervalsMs[SampleType_MAF]                = 0;
-  m_readIntervalsMs[SampleType_Throttle]           = 0;
-  m_readIntervalsMs[SampleType_IdleBypassPosition] = 0;
-  m_readIntervalsMs[SampleType_TargetIdleRPM]      = 487;
-  m_readIntervalsMs[SampleType_GearSelection]      = 563;
-  m_readIntervalsMs[SampleType_MainVoltage]        = 283;
-  m_readIntervalsMs[SampleType_LambdaTrimShort]    = 0;
-  m_readIntervalsMs[SampleType_LambdaTrimLong]     = 331;
-  m_readIntervalsMs[SampleType_COTrimVoltage]      = 317;
-  m_readIntervalsMs[SampleType_FuelPumpRelay]      = 313;
-  m_readIntervalsMs[SampleType_FuelMapRowCol]      = 0;
-  m_readIntervalsMs[SampleType_FuelMapData]        = 3511;
-  m_readIntervalsMs[SampleType_FuelMapIndex]       = 1201;
-  m_readIntervalsMs[SampleType_InjectorPulseWidth] = 0;
-  m_readIntervalsMs[SampleType_MIL]                = 347;
+  m_readIntervalsMs = SampleSettings::defaultReadIntervals();
+  m_rateLimits = SampleSettings::defaultRateLimits();
 
   this->setWindowTitle(title);
   readSettings();
@@ -133,6 +112,17 @@ void OptionsDialog::setWidgetValues()
   m_ui->m_refreshFuelMapCheckbox->setChecked(m_refreshFuelMap);
   m_ui->m_softHighlightCheckbox->setChecked(m_softHighlight);
   m_ui->m_logTimesMsecsFromZeroCheckbox->setChecked(m_logTimesMsecsFromZero);
+  m_ui->m_logFormatBox->setCurrentIndex((int)m_logFormat);
+  m_ui->m_adaptiveRatesCheckbox->setChecked(m_adaptiveRates);
+
+  m_ui->m_displayRefreshBox->setCurrentIndex(0);
+  for (int idx = 0; idx < m_ui->m_displayRefreshBox->count(); idx++)
+  {
+    if (s_displayRefreshChoices[idx] == m_displayRefreshHz)
+    {
+      m_ui->m_displayRefreshBox->setCurrentIndex(idx);
+    }
+  }
 
   m_ui->m_adjustSpeedoCheckbox->setChecked(m_speedoAdjust);
   m_ui->m_speedoMultiplierSpinbox->setValue(m_speedoMultiplier);
@@ -193,6 +183,9 @@ void OptionsDialog::accept()
   m_refreshFuelMap   = m_ui->m_refreshFuelMapCheckbox->isChecked();
   m_softHighlight    = m_ui->m_softHighlightCheckbox->isChecked();
   m_logTimesMsecsFromZero = m_ui->m_logTimesMsecsFromZeroCheckbox->isChecked();
+  m_logFormat        = (LogFormat)(m_ui->m_logFormatBox->currentIndex());
+  m_adaptiveRates    = m_ui->m_adaptiveRatesCheckbox->isChecked();
+  m_displayRefreshHz = s_displayRefreshChoices[m_ui->m_displayRefreshBox->currentIndex()];
   m_speedoAdjust     = m_ui->m_adjustSpeedoCheckbox->isChecked();
   m_speedoMultiplier = m_ui->m_speedoMultiplierSpinbox->value();
   m_speedoOffset     = m_ui->m_speedoOffsetSpinbox->value();
@@ -245,6 +238,14 @@ void OptionsDialog::readSettings()
   m_refreshFuelMap = settings.value(m_settingRefreshFuelMap, false).toBool();
   m_softHighlight = settings.value(m_settingSoftHighlight, false).toBool();
   m_logTimesMsecsFromZero = settings.value(m_settingLogTimesMsecsFromZero, false).toBool();
+  m_logFormat = (LogFormat)(settings.value(m_settingLogFormat, LogFormat_Text).toInt());
+  m_logSyncPolicy = (LogSyncPolicy)(settings.value(m_settingLogSyncPolicy, LogSyncPolicy_Interval).toInt());
+  m_logSyncIntervalMs = settings.value(m_settingLogSyncIntervalMs, 5000).toInt();
+  m_logSegmentMaxMB = settings.value(m_settingLogSegmentMaxMB, 0).toInt();
+  m_logSegmentMaxMinutes = settings.value(m_settingLogSegmentMaxMinutes, 0).toInt();
+  m_logCompressSegments = settings.value(m_settingLogCompressSegments, false).toBool();
+  m_adaptiveRates = settings.value(m_settingAdaptiveRates, false).toBool();
+  m_displayRefreshHz = qMax(settings.value(m_settingDisplayRefreshHz, 0).toInt(), 0);
   m_speedoAdjust = settings.value(m_settingSpeedoAdjust, false).toBool();
   m_speedoMultiplier = settings.value(m_settingSpeedoMultiplier, 1.0).toDouble();
   m_speedoOffset = settings.value(m_settingSpeedoOffset, 0).toInt();
@@ -259,6 +260,9 @@ void OptionsDialog::readSettings()
   groupLikeSettings();
   settings.endGroup();
 
+  SampleSettings::readIntervalOverrides(settings, m_readIntervalsMs);
+  SampleSettings::readRateLimitOverrides(settings, m_rateLimits);
+
   settings.beginGroup(m_settingRAMLocGroupName);
   m_ramLocLabels[0x40] = settings.value(m_ramLabelPrefix + QString("40"), "secondaryLambdaR").toString();
   m_ramLocLabels[0x42] = settings.value(m_ramLabelPrefix + QString("42"), "longLambdaTrimR (16 bit)").toString();
@@ -293,6 +297,14 @@ void OptionsDialog::writeSettings()
   settings.setValue(m_settingRefreshFuelMap, m_refreshFuelMap);
   settings.setValue(m_settingSoftHighlight, m_softHighlight);
   settings.setValue(m_settingLogTimesMsecsFromZero, m_logTimesMsecsFromZero);
+  settings.setValue(m_settingLogFormat, m_logFormat);
+  settings.setValue(m_settingLogSyncPolicy, m_logSyncPolicy);
+  settings.setValue(m_settingLogSyncIntervalMs, m_logSyncIntervalMs);
+  settings.setValue(m_settingLogSegmentMaxMB, m_logSegmentMaxMB);
+  settings.setValue(m_settingLogSegmentMaxMinutes, m_logSegmentMaxMinutes);
+  settings.setValue(m_settingLogCompressSegments, m_logCompressSegments);
+  settings.setValue(m_settingAdaptiveRates, m_adaptiveRates);
+  settings.setValue(m_settingDisplayRefreshHz, m_displayRefreshHz);
   settings.setValue(m_settingSpeedoAdjust, m_speedoAdjust);
   settings.setValue(m_settingSpeedoMultiplier, m_speedoMultiplier);
   settings.setValue(m_settingSpeedoOffset, m_speedoOffset);
@@ -319,13 +331,7 @@ void OptionsDialog::writeSettings()
  */
 void OptionsDialog::groupLikeSettings()
 {
-  // There are a few readings that we don't let the user adjust invidivually, so
-  // just force all the readings in a particular group to the same value.
-  // This includes both long- and short-term lambda trim, and the three fuel
-  // map related pieces of data (row/col, index, and the map data itself.)
-  m_enabledSamples[SampleType_LambdaTrimShort] = m_enabledSamples[SampleType_LambdaTrimLong];
-  m_enabledSamples[SampleType_FuelMapRowCol] = m_enabledSamples[SampleType_FuelMapData];
-  m_enabledSamples[SampleType_FuelMapIndex] = m_enabledSamples[SampleType_FuelMapData];
+  SampleSettings::groupLikeSamples(m_enabledSamples);
 }
 
 /**
@@ -340,3 +346,23 @@ QString OptionsDialog::getSerialDeviceName() const
 #endif
 }
 
+/**
+ * Returns the subset of the settings that controls logging.
+ */
+LogSettings OptionsDialog::getLogSettings() const
+{
+  LogSettings logSettings;
+
+  logSettings.format = m_logFormat;
+  logSettings.timesMsecsFromZero = m_logTimesMsecsFromZero;
+  logSettings.speedoAdjust = m_speedoAdjust;
+  logSettings.speedoMultiplier = m_speedoMultiplier;
+  logSettings.speedoOffset = m_speedoOffset;
+  logSettings.syncPolicy = m_logSyncPolicy;
+  logSettings.syncIntervalMs = m_logSyncIntervalMs;
+  logSettings.segmentMaxMB = m_logSegmentMaxMB;
+  logSettings.segmentMaxMinutes = m_logSegmentMaxMinutes;
+  logSettings.compressSegments = m_logCompressSegments;
+
+  return logSettings;
+}
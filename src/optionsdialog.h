@@ -4,6 +4,8 @@
 #include <QString>
 #include <QHash>
 #include "commonunits.h"
+#include "logsettings.h"
+#include "adaptiverate.h"
 
 namespace Ui
 {
@@ -64,6 +66,16 @@ public:
     return m_readIntervalsMs;
   }
 
+  inline bool getAdaptiveRates() const
+  {
+    return m_adaptiveRates;
+  }
+
+  inline QHash<SampleType, SampleRateLimits> getRateLimits() const
+  {
+    return m_rateLimits;
+  }
+
   inline bool getSpeedoAdjust() const
   {
     return m_speedoAdjust;
@@ -89,6 +101,22 @@ public:
     return m_logTimesMsecsFromZero;
   }
 
+  inline LogFormat getLogFormat() const
+  {
+    return m_logFormat;
+  }
+
+  /**
+   * Returns the highest rate (in Hz) at which the display is refreshed, or 0
+   * to follow the refresh rate of the screen.
+   */
+  inline int getDisplayRefreshHz() const
+  {
+    return m_displayRefreshHz;
+  }
+
+  LogSettings getLogSettings() const;
+
 protected:
   void accept();
   void reject();
@@ -111,6 +139,8 @@ private:
   QMap<SampleType, QString> m_sampleTypeNames;
   QMap<SampleType, QString> m_sampleTypeLabels;
   QHash<SampleType, unsigned int> m_readIntervalsMs;
+  QHash<SampleType, SampleRateLimits> m_rateLimits;
+  bool m_adaptiveRates = false;
   bool m_serialDeviceChanged = false;
   bool m_refreshFuelMap;
   bool m_softHighlight;
@@ -121,6 +151,15 @@ private:
   bool m_displayNumberBaseChanged = false;
   QMap<int,QString> m_ramLocLabels;
   bool m_logTimesMsecsFromZero = false;
+  LogFormat m_logFormat = LogFormat_Text;
+  LogSyncPolicy m_logSyncPolicy = LogSyncPolicy_Interval;
+  int m_logSyncIntervalMs = 5000;
+  int m_logSegmentMaxMB = 0;
+  int m_logSegmentMaxMinutes = 0;
+  bool m_logCompressSegments = false;
+  int m_displayRefreshHz = 0;
+
+  static const int s_displayRefreshChoices[];
 
   const QString m_settingsFileName;
   const QString m_settingsGroupName;
@@ -128,6 +167,14 @@ private:
   const QString m_settingRefreshFuelMap;
   const QString m_settingSoftHighlight;
   const QString m_settingLogTimesMsecsFromZero;
+  const QString m_settingLogFormat;
+  const QString m_settingLogSyncPolicy;
+  const QString m_settingLogSyncIntervalMs;
+  const QString m_settingLogSegmentMaxMB;
+  const QString m_settingLogSegmentMaxMinutes;
+  const QString m_settingLogCompressSegments;
+  const QString m_settingAdaptiveRates;
+  const QString m_settingDisplayRefreshHz;
   const QString m_settingSpeedUnits;
   const QString m_settingDisplayNumBase;
   const QString m_settingTemperatureUnits;
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include "rambatch.h"
+
+/**
+ * Forgets the fields and spans from the previous pass. The buffer's storage is
+ * kept so that it isn't reallocated on every pass.
+ */
+void RamBatch::clear()
+{
+  m_fields.clear();
+  m_spans.clear();
+}
+
+/**
+ * Adds a memory location that must be read during this pass.
+ * @param address Address of the first byte in the 14CUX's memory map
+ * @param length Number of bytes
+ */
+void RamBatch::addField(uint16_t address, uint16_t length)
+{
+  if (length > 0)
+  {
+    m_fields.append({ address, (uint16_t)(address + length) });
+  }
+}
+
+/**
+ * Sorts the fields by address and merges them into spans, joining neighbouring
+ * fields when the gap between them is small and the resulting span isn't too
+ * long for a single read.
+ */
+void RamBatch::plan()
+{
+  int bufferSize = 0;
+
+  m_spans.clear();
+  std::sort(m_fields.begin(), m_fields.end(),
+            [](const Field& a, const Field& b) { return a.start < b.start; });
+
+  foreach (const Field& field, m_fields)
+  {
+    if (!m_spans.isEmpty())
+    {
+      RamSpan& last = m_spans.last();
+      const int lastEnd = last.start + last.length;
+      const int mergedEnd = std::max<int>(lastEnd, field.end);
+
+      if (((field.start - lastEnd) <= s_maxGapBytes) &&
+          ((mergedEnd - last.start) <= s_maxSpanBytes))
+      {
+        bufferSize += mergedEnd - lastEnd;
+        last.length = (uint16_t)(mergedEnd - last.start);
+        continue;
+      }
+    }
+
+    RamSpan span;
+    span.start = field.start;
+    span.length = field.end - field.start;
+    span.bufferOffset = bufferSize;
+    m_spans.append(span);
+    bufferSize += span.length;
+  }
+
+  m_buffer.resize(bufferSize);
+}
+
+/**
+ * Returns the part of the buffer into which a span should be read.
+ */
+uint8_t* RamBatch::spanBuffer(int idx)
+{
+  return m_buffer.data() + m_spans.at(idx).bufferOffset;
+}
+
+/**
+ * Records whether a span was read successfully.
+ */
+void RamBatch::setSpanValid(int idx, bool valid)
+{
+  m_spans[idx].valid = valid;
+}
+
+/**
+ * Returns the span that holds the whole of the given range (if it was read
+ * successfully), or null otherwise.
+ */
+const RamSpan* RamBatch::spanFor(uint16_t address, uint16_t length) const
+{
+  foreach (const RamSpan& span, m_spans)
+  {
+    if (span.valid &&
+        (address >= span.start) &&
+        ((address + length) <= (span.start + span.length)))
+    {
+      return &span;
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * Returns true if the given range was read successfully during this pass.
+ */
+bool RamBatch::contains(uint16_t address, uint16_t length) const
+{
+  return (spanFor(address, length) != nullptr);
+}
+
+/**
+ * Returns a byte that was read during this pass. The caller must first check
+ * that the location is available with contains().
+ */
+uint8_t RamBatch::byteAt(uint16_t address) const
+{
+  const RamSpan* span = spanFor(address, 1);
+  return span ? m_buffer.at(span->bufferOffset + (address - span->start)) : 0;
+}
+
+/**
+ * Returns a 16-bit word that was read during this pass. The 14CUX's processor
+ * is big-endian, so the most significant byte comes first.
+ */
+uint16_t RamBatch::wordAt(uint16_t address) const
+{
+  const RamSpan* span = spanFor(address, 2);
+  uint16_t value = 0;
+
+  if (span)
+  {
+    const int offset = span->bufferOffset + (address - span->start);
+    value = (uint16_t)((m_buffer.at(offset) << 8) | m_buffer.at(offset + 1));
+  }
+
+  return value;
+}
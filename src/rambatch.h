@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <QVector>
+
+/**
+ * Contiguous range of 14CUX memory that is fetched with a single read.
+ */
+struct RamSpan
+{
+  uint16_t start = 0;
+  uint16_t length = 0;
+  int bufferOffset = 0;
+  bool valid = false;
+};
+
+/**
+ * Collects the memory locations needed by the samples that are due in one
+ * pass, and coalesces them into as few contiguous reads as possible. Every
+ * read over the serial link carries a fixed cost for the command and its
+ * echo, so it is cheaper to read a few unneeded bytes between two fields
+ * than to issue a second read. Fields are then decoded from the shared buffer.
+ */
+class RamBatch
+{
+public:
+  void clear();
+  void addField(uint16_t address, uint16_t length);
+  void plan();
+
+  int spanCount() const
+  {
+    return m_spans.size();
+  }
+
+  uint16_t spanStart(int idx) const
+  {
+    return m_spans.at(idx).start;
+  }
+
+  uint16_t spanLength(int idx) const
+  {
+    return m_spans.at(idx).length;
+  }
+
+  uint8_t* spanBuffer(int idx);
+  void setSpanValid(int idx, bool valid);
+
+  bool contains(uint16_t address, uint16_t length) const;
+  uint8_t byteAt(uint16_t address) const;
+  uint16_t wordAt(uint16_t address) const;
+
+private:
+  struct Field
+  {
+    uint16_t start;
+    uint16_t end;
+  };
+
+  // Largest gap (in bytes) between two fields that is read through rather than
+  // starting a new span. This is roughly the per-read overhead of the protocol.
+  static const int s_maxGapBytes = 8;
+  static const int s_maxSpanBytes = 64;
+
+  QVector<Field> m_fields;
+  QVector<RamSpan> m_spans;
+  QVector<uint8_t> m_buffer;
+
+  const RamSpan* spanFor(uint16_t address, uint16_t length) const;
+};
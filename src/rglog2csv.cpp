@@ -0,0 +1,238 @@
+#include <cstdio>
+#include <limits>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "binarylogreader.h"
+#include "logmanifest.h"
+#include "textlogformatter.h"
+
+static const int s_outputBufferBytes = 64 * 1024;
+
+/**
+ * Appends one record as a line of CSV, formatted in the same way as the
+ * text logger would have written it.
+ */
+static void appendRow(QByteArray& out, TextLogFormatter& formatter, const BinaryLogHeader& header,
+                      const BinaryLogRecord& rec, bool timesFromZero, qint64 firstTimestampMs)
+{
+  if (timesFromZero)
+  {
+    TextLogFormatter::appendInt(out, rec.timestampMs - firstTimestampMs);
+  }
+  else
+  {
+    formatter.appendDateTime(out, rec.timestampMs);
+  }
+
+  for (int col = 0; col < header.columns.size(); col++)
+  {
+    const BinaryLogColumn& column = header.columns.at(col);
+    out.append(',');
+
+    if (column.source == SampleType_RoadSpeed)
+    {
+      double roadSpeed = rec.values.at(col);
+
+      if (header.flags & BinaryLogFlag_SpeedoAdjust)
+      {
+        roadSpeed *= header.speedoMultiplier;
+        roadSpeed += header.speedoOffset;
+      }
+      TextLogFormatter::appendNumber(out, roadSpeed);
+    }
+    else if (column.type == BinaryLogValueType_Float)
+    {
+      TextLogFormatter::appendNumber(out, BinaryLogFormat::bitsToFloat(rec.values.at(col)));
+    }
+    else
+    {
+      TextLogFormatter::appendInt(out, rec.values.at(col));
+    }
+  }
+
+  out.append('\n');
+}
+
+int main(int argc, char* argv[])
+{
+  const QString versionStr = QString("%1.%2.%3").arg(ROVERGAUGE_VER_MAJOR).arg(ROVERGAUGE_VER_MINOR).arg(ROVERGAUGE_VER_PATCH);
+
+  QCoreApplication a(argc, argv);
+  a.setApplicationVersion(versionStr);
+  a.setApplicationName("rglog2csv");
+
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Converts a RoverGauge binary log (.rglog), or the segments of a segmented "
+                                   "binary log listed in its .manifest, to the CSV text log format");
+
+  const QCommandLineOption outputOption
+    ({"o", "output"}, "Write the CSV to <file> instead of standard output.", "file");
+  const QCommandLineOption fromZeroOption
+    ({"z", "msecs-from-zero"}, "Write timestamps in milliseconds from the first record.");
+  const QCommandLineOption absoluteOption
+    ({"t", "absolute-times"}, "Write timestamps as dates and times.");
+  const QCommandLineOption fromOption
+    ("from", "Only convert records from <msecs> (since 1970) onwards.", "msecs");
+  const QCommandLineOption toOption
+    ("to", "Only convert records up to <msecs> (since 1970).", "msecs");
+
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addOption(outputOption);
+  parser.addOption(fromZeroOption);
+  parser.addOption(absoluteOption);
+  parser.addOption(fromOption);
+  parser.addOption(toOption);
+  parser.addPositionalArgument("log", "Binary log file, or manifest of a segmented log, to convert.");
+
+  parser.process(a);
+
+  QTextStream err(stderr);
+
+  if (parser.positionalArguments().size() != 1)
+  {
+    parser.showHelp(1);
+  }
+
+  const QString input = parser.positionalArguments().first();
+  const qint64 fromMs = parser.isSet(fromOption) ? parser.value(fromOption).toLongLong()
+                                                 : std::numeric_limits<qint64>::min();
+  const qint64 toMs = parser.isSet(toOption) ? parser.value(toOption).toLongLong()
+                                             : std::numeric_limits<qint64>::max();
+  QStringList paths;
+
+  // a segmented log is converted by reading only the segments that cover the period, in order
+  if (LogManifest::isManifest(input))
+  {
+    LogManifest manifest;
+    if (!manifest.load(input))
+    {
+      err << input << ": Unable to read the log manifest" << Qt::endl;
+      return 1;
+    }
+
+    foreach (const LogSegment& segment, manifest.segmentsBetween(fromMs, toMs))
+    {
+      const QString path = manifest.readablePath(segment);
+      if (path.isEmpty())
+      {
+        err << segment.fileName << ": compressed segments must be decompressed (with zstd -d) "
+            << "before they can be converted" << Qt::endl;
+        return 1;
+      }
+      paths.append(path);
+    }
+
+    if (paths.isEmpty())
+    {
+      err << input << ": No segments cover the given period" << Qt::endl;
+      return 1;
+    }
+  }
+  else
+  {
+    paths.append(input);
+  }
+
+  BinaryLogReader reader;
+  if (!reader.open(paths.first()))
+  {
+    err << paths.first() << ": " << reader.errorString() << Qt::endl;
+    return 1;
+  }
+
+  QFile outFile;
+  if (parser.isSet(outputOption))
+  {
+    outFile.setFileName(parser.value(outputOption));
+    if (!outFile.open(QFile::WriteOnly | QFile::Truncate))
+    {
+      err << outFile.fileName() << ": " << outFile.errorString() << Qt::endl;
+      return 1;
+    }
+  }
+  else
+  {
+    outFile.open(stdout, QFile::WriteOnly);
+  }
+
+  QByteArray out;
+  out.reserve(s_outputBufferBytes + 1024);
+  TextLogFormatter formatter;
+
+  // Unless overridden, use the timestamp style that was selected when the log was recorded.
+  bool timesFromZero = (reader.header().flags & BinaryLogFlag_TimesFromZero);
+  if (parser.isSet(fromZeroOption))
+  {
+    timesFromZero = true;
+  }
+  else if (parser.isSet(absoluteOption))
+  {
+    timesFromZero = false;
+  }
+
+  BinaryLogRecord rec;
+  QString csvHeader = BinaryLogFormat::csvHeader(reader.header());
+  bool firstRecord = true;
+  qint64 firstTimestampMs = 0;
+  unsigned long recordCount = 0;
+
+  out.append(csvHeader.toUtf8()).append('\n');
+
+  for (int file = 0; file < paths.size(); file++)
+  {
+    if ((file > 0) && !reader.open(paths.at(file)))
+    {
+      err << paths.at(file) << ": " << reader.errorString() << Qt::endl;
+      break;
+    }
+
+    while (reader.readNext(rec))
+    {
+      // A later segment may have been written by a version of RoverGauge that
+      // logs a different set of columns; start a new CSV header if so.
+      if (reader.headerChanged() && (BinaryLogFormat::csvHeader(reader.header()) != csvHeader))
+      {
+        csvHeader = BinaryLogFormat::csvHeader(reader.header());
+        out.append(csvHeader.toUtf8()).append('\n');
+      }
+
+      if ((rec.timestampMs < fromMs) || (rec.timestampMs > toMs))
+      {
+        continue;
+      }
+
+      if (firstRecord)
+      {
+        firstTimestampMs = rec.timestampMs;
+        firstRecord = false;
+      }
+
+      appendRow(out, formatter, reader.header(), rec, timesFromZero, firstTimestampMs);
+      recordCount++;
+
+      if (out.size() >= s_outputBufferBytes)
+      {
+        outFile.write(out);
+        out.resize(0);
+      }
+    }
+
+    if (!reader.errorString().isEmpty())
+    {
+      err << "Warning: " << paths.at(file) << ": " << reader.errorString()
+          << " (" << recordCount << " records converted)" << Qt::endl;
+    }
+  }
+
+  outFile.write(out);
+  outFile.flush();
+
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include "romimagecache.h"
+
+RomImageCache::RomImageCache() :
+  m_dir(defaultDirectory())
+{
+}
+
+/**
+ * Returns the index key for an ECU with the given identifying values, as
+ * read by c14cux_getTuneRevision().
+ */
+QString RomImageCache::keyFor(uint16_t tune, uint8_t checksumFixer, uint16_t ident)
+{
+  return QString("%1-%2-%3").arg(tune, 4, 16, QChar('0'))
+                            .arg(checksumFixer, 2, 16, QChar('0'))
+                            .arg(ident, 4, 16, QChar('0'));
+}
+
+/**
+ * Returns the cache directory, which sits alongside the settings file.
+ */
+QString RomImageCache::defaultDirectory()
+{
+  const QSettings settings(QSettings::IniFormat, QSettings::UserScope, "RoverGauge");
+  return QFileInfo(settings.fileName()).absolutePath() + QDir::separator() + "romcache";
+}
+
+QString RomImageCache::indexPath() const
+{
+  return m_dir + QDir::separator() + "index.ini";
+}
+
+QString RomImageCache::hashOf(const QByteArray& image)
+{
+  return QString::fromLatin1(QCryptographicHash::hash(image, QCryptographicHash::Sha1).toHex());
+}
+
+/**
+ * Looks up the image previously read from an ECU with the given key. The
+ * image's contents are checked against the hash in its name, so that a
+ * damaged file is never mistaken for the real thing.
+ * @param key Key returned by keyFor()
+ * @param image Set to the cached image, if found
+ * @return True if a valid image was found, false otherwise
+ */
+bool RomImageCache::load(const QString& key, QByteArray& image) const
+{
+  const QSettings index(indexPath(), QSettings::IniFormat);
+  const QString hash = index.value("Images/" + key).toString();
+  bool status = false;
+
+  if (!hash.isEmpty())
+  {
+    QFile file(m_dir + QDir::separator() + hash + ".bin");
+    if (file.open(QFile::ReadOnly))
+    {
+      const QByteArray contents = file.readAll();
+      if (hashOf(contents) == hash)
+      {
+        image = contents;
+        status = true;
+      }
+    }
+  }
+
+  return status;
+}
+
+/**
+ * Saves an image and records it as the one read from the ECU with the given
+ * key. An image that is already in the cache is not written again.
+ * @return True if the image was stored, false if it could not be written
+ */
+bool RomImageCache::store(const QString& key, const QByteArray& image)
+{
+  const QString hash = hashOf(image);
+  const QString imagePath = m_dir + QDir::separator() + hash + ".bin";
+  bool status = QDir().mkpath(m_dir);
+
+  if (status && !QFileInfo::exists(imagePath))
+  {
+    QSaveFile file(imagePath);
+    status = file.open(QFile::WriteOnly) && (file.write(image) == image.size()) && file.commit();
+  }
+
+  if (status)
+  {
+    QSettings index(indexPath(), QSettings::IniFormat);
+    index.setValue("Images/" + key, hash);
+    index.sync();
+    status = (index.status() == QSettings::NoError);
+  }
+
+  return status;
+}
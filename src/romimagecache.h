@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <QString>
+#include <QByteArray>
+
+/**
+ * A local store of ROM images that have been read from ECUs. Each image is
+ * saved once, in a file named for the SHA-1 hash of its contents, and an index
+ * maps the tune number, checksum fixer, and ident of each ECU to the image that
+ * was read from it. Knowing a car's tune is then enough to find the image that
+ * its ROM probably contains, so that reading it again only needs to confirm it.
+ */
+class RomImageCache
+{
+public:
+  RomImageCache();
+
+  static QString keyFor(uint16_t tune, uint8_t checksumFixer, uint16_t ident);
+  static QString defaultDirectory();
+
+  void setDirectory(const QString& dir)
+  {
+    m_dir = dir;
+  }
+
+  QString directory() const
+  {
+    return m_dir;
+  }
+
+  bool load(const QString& key, QByteArray& image) const;
+  bool store(const QString& key, const QByteArray& image);
+
+private:
+  QString m_dir;
+
+  QString indexPath() const;
+  static QString hashOf(const QByteArray& image);
+};
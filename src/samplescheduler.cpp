@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <QMutexLocker>
+#include "samplescheduler.h"
+
+/**
+ * Constructor. Starts the monotonic clock and assigns the fixed priority
+ * for each sample type. The fast-changing readings that drive the gauges and
+ * the fuel map highlight are given precedence over slow readings such as the
+ * temperatures.
+ */
+SampleScheduler::SampleScheduler()
+{
+  m_clock.start();
+  m_heap.reserve(SampleType_NumSampleTypes);
+
+  m_samples[SampleType_EngineRPM].priority          = SamplePriority_High;
+  m_samples[SampleType_MAF].priority                = SamplePriority_High;
+  m_samples[SampleType_Throttle].priority           = SamplePriority_High;
+  m_samples[SampleType_LambdaTrimShort].priority    = SamplePriority_High;
+  m_samples[SampleType_FuelMapRowCol].priority      = SamplePriority_High;
+  m_samples[SampleType_InjectorPulseWidth].priority = SamplePriority_High;
+  m_samples[SampleType_EngineTemperature].priority  = SamplePriority_Low;
+  m_samples[SampleType_FuelTemperature].priority    = SamplePriority_Low;
+  m_samples[SampleType_FuelMapData].priority        = SamplePriority_Low;
+}
+
+/**
+ * Makes every enabled sample due immediately and clears the deadline statistics.
+ * Called when (re)connecting so that all the readings are refreshed right away.
+ */
+void SampleScheduler::reset()
+{
+  QMutexLocker locker(&m_lock);
+  const qint64 now = m_clock.elapsed();
+
+  m_heap.clear();
+  m_totalMisses = 0;
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    SampleState& state = m_samples[type];
+    state.inHeap = false;
+    state.dueTime = now;
+    state.missCount = 0;
+    state.maxLatenessMs = 0;
+
+    if (state.enabled)
+    {
+      insert((SampleType)type);
+    }
+  }
+}
+
+/**
+ * Adds a sample type to (or removes it from) the schedule.
+ */
+void SampleScheduler::setEnabled(SampleType type, bool enabled)
+{
+  QMutexLocker locker(&m_lock);
+  SampleState& state = m_samples[type];
+
+  if (enabled && !state.enabled)
+  {
+    state.enabled = true;
+    state.dueTime = m_clock.elapsed();
+    insert(type);
+  }
+  else if (!enabled && state.enabled)
+  {
+    state.enabled = false;
+    remove(type);
+  }
+}
+
+/**
+ * Sets the minimum time between successive reads of a sample type. An interval
+ * of zero means that the sample is read as often as the link allows.
+ */
+void SampleScheduler::setInterval(SampleType type, unsigned int intervalMs)
+{
+  QMutexLocker locker(&m_lock);
+  m_samples[type].intervalMs = intervalMs;
+}
+
+/**
+ * Returns the current time (in milliseconds) on the scheduler's monotonic clock.
+ */
+qint64 SampleScheduler::now() const
+{
+  return m_clock.elapsed();
+}
+
+/**
+ * Returns the number of milliseconds until the next sample falls due, zero if
+ * a sample is already due, or -1 if nothing is scheduled at all.
+ */
+qint64 SampleScheduler::msecsUntilNextDue() const
+{
+  QMutexLocker locker(&m_lock);
+  qint64 wait = -1;
+
+  if (!m_heap.isEmpty())
+  {
+    wait = std::max<qint64>(0, m_samples[m_heap.first()].dueTime - m_clock.elapsed());
+  }
+
+  return wait;
+}
+
+/**
+ * Removes every sample that is currently due from the schedule, and returns the
+ * list in the order in which the samples should be read: highest priority first,
+ * and then by due time. A sample that is already more than one interval late is
+ * promoted to the highest priority so that it cannot be starved indefinitely.
+ * Each returned sample must be handed back with either complete() or defer().
+ */
+void SampleScheduler::takeDueSamples(QVector<SampleType>& due)
+{
+  QMutexLocker locker(&m_lock);
+  const qint64 now = m_clock.elapsed();
+  auto later = [this](SampleType a, SampleType b) { return dueLater(a, b); };
+
+  due.clear();
+  while (!m_heap.isEmpty() && (m_samples[m_heap.first()].dueTime <= now))
+  {
+    std::pop_heap(m_heap.begin(), m_heap.end(), later);
+    const SampleType type = m_heap.takeLast();
+    m_samples[type].inHeap = false;
+    due.append(type);
+  }
+
+  std::stable_sort(due.begin(), due.end(), [this, now](SampleType a, SampleType b)
+  {
+    const SamplePriority prioA = isOverdue(a, now) ? SamplePriority_High : m_samples[a].priority;
+    const SamplePriority prioB = isOverdue(b, now) ? SamplePriority_High : m_samples[b].priority;
+    return (prioA != prioB) ? (prioA > prioB) : (m_samples[a].dueTime < m_samples[b].dueTime);
+  });
+}
+
+/**
+ * Records that a sample has just been read, updates its deadline statistics, and
+ * schedules its next reading one interval from now.
+ */
+void SampleScheduler::complete(SampleType type)
+{
+  QMutexLocker locker(&m_lock);
+  SampleState& state = m_samples[type];
+  const qint64 now = m_clock.elapsed();
+  const qint64 lateness = now - state.dueTime;
+
+  state.maxLatenessMs = std::max(state.maxLatenessMs, lateness);
+
+  // Samples with a zero interval have no real deadline; they are simply read
+  // as often as possible.
+  if ((state.intervalMs > 0) && (lateness > state.intervalMs))
+  {
+    state.missCount++;
+    m_totalMisses++;
+  }
+
+  state.dueTime = now + state.intervalMs;
+  if (state.enabled)
+  {
+    insert(type);
+  }
+}
+
+/**
+ * Returns a sample to the schedule without reading it, keeping its original due
+ * time so that it is taken again (ahead of later samples) on the next pass.
+ */
+void SampleScheduler::defer(SampleType type)
+{
+  QMutexLocker locker(&m_lock);
+  if (m_samples[type].enabled)
+  {
+    insert(type);
+  }
+}
+
+/**
+ * Returns the number of times that the sample type was read more than one full
+ * interval after it fell due.
+ */
+unsigned int SampleScheduler::getDeadlineMissCount(SampleType type) const
+{
+  QMutexLocker locker(&m_lock);
+  return m_samples[type].missCount;
+}
+
+/**
+ * Returns the number of deadline misses across all sample types.
+ */
+unsigned int SampleScheduler::getTotalDeadlineMisses() const
+{
+  QMutexLocker locker(&m_lock);
+  return m_totalMisses;
+}
+
+/**
+ * Returns the largest delay (in milliseconds) between a sample falling due and
+ * it actually being read.
+ */
+qint64 SampleScheduler::getMaxLatenessMs(SampleType type) const
+{
+  QMutexLocker locker(&m_lock);
+  return m_samples[type].maxLatenessMs;
+}
+
+/**
+ * Pushes a sample type onto the heap. Must be called with the lock held.
+ */
+void SampleScheduler::insert(SampleType type)
+{
+  if (!m_samples[type].inHeap)
+  {
+    m_samples[type].inHeap = true;
+    m_heap.append(type);
+    std::push_heap(m_heap.begin(), m_heap.end(), [this](SampleType a, SampleType b) { return dueLater(a, b); });
+  }
+}
+
+/**
+ * Removes a sample type from the heap. Must be called with the lock held.
+ */
+void SampleScheduler::remove(SampleType type)
+{
+  if (m_samples[type].inHeap)
+  {
+    m_samples[type].inHeap = false;
+    m_heap.removeOne(type);
+    std::make_heap(m_heap.begin(), m_heap.end(), [this](SampleType a, SampleType b) { return dueLater(a, b); });
+  }
+}
+
+/**
+ * Determines whether a sample has been waiting for more than one full interval.
+ */
+bool SampleScheduler::isOverdue(SampleType type, qint64 now) const
+{
+  const SampleState& state = m_samples[type];
+  return (state.intervalMs > 0) && ((now - state.dueTime) > state.intervalMs);
+}
+
+/**
+ * Heap ordering: returns true if sample 'a' should come out of the heap after
+ * sample 'b'. Ties on due time are broken by priority.
+ */
+bool SampleScheduler::dueLater(SampleType a, SampleType b) const
+{
+  const SampleState& stateA = m_samples[a];
+  const SampleState& stateB = m_samples[b];
+
+  if (stateA.dueTime != stateB.dueTime)
+  {
+    return stateA.dueTime > stateB.dueTime;
+  }
+
+  return stateA.priority < stateB.priority;
+}
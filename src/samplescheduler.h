@@ -0,0 +1,66 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+#include "commonunits.h"
+
+/**
+ * Relative importance of a sample type when more samples are due than the
+ * serial link can service in a single pass.
+ */
+enum SamplePriority
+{
+  SamplePriority_Low,
+  SamplePriority_Normal,
+  SamplePriority_High
+};
+
+/**
+ * Deadline-driven scheduler for the periodic ECU readings. Every enabled sample
+ * type is kept in a min-heap keyed on the time (taken from a monotonic clock)
+ * at which it next falls due. Samples that are serviced more than one full
+ * interval after their due time are counted as deadline misses, which is a
+ * sign that the link is oversubscribed.
+ */
+class SampleScheduler
+{
+public:
+  SampleScheduler();
+
+  void reset();
+  void setEnabled(SampleType type, bool enabled);
+  void setInterval(SampleType type, unsigned int intervalMs);
+
+  qint64 now() const;
+  qint64 msecsUntilNextDue() const;
+  void takeDueSamples(QVector<SampleType>& due);
+  void complete(SampleType type);
+  void defer(SampleType type);
+
+  unsigned int getDeadlineMissCount(SampleType type) const;
+  unsigned int getTotalDeadlineMisses() const;
+  qint64 getMaxLatenessMs(SampleType type) const;
+
+private:
+  struct SampleState
+  {
+    bool enabled = false;
+    bool inHeap = false;
+    unsigned int intervalMs = 0;
+    SamplePriority priority = SamplePriority_Normal;
+    qint64 dueTime = 0;
+    unsigned int missCount = 0;
+    qint64 maxLatenessMs = 0;
+  };
+
+  mutable QMutex m_lock;
+  QElapsedTimer m_clock;
+  SampleState m_samples[SampleType_NumSampleTypes];
+  QVector<SampleType> m_heap;
+  unsigned int m_totalMisses = 0;
+
+  void insert(SampleType type);
+  void remove(SampleType type);
+  bool isOverdue(SampleType type, qint64 now) const;
+  bool dueLater(SampleType a, SampleType b) const;
+};
@@ -0,0 +1,201 @@
+#include <QStringList>
+#include "samplesettings.h"
+
+/**
+ * Returns the names of the settings-file keys that enable/disable each of the
+ * user-selectable sample types.
+ */
+QMap<SampleType, QString> SampleSettings::enableSettingNames()
+{
+  QMap<SampleType, QString> names;
+
+  names[SampleType_EngineTemperature] = "SampleType_EngineTemperature";
+  names[SampleType_RoadSpeed] = "SampleType_RoadSpeed";
+  names[SampleType_EngineRPM] = "SampleType_EngineRPM";
+  names[SampleType_FuelTemperature] = "SampleType_FuelTemperature";
+  names[SampleType_MAF] = "SampleType_MAF";
+  names[SampleType_Throttle] = "SampleType_Throttle";
+  names[SampleType_IdleBypassPosition] = "SampleType_IdleBypassPosition";
+  names[SampleType_TargetIdleRPM] = "SampleType_TargetIdleRPM";
+  names[SampleType_GearSelection] = "SampleType_GearSelection";
+  names[SampleType_MainVoltage] = "SampleType_MainVoltage";
+  names[SampleType_LambdaTrimLong] = "SampleType_LambdaTrim";
+  names[SampleType_COTrimVoltage] = "SampleType_COTrimVoltage";
+  names[SampleType_FuelMapData] = "SampleType_FuelMap";
+  names[SampleType_FuelPumpRelay] = "SampleType_FuelPumpRelay";
+  names[SampleType_InjectorPulseWidth] = "SampleType_InjectorPulseWidth";
+
+  return names;
+}
+
+/**
+ * Returns a short name for the sample type (e.g. "EngineRPM"), as used on the
+ * command line and in the [ReadIntervals] group of the settings file.
+ */
+QString SampleSettings::shortName(SampleType type)
+{
+  switch (type)
+  {
+  case SampleType_EngineTemperature:  return "EngineTemperature";
+  case SampleType_RoadSpeed:          return "RoadSpeed";
+  case SampleType_EngineRPM:          return "EngineRPM";
+  case SampleType_FuelTemperature:    return "FuelTemperature";
+  case SampleType_MAF:                return "MAF";
+  case SampleType_Throttle:           return "Throttle";
+  case SampleType_IdleBypassPosition: return "IdleBypassPosition";
+  case SampleType_TargetIdleRPM:      return "TargetIdleRPM";
+  case SampleType_GearSelection:      return "GearSelection";
+  case SampleType_MainVoltage:        return "MainVoltage";
+  case SampleType_LambdaTrimShort:    return "LambdaTrimShort";
+  case SampleType_LambdaTrimLong:     return "LambdaTrimLong";
+  case SampleType_COTrimVoltage:      return "COTrimVoltage";
+  case SampleType_FuelPumpRelay:      return "FuelPumpRelay";
+  case SampleType_FuelMapRowCol:      return "FuelMapRowCol";
+  case SampleType_FuelMapData:        return "FuelMapData";
+  case SampleType_FuelMapIndex:       return "FuelMapIndex";
+  case SampleType_InjectorPulseWidth: return "InjectorPulseWidth";
+  case SampleType_MIL:                return "MIL";
+  default:                            return QString();
+  }
+}
+
+/**
+ * Looks up a sample type by its short name (case-insensitive).
+ * @return True if the name matched a sample type; false otherwise
+ */
+bool SampleSettings::fromShortName(const QString& name, SampleType& type)
+{
+  for (int idx = 0; idx < (int)SampleType_NumSampleTypes; idx++)
+  {
+    if (shortName((SampleType)idx).compare(name.trimmed(), Qt::CaseInsensitive) == 0)
+    {
+      type = (SampleType)idx;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Returns the default interval (in milliseconds) between reads of each sample type.
+ */
+QHash<SampleType, unsigned int> SampleSettings::defaultReadIntervals()
+{
+  QHash<SampleType, unsigned int> intervals;
+
+  // We try to keep the nonzero intervals prime to avoid statistical
+  // clustering of read calls to the library.
+  intervals[SampleType_EngineTemperature]  = 1499;
+  intervals[SampleType_RoadSpeed]          = 997;
+  intervals[SampleType_EngineRPM]          = 0;
+  intervals[SampleType_FuelTemperature]    = 1801;
+  intervals[SampleType_MAF]                = 0;
+  intervals[SampleType_Throttle]           = 0;
+  intervals[SampleType_IdleBypassPosition] = 0;
+  intervals[SampleType_TargetIdleRPM]      = 487;
+  intervals[SampleType_GearSelection]      = 563;
+  intervals[SampleType_MainVoltage]        = 283;
+  intervals[SampleType_LambdaTrimShort]    = 0;
+  intervals[SampleType_LambdaTrimLong]     = 331;
+  intervals[SampleType_COTrimVoltage]      = 317;
+  intervals[SampleType_FuelPumpRelay]      = 313;
+  intervals[SampleType_FuelMapRowCol]      = 0;
+  intervals[SampleType_FuelMapData]        = 3511;
+  intervals[SampleType_FuelMapIndex]       = 1201;
+  intervals[SampleType_InjectorPulseWidth] = 0;
+  intervals[SampleType_MIL]                = 347;
+
+  return intervals;
+}
+
+/**
+ * Replaces default read intervals with any that are given in the
+ * [ReadIntervals] group of the settings file (keyed by short name.)
+ */
+void SampleSettings::readIntervalOverrides(QSettings& settings, QHash<SampleType, unsigned int>& intervals)
+{
+  settings.beginGroup("ReadIntervals");
+  foreach (const QString& key, settings.childKeys())
+  {
+    SampleType type;
+    bool ok = false;
+    const unsigned int intervalMs = settings.value(key).toUInt(&ok);
+
+    if (ok && fromShortName(key, type))
+    {
+      intervals[type] = intervalMs;
+    }
+  }
+  settings.endGroup();
+}
+
+/**
+ * Returns the default floor and ceiling rates (in Hz) for the sample types
+ * that can be scheduled adaptively. Readings with only a few discrete states
+ * (gear, relays, MIL, etc.) always use their fixed intervals.
+ */
+QHash<SampleType, SampleRateLimits> SampleSettings::defaultRateLimits()
+{
+  QHash<SampleType, SampleRateLimits> limits;
+
+  limits[SampleType_EngineRPM]          = { 2.0f, 50.0f };
+  limits[SampleType_MAF]                = { 2.0f, 50.0f };
+  limits[SampleType_Throttle]           = { 2.0f, 50.0f };
+  limits[SampleType_FuelMapRowCol]      = { 2.0f, 50.0f };
+  limits[SampleType_InjectorPulseWidth] = { 1.0f, 50.0f };
+  limits[SampleType_IdleBypassPosition] = { 0.5f, 20.0f };
+  limits[SampleType_LambdaTrimShort]    = { 1.0f, 20.0f };
+  limits[SampleType_LambdaTrimLong]     = { 0.2f,  5.0f };
+  limits[SampleType_RoadSpeed]          = { 0.5f, 10.0f };
+  limits[SampleType_MainVoltage]        = { 0.2f,  5.0f };
+  limits[SampleType_TargetIdleRPM]      = { 0.2f,  5.0f };
+  limits[SampleType_COTrimVoltage]      = { 0.2f,  5.0f };
+  limits[SampleType_EngineTemperature]  = { 0.1f,  2.0f };
+  limits[SampleType_FuelTemperature]    = { 0.1f,  2.0f };
+
+  return limits;
+}
+
+/**
+ * Replaces default rate limits with any that are given in the
+ * [SampleRateLimits] group of the settings file. Each entry is keyed by short
+ * name and has the form "floor-ceiling" in Hz (e.g. Throttle=5-40).
+ */
+void SampleSettings::readRateLimitOverrides(QSettings& settings, QHash<SampleType, SampleRateLimits>& limits)
+{
+  settings.beginGroup("SampleRateLimits");
+  foreach (const QString& key, settings.childKeys())
+  {
+    SampleType type;
+    const QStringList parts = settings.value(key).toString().split('-');
+    bool floorOk = false;
+    bool ceilingOk = false;
+
+    if ((parts.size() == 2) && fromShortName(key, type) && limits.contains(type))
+    {
+      const float floorHz = parts.at(0).toFloat(&floorOk);
+      const float ceilingHz = parts.at(1).toFloat(&ceilingOk);
+
+      if (floorOk && ceilingOk && (floorHz > 0.0f) && (ceilingHz >= floorHz))
+      {
+        limits[type] = { floorHz, ceilingHz };
+      }
+    }
+  }
+  settings.endGroup();
+}
+
+/**
+ * Sets all enabled samples in the same group to the same value.
+ */
+void SampleSettings::groupLikeSamples(QMap<SampleType, bool>& samples)
+{
+  // There are a few readings that we don't let the user adjust invidivually, so
+  // just force all the readings in a particular group to the same value.
+  // This includes both long- and short-term lambda trim, and the three fuel
+  // map related pieces of data (row/col, index, and the map data itself.)
+  samples[SampleType_LambdaTrimShort] = samples[SampleType_LambdaTrimLong];
+  samples[SampleType_FuelMapRowCol] = samples[SampleType_FuelMapData];
+  samples[SampleType_FuelMapIndex] = samples[SampleType_FuelMapData];
+}
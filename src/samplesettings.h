@@ -0,0 +1,25 @@
+#pragma once
+#include <QString>
+#include <QMap>
+#include <QHash>
+#include <QSettings>
+#include "commonunits.h"
+#include "adaptiverate.h"
+
+/**
+ * Names, defaults, and settings-file handling for the sample types. This is
+ * shared by the options dialog and the command-line logger so that both read
+ * the same settings file in the same way.
+ */
+class SampleSettings
+{
+public:
+  static QMap<SampleType, QString> enableSettingNames();
+  static QString shortName(SampleType type);
+  static bool fromShortName(const QString& name, SampleType& type);
+  static QHash<SampleType, unsigned int> defaultReadIntervals();
+  static void readIntervalOverrides(QSettings& settings, QHash<SampleType, unsigned int>& intervals);
+  static QHash<SampleType, SampleRateLimits> defaultRateLimits();
+  static void readRateLimitOverrides(QSettings& settings, QHash<SampleType, SampleRateLimits>& limits);
+  static void groupLikeSamples(QMap<SampleType, bool>& samples);
+};
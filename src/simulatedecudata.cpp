@@ -1,213 +1,483 @@
+#include <cmath>
 #include "simulatedecudata.h"
 
-SimulatedECUData::SimulatedECUData()
+namespace
 {
+const double s_pi = 3.14159265358979;
+
+double clampValue(double val, double min, double max)
+{
+  return (val < min) ? min : ((val > max) ? max : val);
+}
+
+/**
+ * Moves a value toward a target as a first-order lag with time constant tau.
+ */
+void approach(double& val, double target, double tau, double dt)
+{
+  val += (target - val) * clampValue(dt / tau, 0.0, 1.0);
+}
+}
+
+SimulatedECUData::SimulatedECUData(uint32_t seed) :
+  m_seed(seed)
+{
+  reset();
 }
 
-void SimulatedECUData::adjust(int& val, bool& direction, int min, int max, int increment)
+/**
+ * Changes the seed and restarts the model from a cold engine.
+ */
+void SimulatedECUData::setSeed(uint32_t seed)
 {
-  if (direction)
+  m_seed = seed;
+  reset();
+}
+
+/**
+ * Restarts the model: the engine has just started from cold, at an ambient
+ * temperature chosen by the seed, and the vehicle is stationary.
+ */
+void SimulatedECUData::reset()
+{
+  m_rng.seed(m_seed);
+  m_pendingMs = 0;
+
+  m_phase = DriverPhase_Idle;
+  m_phaseRemainingS = uniform(4.0, 10.0);
+  m_throttleTarget = 0.0;
+
+  m_ambientTempF = uniform(40.0, 75.0);
+  m_coolantTempF = m_ambientTempF;
+  m_fuelTempF = m_ambientTempF;
+  m_coTrimVoltage = uniform(2.2, 2.8);
+  m_longTrimOddTarget = uniform(-40.0, 40.0);
+  m_longTrimEvenTarget = uniform(-40.0, 40.0);
+  m_longTrimOdd = 0.0;
+  m_longTrimEven = 0.0;
+  m_shortTrimOdd = 0.0;
+  m_shortTrimEven = 0.0;
+  m_shortTrimOddRising = true;
+  m_shortTrimEvenRising = false;
+
+  m_throttle = 0.0;
+  m_roadSpeedMPH = 0.0;
+  m_gear = 0;
+  m_idleBypass = 0.5;
+  m_engineRPM = targetIdleRPM();
+  m_maf = 0.0;
+  m_mainVoltage = 12.4;
+
+  // let the idle speed, airflow and charging voltage settle
+  for (int idx = 0; idx < 100; idx++)
   {
-    val += increment;
+    step(s_stepMs / 1000.0);
   }
-  else
+}
+
+/**
+ * Runs the model forward by the given amount of time. Time is consumed in
+ * fixed steps, so the readings depend only on the total time elapsed and not
+ * on how it was divided between calls.
+ */
+void SimulatedECUData::advance(unsigned int ms)
+{
+  m_pendingMs += ms;
+  while (m_pendingMs >= s_stepMs)
   {
-    val -= increment;
+    m_pendingMs -= s_stepMs;
+    step(s_stepMs / 1000.0);
   }
+}
 
-  if (direction && (val == max))
+/**
+ * Returns a uniformly-distributed value from the seeded generator. The
+ * conversion is done here rather than with a standard distribution, whose
+ * output is allowed to differ between library implementations.
+ */
+double SimulatedECUData::uniform(double min, double max)
+{
+  return min + (max - min) * ((m_rng() >> 8) * (1.0 / 16777216.0));
+}
+
+void SimulatedECUData::step(double dt)
+{
+  updateDriver(dt);
+  updateDrivetrain(dt);
+  updateAirflowAndFueling(dt);
+  updateFeedback(dt);
+  updateTemperatures(dt);
+}
+
+/**
+ * Chooses what the driver is doing and moves the throttle accordingly.
+ */
+void SimulatedECUData::updateDriver(double dt)
+{
+  m_phaseRemainingS -= dt;
+
+  if (m_phaseRemainingS <= 0.0)
   {
-    direction = false;
+    switch (m_phase)
+    {
+    case DriverPhase_Idle:
+      m_phase = DriverPhase_Accelerate;
+      break;
+
+    case DriverPhase_Accelerate:
+      m_phase = (uniform(0.0, 1.0) < 0.7) ? DriverPhase_Cruise : DriverPhase_Coast;
+      break;
+
+    case DriverPhase_Cruise:
+      m_phase = (uniform(0.0, 1.0) < 0.4) ? DriverPhase_Accelerate : DriverPhase_Coast;
+      break;
+
+    case DriverPhase_Coast:
+      if (m_roadSpeedMPH < 8.0)
+      {
+        m_phase = DriverPhase_Idle;
+      }
+      else if (uniform(0.0, 1.0) < 0.5)
+      {
+        m_phase = DriverPhase_Cruise;
+      }
+      break;
+    }
+
+    switch (m_phase)
+    {
+    case DriverPhase_Idle:
+      m_phaseRemainingS = uniform(4.0, 10.0);
+      m_throttleTarget = 0.0;
+      break;
+
+    case DriverPhase_Accelerate:
+      m_phaseRemainingS = uniform(2.0, 6.0);
+      m_throttleTarget = uniform(0.45, 1.0);
+      break;
+
+    case DriverPhase_Cruise:
+      m_phaseRemainingS = uniform(6.0, 15.0);
+      m_throttleTarget = uniform(0.12, 0.28);
+      break;
+
+    case DriverPhase_Coast:
+      m_phaseRemainingS = uniform(3.0, 7.0);
+      m_throttleTarget = 0.0;
+      break;
+    }
   }
-  else if (!direction && (val == min))
+
+  // a foot opens the throttle more slowly than the return spring closes it
+  const double maxChange = ((m_throttleTarget > m_throttle) ? 1.5 : 3.0) * dt;
+  m_throttle += clampValue(m_throttleTarget - m_throttle, -maxChange, maxChange);
+
+  if (m_throttleTarget > 0.0)
   {
-    direction = true;
+    m_throttle += uniform(-0.002, 0.002);
   }
+  m_throttle = clampValue(m_throttle, 0.0, 1.0);
+}
+
+/**
+ * Engine speed per road speed in each gear of a five-speed manual gearbox;
+ * gear 0 is neutral.
+ */
+double SimulatedECUData::gearRPMPerMPH(int gear)
+{
+  static const double ratios[6] = { 0.0, 130.0, 78.0, 52.0, 38.0, 30.0 };
+  return ratios[(gear < 0) ? 0 : ((gear > 5) ? 5 : gear)];
 }
 
-void SimulatedECUData::adjust(float& val, bool& direction, float min, float max, float increment)
+/**
+ * Updates road speed, gear and engine speed, including the idle speed
+ * control that regulates the idle air bypass valve.
+ */
+void SimulatedECUData::updateDrivetrain(double dt)
 {
-  if (direction)
+  // gear changes
+  if ((m_gear == 0) && (m_throttle > 0.05))
   {
-    val += increment;
+    m_gear = 1;
+  }
+  else if ((m_gear > 0) && (m_roadSpeedMPH < 3.0) && (m_throttle < 0.02))
+  {
+    m_gear = 0;
+  }
+  else if ((m_gear > 0) && (m_gear < 5) && (m_engineRPM > (2500.0 + 2000.0 * m_throttle)))
+  {
+    m_gear++;
+  }
+  else if ((m_gear > 1) && (m_engineRPM < 1300.0) && (m_throttle > 0.02))
+  {
+    m_gear--;
+  }
+
+  // road speed
+  const double ratio = gearRPMPerMPH(m_gear);
+  const double torque = 0.7 + 0.3 * std::sin(s_pi * clampValue(m_engineRPM / 5500.0, 0.0, 1.0));
+  double accel = -0.15 - (0.00025 * m_roadSpeedMPH * m_roadSpeedMPH);
+
+  if (m_gear > 0)
+  {
+    accel += 4.0 * m_throttle * torque * (ratio / 52.0);
+    if (m_throttle < 0.02)
+    {
+      accel -= 0.6;
+    }
+  }
+  if (m_phase == DriverPhase_Idle)
+  {
+    accel -= 3.0;
+  }
+  m_roadSpeedMPH = clampValue(m_roadSpeedMPH + (accel * dt), 0.0, 130.0);
+
+  // idle air control: the bypass valve is stepped to hold the target idle speed
+  const double warm = warmUpFraction();
+  const double idleRPMFromAir = 250.0 + (m_idleBypass * 1000.0 * (0.7 + 0.3 * warm));
+  if (idleMode())
+  {
+    m_idleBypass += (targetIdleRPM() - m_engineRPM) * 0.0004 * dt;
   }
   else
   {
-    val -= increment;
+    approach(m_idleBypass, 0.3 + 0.3 * (1.0 - warm), 5.0, dt);
   }
+  m_idleBypass = clampValue(m_idleBypass, 0.0, 1.0);
+
+  // engine speed
+  double targetRPM = idleRPMFromAir + (m_throttle * 3000.0);
+  double tau = 0.3;
 
-  if (direction && (val >= max))
+  if (m_gear > 0)
   {
-    direction = false;
+    const double wheelRPM = m_roadSpeedMPH * ratio;
+    const double slipRPM = idleRPMFromAir + ((wheelRPM < 1200.0) ? (m_throttle * 1200.0) : 0.0);
+    targetRPM = (wheelRPM > slipRPM) ? wheelRPM : slipRPM;
+    tau = 0.15;
   }
-  else if (!direction && (val <= min))
+  if (targetRPM > s_rpmLimit)
   {
-    direction = true;
+    targetRPM = s_rpmLimit;
   }
+
+  approach(m_engineRPM, targetRPM + uniform(-15.0, 15.0), tau, dt);
 }
 
-void SimulatedECUData::adjustFuelMapRowCol()
+/**
+ * Derives airflow from throttle opening and engine speed, load from airflow
+ * and engine speed, the fuel map position from load and engine speed, and
+ * the injector pulse width from the fuel map.
+ */
+void SimulatedECUData::updateAirflowAndFueling(double dt)
 {
-  if (m_fuelMapRowDirection)
+  const double rpmFraction = m_engineRPM / 6000.0;
+  const double opening = clampValue(m_throttle + (0.06 * m_idleBypass), 0.0, 1.0);
+  const double fill = clampValue((opening * 2.5) / (0.5 + (m_engineRPM / 3000.0)), 0.0, 1.0);
+
+  approach(m_maf, clampValue(0.02 + (0.95 * rpmFraction * fill), 0.0, 1.0), 0.05, dt);
+
+  m_load = (rpmFraction > 0.0) ? clampValue((m_maf - 0.02) / (0.95 * rpmFraction), 0.0, 1.0) : 0.0;
+  m_rowPosition = m_load * (FUEL_MAP_ROWS - 1);
+
+  // column breakpoints are those of engineRPMTable()
+  m_columnPosition = clampValue((m_engineRPM - 500.0) / 250.0, 0.0, FUEL_MAP_COLUMNS - 1);
+
+  const bool overrunCutoff = (m_gear > 0) && (m_throttle < 0.01) && (m_engineRPM > 1500.0);
+  const bool rpmLimitCutoff = (m_engineRPM >= s_rpmLimit);
+
+  if (overrunCutoff || rpmLimitCutoff)
   {
-    if (m_fuelMapRowWeight < 15)
-    {
-      m_fuelMapRowWeight++;
-    }
-    else
-    {
-      if (m_fuelMapRowIndex < 7)
-      {
-        m_fuelMapRowIndex++;
-        m_fuelMapRowWeight = 0;
-      }
-      else
-      {
-        m_fuelMapRowWeight--;
-        m_fuelMapRowDirection = false;
-      }
-    }
+    m_pulseWidthUs = 0.0;
   }
-  else // decreasing value
+  else
   {
-    if (m_fuelMapRowWeight > 0)
-    {
-      m_fuelMapRowWeight--;
-    }
-    else
-    {
-      if (m_fuelMapRowIndex > 0)
-      {
-        m_fuelMapRowIndex--;
-        m_fuelMapRowWeight = 15;
-      }
-      else
-      {
-        m_fuelMapRowWeight++;
-        m_fuelMapRowDirection = true;
-      }
-    }
+    const double adjustment = s_fuelMapAdjFactor / 65536.0;
+    const double coldEnrichment = 1.0 + (0.4 * (1.0 - warmUpFraction()));
+    const double trim = 1.0 + ((m_shortTrimOdd + m_shortTrimEven + m_longTrimOdd + m_longTrimEven) / 2.0 / 1024.0);
+
+    m_pulseWidthUs = 700.0 + (interpolatedFuelMapValue() * adjustment * 60.0 * coldEnrichment * trim);
   }
+}
+
+/**
+ * Moves a short-term lambda trim up or down at the given rate, turning around
+ * when it passes the given distance from its center, as the oxygen sensor
+ * switches between rich and lean.
+ */
+void SimulatedECUData::updateShortTrim(double& trim, bool& rising, double center, double amplitude, double rate)
+{
+  trim += rising ? rate : -rate;
 
-  if (m_fuelMapColumnDirection)
+  if (rising && (trim >= (center + amplitude)))
   {
-    if (m_fuelMapColumnWeight < 15)
-    {
-      m_fuelMapColumnWeight++;
-    }
-    else
-    {
-      if (m_fuelMapColumnIndex < 15)
-      {
-        m_fuelMapColumnIndex++;
-        m_fuelMapColumnWeight = 0;
-      }
-      else
-      {
-        m_fuelMapColumnWeight--;
-        m_fuelMapColumnDirection = false;
-      }
-    }
+    rising = false;
   }
-  else // decreasing value
+  else if (!rising && (trim <= (center - amplitude)))
   {
-    if (m_fuelMapColumnWeight > 0)
-    {
-      m_fuelMapColumnWeight--;
-    }
-    else
-    {
-      if (m_fuelMapColumnIndex > 0)
-      {
-        m_fuelMapColumnIndex--;
-        m_fuelMapColumnWeight = 15;
-      }
-      else
-      {
-        m_fuelMapColumnWeight++;
-        m_fuelMapColumnDirection = true;
-      }
-    }
+    rising = true;
+  }
+}
+
+/**
+ * Updates the closed-loop lambda trims and the charging voltage. The long-term
+ * trims slowly learn each bank's fueling error, and the short-term trims
+ * oscillate around the part of the error that has not yet been learned.
+ */
+void SimulatedECUData::updateFeedback(double dt)
+{
+  const bool sensorsReady = (warmUpFraction() >= 0.5);
+  const bool fueling = (m_pulseWidthUs > 0.0);
+
+  if (sensorsReady && fueling)
+  {
+    approach(m_longTrimOdd, m_longTrimOddTarget, 60.0, dt);
+    approach(m_longTrimEven, m_longTrimEvenTarget, 60.0, dt);
+
+    // the sensors switch faster as more exhaust gas flows past them
+    const double rate = 100.0 * (0.5 + (m_engineRPM / 2000.0)) * dt;
+    updateShortTrim(m_shortTrimOdd, m_shortTrimOddRising,
+                    m_longTrimOddTarget - m_longTrimOdd, 24.0 + uniform(-4.0, 4.0), rate);
+    updateShortTrim(m_shortTrimEven, m_shortTrimEvenRising,
+                    m_longTrimEvenTarget - m_longTrimEven, 24.0 + uniform(-4.0, 4.0), rate);
+  }
+  else if (!sensorsReady)
+  {
+    m_shortTrimOdd = 0.0;
+    m_shortTrimEven = 0.0;
   }
+
+  const double chargingVoltage = 13.6 + (0.5 * clampValue(m_engineRPM / 2500.0, 0.0, 1.0));
+  approach(m_mainVoltage, chargingVoltage + uniform(-0.02, 0.02), 0.5, dt);
+}
+
+/**
+ * Warms the coolant until the thermostat opens, after which it settles at a
+ * temperature that rises with load and falls with airflow through the
+ * radiator. The fuel rail follows the coolant slowly, and is cooled by the
+ * flow of fresh fuel.
+ */
+void SimulatedECUData::updateTemperatures(double dt)
+{
+  const double heatRate = 0.25 + (1.6 * m_maf);
+  const double thermostatOpen = clampValue((m_coolantTempF - 180.0) / 12.0, 0.0, 1.0);
+  const double regulatedTempF = 195.0 + (15.0 * m_maf) - (0.05 * m_roadSpeedMPH);
+
+  m_coolantTempF += ((1.0 - thermostatOpen) * heatRate +
+                     thermostatOpen * (regulatedTempF - m_coolantTempF) / 25.0) * dt;
+
+  const double fuelTargetF = m_ambientTempF + (0.45 * (m_coolantTempF - m_ambientTempF)) - (15.0 * m_maf);
+  approach(m_fuelTempF, (fuelTargetF > m_ambientTempF) ? fuelTargetF : m_ambientTempF, 200.0, dt);
+}
+
+/**
+ * Returns how far the engine has warmed up, from 0 (cold) to 1 (normal
+ * operating temperature).
+ */
+double SimulatedECUData::warmUpFraction() const
+{
+  return clampValue((m_coolantTempF - 50.0) / 135.0, 0.0, 1.0);
+}
+
+double SimulatedECUData::targetIdleRPM() const
+{
+  return 580.0 + (370.0 * (1.0 - warmUpFraction()));
+}
+
+/**
+ * Fuel map contents: fueling rises with load (row) and has a mild peak in the
+ * middle of the engine speed range (column).
+ */
+uint8_t SimulatedECUData::fuelMapValue(int row, int col) const
+{
+  return (uint8_t)(40 + (row * 21) + col + (int)(10.0 * std::sin(s_pi * col / (FUEL_MAP_COLUMNS - 1))));
+}
+
+/**
+ * Returns the fuel map value at the current row/column position, interpolated
+ * between the four surrounding cells.
+ */
+double SimulatedECUData::interpolatedFuelMapValue() const
+{
+  const int row = (int)m_rowPosition;
+  const int col = (int)m_columnPosition;
+  const int nextRow = (row < (FUEL_MAP_ROWS - 1)) ? (row + 1) : row;
+  const int nextCol = (col < (FUEL_MAP_COLUMNS - 1)) ? (col + 1) : col;
+  const double rowFraction = m_rowPosition - row;
+  const double colFraction = m_columnPosition - col;
+
+  const double top = fuelMapValue(row, col) * (1.0 - colFraction) + fuelMapValue(row, nextCol) * colFraction;
+  const double bottom = fuelMapValue(nextRow, col) * (1.0 - colFraction) + fuelMapValue(nextRow, nextCol) * colFraction;
+
+  return top * (1.0 - rowFraction) + bottom * rowFraction;
 }
 
-float SimulatedECUData::maf()
+float SimulatedECUData::maf() const
 {
-  adjust(m_maf, m_mafDirection, 0.01f, 0.99f, 0.01f);
-  return m_maf;
+  return (float)m_maf;
 }
 
-float SimulatedECUData::throttle()
+float SimulatedECUData::throttle() const
 {
-  adjust(m_throttle, m_throttleDirection, 0.01f, 0.99f, 0.01f);
-  return m_throttle;
+  return (float)m_throttle;
 }
 
-int16_t SimulatedECUData::lambdaShortOdd()
+int16_t SimulatedECUData::lambdaShortOdd() const
 {
-  adjust(m_lambdaShortOdd, m_lambdaShortOddDirection, -256, 255, 1);
-  return m_lambdaShortOdd;
+  return (int16_t)clampValue(std::round(m_shortTrimOdd), -256.0, 255.0);
 }
 
-int16_t SimulatedECUData::lambdaShortEven()
+int16_t SimulatedECUData::lambdaShortEven() const
 {
-  adjust(m_lambdaShortEven, m_lambdaShortEvenDirection, -256, 255, 1);
-  return m_lambdaShortEven;
+  return (int16_t)clampValue(std::round(m_shortTrimEven), -256.0, 255.0);
 }
 
-int16_t SimulatedECUData::lambdaLongOdd()
+int16_t SimulatedECUData::lambdaLongOdd() const
 {
-  adjust(m_lambdaLongOdd, m_lambdaLongOddDirection, -256, 255, 1);
-  return m_lambdaLongOdd;
+  return (int16_t)clampValue(std::round(m_longTrimOdd), -256.0, 255.0);
 }
 
-int16_t SimulatedECUData::lambdaLongEven()
+int16_t SimulatedECUData::lambdaLongEven() const
 {
-  adjust(m_lambdaLongEven, m_lambdaLongEvenDirection, -256, 255, 1);
-  return m_lambdaLongEven;
+  return (int16_t)clampValue(std::round(m_longTrimEven), -256.0, 255.0);
 }
 
-bool SimulatedECUData::mil()
+bool SimulatedECUData::mil() const
 {
-  return m_milOn;
+  return false;
 }
 
-float SimulatedECUData::coolantTempF()
+float SimulatedECUData::coolantTempF() const
 {
-  adjust(m_coolantTempF, m_coolantTempDirection, 40.0f, 230.0f, 2.5f);
-  return m_coolantTempF;
+  return (float)m_coolantTempF;
 }
 
-float SimulatedECUData::fuelTempF()
+float SimulatedECUData::fuelTempF() const
 {
-  adjust(m_fuelTempF, m_fuelTempDirection, 40.0f, 230.0f, 2.0f);
-  return m_fuelTempF;
+  return (float)m_fuelTempF;
 }
 
-float SimulatedECUData::mainVoltage()
+float SimulatedECUData::mainVoltage() const
 {
-  adjust(m_mainVoltage, m_mainVoltageDirection, 10.0f, 14.0f, 0.05f);
-  return m_mainVoltage;
+  return (float)m_mainVoltage;
 }
 
-float SimulatedECUData::coTrimVoltage()
+float SimulatedECUData::coTrimVoltage() const
 {
-  adjust(m_coTrimVoltage, m_coTrimVoltageDirection, 0.5f, 4.9f, 0.05f);
-  return m_coTrimVoltage;
+  return (float)m_coTrimVoltage;
 }
 
-uint16_t SimulatedECUData::engineRPM()
+uint16_t SimulatedECUData::engineRPM() const
 {
-  adjust(m_engineRPM, m_engineRPMDirection, 600, 5500, 5);
-  return m_engineRPM;
+  return (uint16_t)std::lround(m_engineRPM);
 }
 
-uint16_t SimulatedECUData::engineRPMLimit()
+uint16_t SimulatedECUData::engineRPMLimit() const
 {
-  return m_engineRPMLimit;
+  return s_rpmLimit;
 }
 
-void SimulatedECUData::engineRPMTable(c14cux_rpmtable& table)
+void SimulatedECUData::engineRPMTable(c14cux_rpmtable& table) const
 {
   for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
   {
@@ -215,69 +485,68 @@ void SimulatedECUData::engineRPMTable(c14cux_rpmtable& table)
   }
 }
 
-void SimulatedECUData::fuelMapData(uint8_t* buf, uint16_t& mafScaler, uint16_t& adjFactor)
+void SimulatedECUData::fuelMapData(uint8_t* buf, uint16_t& mafScaler, uint16_t& adjFactor) const
 {
-  mafScaler = 0xabcd;
-  adjFactor = 0xaaaa;
+  mafScaler = s_mafScaler;
+  adjFactor = s_fuelMapAdjFactor;
   for (int row = 0; row < FUEL_MAP_ROWS; row++)
   {
     for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
     {
-      buf[row*16 + col] = row * col * 2 + row * 3 + col;
+      buf[row*16 + col] = fuelMapValue(row, col);
     }
   }
 }
 
-void SimulatedECUData::fuelMapRowColIndices(uint8_t& rowIndex, uint8_t& rowWeight, uint8_t& colIndex, uint8_t& colWeight)
+/**
+ * Splits the fuel map position into cell indices and sixteenths of the way
+ * to the next cell, as the ECU reports them.
+ */
+void SimulatedECUData::fuelMapRowColIndices(uint8_t& rowIndex, uint8_t& rowWeight, uint8_t& colIndex, uint8_t& colWeight) const
 {
-  adjustFuelMapRowCol();
-  rowIndex = m_fuelMapRowIndex;
-  rowWeight = m_fuelMapRowWeight;
-  colIndex = m_fuelMapColumnIndex;
-  colWeight = m_fuelMapColumnWeight;
+  rowIndex = (uint8_t)m_rowPosition;
+  rowWeight = (uint8_t)clampValue((m_rowPosition - rowIndex) * 16.0, 0.0, 15.0);
+  colIndex = (uint8_t)m_columnPosition;
+  colWeight = (uint8_t)clampValue((m_columnPosition - colIndex) * 16.0, 0.0, 15.0);
 }
 
-uint16_t SimulatedECUData::targetIdle()
+uint16_t SimulatedECUData::targetIdle() const
 {
-  adjust(m_targetIdleRPM, m_targetIdleRPMDirection, 580, 700, 3);
-  return m_targetIdleRPM;
+  return (uint16_t)std::lround(targetIdleRPM());
 }
 
-bool SimulatedECUData::idleMode()
+bool SimulatedECUData::idleMode() const
 {
-  return (m_targetIdleRPM < 700) && (m_throttle < 0.05);
+  return (m_gear == 0) && (m_throttle < 0.02) && (m_roadSpeedMPH < 4.0);
 }
 
-uint8_t SimulatedECUData::currentFuelMap()
+uint8_t SimulatedECUData::currentFuelMap() const
 {
-  return m_currentFuelMap;
+  return s_currentFuelMap;
 }
 
-uint8_t SimulatedECUData::roadSpeedMPH()
+uint8_t SimulatedECUData::roadSpeedMPH() const
 {
-  adjust(m_roadSpeedMPH, m_roadSpeedMPHDirection, 20, 25, 1);
-  return m_roadSpeedMPH;
+  return (uint8_t)std::lround(m_roadSpeedMPH);
 }
 
-float SimulatedECUData::idleBypassPos()
+float SimulatedECUData::idleBypassPos() const
 {
-  adjust(m_idleBypassPercentage, m_idleBypassPercentageDirection, 0.01f, 0.99f, 0.01f);
-  return m_idleBypassPercentage;
+  return (float)m_idleBypass;
 }
 
-bool SimulatedECUData::fuelPumpRelayState()
+bool SimulatedECUData::fuelPumpRelayState() const
 {
-  return true;
+  return (m_engineRPM > 0.0);
 }
 
-uint8_t SimulatedECUData::gearSelection()
+uint8_t SimulatedECUData::gearSelection() const
 {
   return 0x03;
 }
 
-uint16_t SimulatedECUData::injectorPulsewidthUs()
+uint16_t SimulatedECUData::injectorPulsewidthUs() const
 {
-  adjust(m_injectorPulseWidthUs, m_injectorPulseWidthUsDirection, 100, 20000, 100);
-  return m_injectorPulseWidthUs;
+  return (uint16_t)std::lround(m_pulseWidthUs);
 }
 
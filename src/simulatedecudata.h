@@ -1,79 +1,114 @@
 #pragma once
 #include <cstdint>
+#include <random>
 #include "comm14cux.h"
 
+/**
+ * Coupled model of a running engine, standing in for a 14CUX when a connection
+ * is simulated. A driver alternates between idling, cruising, accelerating and
+ * coasting; throttle opening and engine speed determine the airflow, airflow
+ * and engine speed determine the load, the load and speed select the fuel map
+ * cell, and the injector pulse width follows the fuel map value times the
+ * map's adjustment factor. Coolant and fuel temperatures start cold and warm
+ * up as the engine runs.
+ *
+ * The model only moves forward when advance() is called, in fixed time steps,
+ * and all of its randomness comes from a seeded generator; a given seed and
+ * amount of elapsed time therefore always produce the same readings.
+ */
 class SimulatedECUData
 {
 public:
-  SimulatedECUData();
-  float maf();
-  float throttle();
-  int16_t lambdaShortOdd();
-  int16_t lambdaShortEven();
-  int16_t lambdaLongOdd();
-  int16_t lambdaLongEven();
-  bool mil();
-  float coolantTempF();
-  float fuelTempF();
-  float mainVoltage();
-  float coTrimVoltage();
-  uint16_t engineRPM();
-  uint16_t engineRPMLimit();
-  void engineRPMTable(c14cux_rpmtable& table);
-  void fuelMapData(uint8_t* buf, uint16_t& mafScaler, uint16_t& adjFactor);
-  void fuelMapRowColIndices(uint8_t& rowIndex, uint8_t& rowWeight, uint8_t& colIndex, uint8_t& colWeight);
-  uint16_t targetIdle();
-  bool idleMode();
-  uint8_t currentFuelMap();
-  uint8_t roadSpeedMPH();
-  float idleBypassPos();
-  bool fuelPumpRelayState();
-  uint8_t gearSelection();
-  uint16_t injectorPulsewidthUs();
+  explicit SimulatedECUData(uint32_t seed = 1);
+
+  void setSeed(uint32_t seed);
+  void reset();
+  void advance(unsigned int ms);
+
+  float maf() const;
+  float throttle() const;
+  int16_t lambdaShortOdd() const;
+  int16_t lambdaShortEven() const;
+  int16_t lambdaLongOdd() const;
+  int16_t lambdaLongEven() const;
+  bool mil() const;
+  float coolantTempF() const;
+  float fuelTempF() const;
+  float mainVoltage() const;
+  float coTrimVoltage() const;
+  uint16_t engineRPM() const;
+  uint16_t engineRPMLimit() const;
+  void engineRPMTable(c14cux_rpmtable& table) const;
+  void fuelMapData(uint8_t* buf, uint16_t& mafScaler, uint16_t& adjFactor) const;
+  void fuelMapRowColIndices(uint8_t& rowIndex, uint8_t& rowWeight, uint8_t& colIndex, uint8_t& colWeight) const;
+  uint16_t targetIdle() const;
+  bool idleMode() const;
+  uint8_t currentFuelMap() const;
+  uint8_t roadSpeedMPH() const;
+  float idleBypassPos() const;
+  bool fuelPumpRelayState() const;
+  uint8_t gearSelection() const;
+  uint16_t injectorPulsewidthUs() const;
 
 private:
-  float m_maf = 0.0;
-  bool m_mafDirection = true;
-  float m_throttle = 0.0;
-  bool m_throttleDirection = true;
-  int m_lambdaShortOdd = 0;
-  bool m_lambdaShortOddDirection = true;
-  int m_lambdaShortEven = 0;
-  bool m_lambdaShortEvenDirection = false;
-  int m_lambdaLongOdd = 0;
-  bool m_lambdaLongOddDirection = true;
-  int m_lambdaLongEven = 0;
-  bool m_lambdaLongEvenDirection = false;
-  bool m_milOn = false;
-  float m_coolantTempF = 40.0f;
-  bool m_coolantTempDirection = true;
-  float m_fuelTempF = 40.0f;
-  bool m_fuelTempDirection = true;
-  float m_mainVoltage = 12.0f;
-  bool m_mainVoltageDirection = true;
-  float m_coTrimVoltage = 4.0f;
-  bool m_coTrimVoltageDirection = true;
-  int m_engineRPM = 750;
-  bool m_engineRPMDirection = true;
-  int m_engineRPMLimit = 5750;
-  int m_fuelMapRowIndex = 0;
-  int m_fuelMapRowWeight = 0;
-  bool m_fuelMapRowDirection = true;
-  int m_fuelMapColumnIndex = 0;
-  int m_fuelMapColumnWeight = 0;
-  bool m_fuelMapColumnDirection = true;
-  int m_targetIdleRPM = 580;
-  bool m_targetIdleRPMDirection = true;
-  int m_currentFuelMap = 5;
-  int m_roadSpeedMPH = 0;
-  bool m_roadSpeedMPHDirection = true;
-  float m_idleBypassPercentage = 0.4f;
-  bool m_idleBypassPercentageDirection = false;
-  int m_injectorPulseWidthUs = 100;
-  bool m_injectorPulseWidthUsDirection = true;
+  enum DriverPhase
+  {
+    DriverPhase_Idle,
+    DriverPhase_Accelerate,
+    DriverPhase_Cruise,
+    DriverPhase_Coast
+  };
+
+  uint32_t m_seed;
+  std::mt19937 m_rng;
+  unsigned int m_pendingMs = 0;
+
+  DriverPhase m_phase = DriverPhase_Idle;
+  double m_phaseRemainingS = 0.0;
+  double m_throttleTarget = 0.0;
+
+  double m_ambientTempF = 60.0;
+  double m_throttle = 0.0;
+  double m_roadSpeedMPH = 0.0;
+  int m_gear = 0;
+  double m_engineRPM = 0.0;
+  double m_maf = 0.0;
+  double m_load = 0.0;
+  double m_rowPosition = 0.0;
+  double m_columnPosition = 0.0;
+  double m_pulseWidthUs = 0.0;
+  double m_idleBypass = 0.5;
+  double m_coolantTempF = 60.0;
+  double m_fuelTempF = 60.0;
+  double m_mainVoltage = 12.4;
+  double m_coTrimVoltage = 2.5;
+  double m_longTrimOdd = 0.0;
+  double m_longTrimEven = 0.0;
+  double m_longTrimOddTarget = 0.0;
+  double m_longTrimEvenTarget = 0.0;
+  double m_shortTrimOdd = 0.0;
+  double m_shortTrimEven = 0.0;
+  bool m_shortTrimOddRising = true;
+  bool m_shortTrimEvenRising = false;
+
+  static const unsigned int s_stepMs = 10;
+  static const int s_rpmLimit = 5750;
+  static const uint16_t s_fuelMapAdjFactor = 0xaaaa;
+  static const uint16_t s_mafScaler = 0xabcd;
+  static const uint8_t s_currentFuelMap = 5;
 
-  void adjust(int& val, bool& direction, int min, int max, int inc);
-  void adjust(float& val, bool& direction, float min, float max, float inc);
-  void adjustFuelMapRowCol();
+  double uniform(double min, double max);
+  void step(double dt);
+  void updateDriver(double dt);
+  void updateDrivetrain(double dt);
+  void updateAirflowAndFueling(double dt);
+  void updateFeedback(double dt);
+  void updateTemperatures(double dt);
+  double warmUpFraction() const;
+  double targetIdleRPM() const;
+  uint8_t fuelMapValue(int row, int col) const;
+  double interpolatedFuelMapValue() const;
+  static double gearRPMPerMPH(int gear);
+  static void updateShortTrim(double& trim, bool& rising, double center, double amplitude, double rate);
 };
 
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+
+/**
+ * Lock-free ring buffer that passes items from exactly one producer thread to
+ * exactly one consumer thread. When the ring is full, new items are dropped
+ * (and counted) rather than blocking the producer. The capacity must be a
+ * power of two.
+ */
+template<typename T, unsigned int Capacity>
+class SpscRing
+{
+  static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0),
+                "SpscRing capacity must be a power of two");
+
+public:
+  /**
+   * Appends an item to the ring. Must only be called from the producer thread.
+   * @return True if the item was stored; false if the ring was full
+   */
+  bool push(const T& item)
+  {
+    const unsigned int head = m_head.load(std::memory_order_relaxed);
+    const unsigned int tail = m_tail.load(std::memory_order_acquire);
+
+    if ((head - tail) == Capacity)
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    m_items[head & (Capacity - 1)] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest item from the ring. Must only be called from the
+   * consumer thread.
+   * @return True if an item was retrieved; false if the ring was empty
+   */
+  bool pop(T& item)
+  {
+    const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+    const unsigned int head = m_head.load(std::memory_order_acquire);
+
+    if (head == tail)
+    {
+      return false;
+    }
+
+    item = m_items[tail & (Capacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns the number of items currently waiting in the ring. The value is
+   * only approximate when read while the other thread is active.
+   */
+  unsigned int size() const
+  {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Returns the number of items that were dropped because the ring was full.
+   */
+  unsigned int droppedCount() const
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  T m_items[Capacity];
+  alignas(64) std::atomic<unsigned int> m_head{0};
+  alignas(64) std::atomic<unsigned int> m_tail{0};
+  std::atomic<unsigned int> m_dropped{0};
+};
@@ -0,0 +1,539 @@
+#include <algorithm>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QPolygonF>
+#include <QLineF>
+#include "stripchart.h"
+#include "logreplaysource.h"
+
+namespace
+{
+/**
+ * Returns the value of a reading from a frame, in the units in which it is
+ * plotted.
+ */
+float channelValue(const TelemetryFrame& frame, StripChartChannel channel)
+{
+  switch (channel)
+  {
+  case StripChartChannel_RoadSpeed:          return frame.roadSpeed;
+  case StripChartChannel_EngineRPM:          return frame.engineSpeedRPM;
+  case StripChartChannel_TargetIdleSpeed:    return frame.targetIdleSpeed;
+  case StripChartChannel_CoolantTemp:        return frame.coolantTemp;
+  case StripChartChannel_FuelTemp:           return frame.fuelTemp;
+  case StripChartChannel_Throttle:           return frame.throttlePos * 100.0f;
+  case StripChartChannel_MAF:                return frame.mafReading * 100.0f;
+  case StripChartChannel_IdleBypassPos:      return frame.idleBypassPos * 100.0f;
+  case StripChartChannel_MainVoltage:        return frame.mainVoltage;
+  case StripChartChannel_InjectorPulseWidth: return frame.injectorPulseWidthMs;
+  case StripChartChannel_LambdaTrimOdd:      return frame.lambdaTrimOdd;
+  case StripChartChannel_LambdaTrimEven:     return frame.lambdaTrimEven;
+  default:                                   return 0.0f;
+  }
+}
+
+/**
+ * Formats a length of time as h:mm:ss, or m:ss.z when it is under an hour.
+ */
+QString elapsedText(qint64 ms)
+{
+  const qint64 secs = ms / 1000;
+
+  if (secs >= 3600)
+  {
+    return QString("%1:%2:%3").arg(secs / 3600).arg((secs / 60) % 60, 2, 10, QChar('0'))
+                              .arg(secs % 60, 2, 10, QChar('0'));
+  }
+
+  return QString("%1:%2.%3").arg(secs / 60).arg(secs % 60, 2, 10, QChar('0')).arg((ms % 1000) / 100);
+}
+}
+
+/**
+ * Discards every frame of the session.
+ */
+void StripChart::Session::clear()
+{
+  timesMs.clear();
+  for (DecimationPyramid& channel : channels)
+  {
+    channel.clear();
+  }
+}
+
+/**
+ * Reserves space for the given number of frames.
+ */
+void StripChart::Session::reserve(int count)
+{
+  timesMs.reserve(count);
+  for (DecimationPyramid& channel : channels)
+  {
+    channel.reserve(count);
+  }
+}
+
+/**
+ * Adds a frame to the end of the session. The wall clock may be stepped
+ * backwards while a session is being recorded; a frame that appears to be
+ * older than its predecessor is placed at the same time instead, so that the
+ * timestamps stay in order for searching.
+ */
+void StripChart::Session::append(const TelemetryFrame& frame)
+{
+  timesMs.append(timesMs.isEmpty() ? frame.timestampMs : qMax(frame.timestampMs, timesMs.last()));
+
+  for (int channel = 0; channel < (int)StripChartChannel_NumChannels; channel++)
+  {
+    channels[channel].append(channelValue(frame, (StripChartChannel)channel));
+  }
+}
+
+/**
+ * Discards the frames older than the given time.
+ */
+void StripChart::Session::removeBefore(qint64 timeMs)
+{
+  const int count = indexAt(timeMs);
+
+  timesMs.remove(0, count);
+  for (DecimationPyramid& channel : channels)
+  {
+    channel.removeFirst(count);
+  }
+}
+
+/**
+ * Returns the position of the first frame at or after the given time.
+ */
+int StripChart::Session::indexAt(qint64 timeMs) const
+{
+  return (int)(std::lower_bound(timesMs.constBegin(), timesMs.constEnd(), timeMs) - timesMs.constBegin());
+}
+
+/**
+ * Constructor. The engine speed, road speed, throttle, and coolant
+ * temperature are shown to begin with.
+ */
+StripChart::StripChart(QWidget* parent) :
+  QWidget(parent)
+{
+  for (int channel = 0; channel < (int)StripChartChannel_NumChannels; channel++)
+  {
+    m_visible[channel] = false;
+  }
+  m_visible[StripChartChannel_EngineRPM] = true;
+  m_visible[StripChartChannel_RoadSpeed] = true;
+  m_visible[StripChartChannel_Throttle] = true;
+  m_visible[StripChartChannel_CoolantTemp] = true;
+
+  setMinimumSize(400, 200);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+/**
+ * Returns the name of a reading, with the units in which it is plotted
+ * where they don't depend on the settings.
+ */
+QString StripChart::channelName(StripChartChannel channel)
+{
+  switch (channel)
+  {
+  case StripChartChannel_RoadSpeed:          return "Road speed";
+  case StripChartChannel_EngineRPM:          return "Engine speed (RPM)";
+  case StripChartChannel_TargetIdleSpeed:    return "Target idle (RPM)";
+  case StripChartChannel_CoolantTemp:        return "Coolant temp";
+  case StripChartChannel_FuelTemp:           return "Fuel temp";
+  case StripChartChannel_Throttle:           return "Throttle (%)";
+  case StripChartChannel_MAF:                return "MAF (%)";
+  case StripChartChannel_IdleBypassPos:      return "Idle bypass (%)";
+  case StripChartChannel_MainVoltage:        return "Main voltage (V)";
+  case StripChartChannel_InjectorPulseWidth: return "Injector PW (ms)";
+  case StripChartChannel_LambdaTrimOdd:      return "Lambda trim (odd)";
+  case StripChartChannel_LambdaTrimEven:     return "Lambda trim (even)";
+  default:                                   return QString();
+  }
+}
+
+/**
+ * Returns the color in which a reading is plotted.
+ */
+QColor StripChart::channelColor(StripChartChannel channel)
+{
+  static const QColor colors[StripChartChannel_NumChannels] =
+  {
+    QColor(31, 119, 180), QColor(214, 39, 40), QColor(255, 127, 14), QColor(44, 160, 44),
+    QColor(148, 103, 189), QColor(140, 86, 75), QColor(227, 119, 194), QColor(127, 127, 127),
+    QColor(188, 189, 34), QColor(23, 190, 207), QColor(0, 90, 50), QColor(120, 0, 90)
+  };
+
+  return colors[channel];
+}
+
+QSize StripChart::sizeHint() const
+{
+  return QSize(900, 500);
+}
+
+/**
+ * Adds a frame to the live session. If the live session is being followed,
+ * the view moves along to include it. Only the most recent s_liveHistoryMs
+ * of the live session are kept; older frames are dropped once they have
+ * built up past a further s_liveTrimSlackMs, so that the summaries are only
+ * rebuilt occasionally.
+ */
+void StripChart::appendFrame(const TelemetryFrame& frame)
+{
+  m_live.append(frame);
+
+  if ((m_live.lastMs() - m_live.firstMs()) > (s_liveHistoryMs + s_liveTrimSlackMs))
+  {
+    m_live.removeBefore(m_live.lastMs() - s_liveHistoryMs);
+  }
+
+  if (!m_showLog)
+  {
+    if (m_following)
+    {
+      m_viewEndMs = m_live.lastMs();
+    }
+
+    if (isVisible() && (m_live.lastMs() >= m_viewEndMs - m_viewSpanMs) &&
+        (m_live.lastMs() <= m_viewEndMs))
+    {
+      update();
+    }
+  }
+}
+
+/**
+ * Discards the frames of the live session.
+ */
+void StripChart::clearLive()
+{
+  m_live.clear();
+  if (!m_showLog)
+  {
+    m_following = true;
+    update();
+  }
+}
+
+/**
+ * Reads every frame of a log into the log session and shows the whole of it.
+ * The whole log is decoded up front, since the summaries used to draw it
+ * zoomed out need every value; zooming and panning afterwards never go back
+ * to the file.
+ * @param source Log to read, which must already be open
+ * @return True if the log held any frames, false otherwise
+ */
+bool StripChart::loadLog(LogReplaySource& source)
+{
+  TelemetryFrame frame;
+
+  m_log.clear();
+  if (source.seek(source.firstTimestampMs()))
+  {
+    while (source.next(frame))
+    {
+      m_log.append(frame);
+    }
+  }
+
+  showLog();
+
+  return !m_log.timesMs.isEmpty();
+}
+
+/**
+ * Switches to the live session, following the newest frame.
+ */
+void StripChart::showLive()
+{
+  m_showLog = false;
+  m_following = true;
+  m_viewSpanMs = s_defaultSpanMs;
+  m_viewEndMs = m_live.lastMs();
+  update();
+}
+
+/**
+ * Switches to the log session, showing the whole log.
+ */
+void StripChart::showLog()
+{
+  m_showLog = true;
+  m_following = false;
+  m_viewSpanMs = qMax(m_log.lastMs() - m_log.firstMs(), s_minSpanMs);
+  m_viewEndMs = m_log.firstMs() + m_viewSpanMs;
+  update();
+}
+
+/**
+ * Shows or hides the lane for a reading.
+ */
+void StripChart::setChannelVisible(StripChartChannel channel, bool visible)
+{
+  m_visible[channel] = visible;
+  update();
+}
+
+bool StripChart::isChannelVisible(StripChartChannel channel) const
+{
+  return m_visible[channel];
+}
+
+/**
+ * Returns the area in which the lanes are drawn, which excludes the labels
+ * to their left and the time axis below them.
+ */
+QRect StripChart::plotRect() const
+{
+  return rect().adjusted(s_labelWidth, 4, -4, -s_timeAxisHeight);
+}
+
+/**
+ * Moves the view to end at the given time and cover the given span, keeping
+ * it within the session. Moving the end of the view to the newest frame of
+ * the live session makes the view follow it again.
+ */
+void StripChart::setView(qint64 endMs, qint64 spanMs)
+{
+  const Session& data = session();
+  const qint64 sessionSpanMs = data.lastMs() - data.firstMs();
+
+  m_viewSpanMs = qBound(s_minSpanMs, spanMs, qMax(sessionSpanMs, s_defaultSpanMs));
+  m_viewEndMs = qBound(data.firstMs() + qMin(m_viewSpanMs, sessionSpanMs), endMs, data.lastMs());
+  m_following = !m_showLog && (m_viewEndMs >= data.lastMs());
+
+  update();
+}
+
+/**
+ * Zooms in or out around the time under the pointer.
+ */
+void StripChart::wheelEvent(QWheelEvent* event)
+{
+  const QRect plot = plotRect();
+  const int steps = event->angleDelta().y() / 120;
+
+  if ((steps != 0) && (plot.width() > 0))
+  {
+    const qint64 startMs = m_viewEndMs - m_viewSpanMs;
+    const double fraction = qBound(0.0, (event->position().x() - plot.left()) / plot.width(), 1.0);
+    const qint64 anchorMs = startMs + (qint64)(fraction * m_viewSpanMs);
+    double scale = 1.0;
+
+    for (int step = 0; step < qAbs(steps); step++)
+    {
+      scale *= (steps > 0) ? 0.8 : 1.25;
+    }
+
+    const qint64 spanMs = qMax((qint64)(m_viewSpanMs * scale), s_minSpanMs);
+    setView(anchorMs + (qint64)((1.0 - fraction) * spanMs), spanMs);
+  }
+
+  event->accept();
+}
+
+/**
+ * Begins panning the view.
+ */
+void StripChart::mousePressEvent(QMouseEvent* event)
+{
+  if (event->button() == Qt::LeftButton)
+  {
+    m_dragging = true;
+    m_dragStart = event->pos();
+    m_dragViewEndMs = m_viewEndMs;
+    setCursor(Qt::ClosedHandCursor);
+  }
+}
+
+/**
+ * Pans the view along with the pointer.
+ */
+void StripChart::mouseMoveEvent(QMouseEvent* event)
+{
+  const int width = plotRect().width();
+
+  if (m_dragging && (width > 0))
+  {
+    const qint64 deltaMs = (qint64)(event->pos().x() - m_dragStart.x()) * m_viewSpanMs / width;
+    setView(m_dragViewEndMs - deltaMs, m_viewSpanMs);
+  }
+}
+
+void StripChart::mouseReleaseEvent(QMouseEvent* event)
+{
+  if (event->button() == Qt::LeftButton)
+  {
+    m_dragging = false;
+    unsetCursor();
+  }
+}
+
+/**
+ * Returns to the default view: the newest minute of the live session, or the
+ * whole of the log.
+ */
+void StripChart::mouseDoubleClickEvent(QMouseEvent*)
+{
+  if (m_showLog)
+  {
+    showLog();
+  }
+  else
+  {
+    showLive();
+  }
+}
+
+/**
+ * Draws a lane for each selected reading, stacked from top to bottom, and
+ * the times at either end of the view.
+ */
+void StripChart::paintEvent(QPaintEvent*)
+{
+  QPainter painter(this);
+  const Session& data = session();
+  const QRect plot = plotRect();
+  QVector<StripChartChannel> lanes;
+
+  painter.fillRect(rect(), palette().base());
+
+  for (int channel = 0; channel < (int)StripChartChannel_NumChannels; channel++)
+  {
+    if (m_visible[channel])
+    {
+      lanes.append((StripChartChannel)channel);
+    }
+  }
+
+  if (data.timesMs.isEmpty() || lanes.isEmpty() || (plot.height() < (int)lanes.size()))
+  {
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(rect(), Qt::AlignCenter, m_showLog ? "The log holds no data" : "No data received yet");
+    return;
+  }
+
+  const qint64 startMs = m_viewEndMs - m_viewSpanMs;
+  const int fromIndex = data.indexAt(startMs);
+  const int toIndex = data.indexAt(m_viewEndMs + 1);
+  const int laneHeight = plot.height() / lanes.size();
+
+  for (int lane = 0; lane < lanes.size(); lane++)
+  {
+    const QRect laneRect(plot.left(), plot.top() + (lane * laneHeight), plot.width(), laneHeight);
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawRect(laneRect.adjusted(0, 0, -1, -1));
+    drawLane(painter, laneRect.adjusted(1, 2, -1, -3), lanes.at(lane), fromIndex, toIndex);
+  }
+
+  // times are shown relative to the start of the session
+  const QRect axis(plot.left(), plot.bottom() + 2, plot.width(), s_timeAxisHeight - 2);
+  painter.setPen(palette().color(QPalette::Text));
+  painter.drawText(axis, Qt::AlignLeft | Qt::AlignVCenter, elapsedText(qMax(startMs - data.firstMs(), (qint64)0)));
+  painter.drawText(axis, Qt::AlignRight | Qt::AlignVCenter, elapsedText(m_viewEndMs - data.firstMs()));
+  painter.drawText(axis, Qt::AlignHCenter | Qt::AlignVCenter,
+                   QString("%1 s%2").arg(m_viewSpanMs / 1000.0, 0, 'f', (m_viewSpanMs < 10000) ? 2 : 0)
+                                    .arg(m_following ? " (following)" : ""));
+}
+
+/**
+ * Draws one reading, scaled to fill the lane between the lowest and highest
+ * values in view. When there are more frames in view than there are pixel
+ * columns, each column is drawn as a vertical line spanning the lowest and
+ * highest values that fall in it (and the value before it, so that the
+ * columns join up); otherwise the frames are joined by straight lines.
+ * @param lane Area to plot in
+ * @param channel Reading to plot
+ * @param fromIndex Position of the first frame in view
+ * @param toIndex Position just past the last frame in view
+ */
+void StripChart::drawLane(QPainter& painter, const QRect& lane, StripChartChannel channel,
+                          int fromIndex, int toIndex) const
+{
+  const Session& data = session();
+  const DecimationPyramid& values = data.channels[channel];
+  const qint64 startMs = m_viewEndMs - m_viewSpanMs;
+
+  // include the frames on either side of the view so that the line reaches the edges
+  const int from = qMax(fromIndex - 1, 0);
+  const int to = qMin(toIndex + 1, values.size());
+  float low = 0.0f;
+  float high = 0.0f;
+
+  if ((from >= to) || (lane.width() <= 0))
+  {
+    return;
+  }
+
+  low = high = values.at(from);
+  values.range(from, to, low, high);
+  if ((high - low) < 1e-6f)
+  {
+    low -= 0.5f;
+    high += 0.5f;
+  }
+
+  const double yScale = (lane.height() - 1) / (double)(high - low);
+  const double xScale = lane.width() / (double)m_viewSpanMs;
+  auto yFor = [&](float value) { return lane.bottom() - ((value - low) * yScale); };
+
+  painter.save();
+  painter.setClipRect(lane);
+  painter.setPen(QPen(channelColor(channel), 0));
+
+  if ((to - from) <= lane.width())
+  {
+    QPolygonF line;
+    line.reserve(to - from);
+    for (int idx = from; idx < to; idx++)
+    {
+      line.append(QPointF(lane.left() + ((data.timesMs.at(idx) - startMs) * xScale), yFor(values.at(idx))));
+    }
+    painter.drawPolyline(line);
+  }
+  else
+  {
+    QVector<QLineF> columns;
+    int columnStart = data.indexAt(startMs);
+
+    columns.reserve(lane.width());
+    for (int x = 0; x < lane.width(); x++)
+    {
+      const int columnEnd = data.indexAt(startMs + ((x + 1) * m_viewSpanMs / lane.width()));
+
+      if (columnEnd > columnStart)
+      {
+        float columnLow = values.at(columnStart);
+        float columnHigh = columnLow;
+        values.range(qMax(columnStart - 1, 0), columnEnd, columnLow, columnHigh);
+
+        // a column with a single value still needs to be a pixel tall
+        const double top = yFor(columnHigh);
+        const double bottom = qMax(yFor(columnLow), top + 1.0);
+        columns.append(QLineF(lane.left() + x + 0.5, top, lane.left() + x + 0.5, bottom));
+      }
+      columnStart = qMax(columnStart, columnEnd);
+    }
+    painter.drawLines(columns);
+  }
+
+  painter.restore();
+
+  // name and latest value in view to the left, and the scale at either end
+  const QRect label(0, lane.top(), s_labelWidth - 6, lane.height());
+  const float latest = values.at(qMax(toIndex - 1, 0));
+
+  painter.setPen(channelColor(channel));
+  painter.drawText(label, Qt::AlignRight | Qt::AlignVCenter,
+                   QString("%1\n%2").arg(channelName(channel)).arg(latest, 0, 'g', 5));
+  painter.setPen(palette().color(QPalette::Text));
+  painter.drawText(label, Qt::AlignRight | Qt::AlignTop, QString::number(high, 'g', 5));
+  painter.drawText(label, Qt::AlignRight | Qt::AlignBottom, QString::number(low, 'g', 5));
+}
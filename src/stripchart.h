@@ -0,0 +1,125 @@
+#pragma once
+#include <QWidget>
+#include <QColor>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include "decimationpyramid.h"
+#include "telemetryframe.h"
+
+class LogReplaySource;
+
+enum StripChartChannel
+{
+  StripChartChannel_RoadSpeed,
+  StripChartChannel_EngineRPM,
+  StripChartChannel_TargetIdleSpeed,
+  StripChartChannel_CoolantTemp,
+  StripChartChannel_FuelTemp,
+  StripChartChannel_Throttle,
+  StripChartChannel_MAF,
+  StripChartChannel_IdleBypassPos,
+  StripChartChannel_MainVoltage,
+  StripChartChannel_InjectorPulseWidth,
+  StripChartChannel_LambdaTrimOdd,
+  StripChartChannel_LambdaTrimEven,
+  StripChartChannel_NumChannels
+};
+
+/**
+ * Plots readings against time, with each selected reading in its own lane
+ * and scaled to the range it covers in view. The chart holds two sessions:
+ * the frames received live, and a log loaded from disk, and shows one of
+ * them at a time. While showing the live session the chart follows the
+ * newest frame until it is panned or zoomed.
+ *
+ * Every reading is stored in a DecimationPyramid, so drawing a lane costs a
+ * few lookups per pixel column no matter how many frames are in view.
+ */
+class StripChart : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit StripChart(QWidget* parent = nullptr);
+
+  static QString channelName(StripChartChannel channel);
+  static QColor channelColor(StripChartChannel channel);
+
+  void appendFrame(const TelemetryFrame& frame);
+  void clearLive();
+  bool loadLog(LogReplaySource& source);
+  void showLive();
+  void showLog();
+  bool isShowingLog() const
+  {
+    return m_showLog;
+  }
+
+  void setChannelVisible(StripChartChannel channel, bool visible);
+  bool isChannelVisible(StripChartChannel channel) const;
+
+  QSize sizeHint() const;
+
+protected:
+  void paintEvent(QPaintEvent* event);
+  void wheelEvent(QWheelEvent* event);
+  void mousePressEvent(QMouseEvent* event);
+  void mouseMoveEvent(QMouseEvent* event);
+  void mouseReleaseEvent(QMouseEvent* event);
+  void mouseDoubleClickEvent(QMouseEvent* event);
+
+private:
+  /**
+   * The frames of one session: a shared list of timestamps, and a pyramid
+   * of values for each reading.
+   */
+  struct Session
+  {
+    QVector<qint64> timesMs;
+    DecimationPyramid channels[StripChartChannel_NumChannels];
+
+    void clear();
+    void reserve(int count);
+    void append(const TelemetryFrame& frame);
+    void removeBefore(qint64 timeMs);
+    int indexAt(qint64 timeMs) const;
+    qint64 firstMs() const
+    {
+      return timesMs.isEmpty() ? 0 : timesMs.first();
+    }
+    qint64 lastMs() const
+    {
+      return timesMs.isEmpty() ? 0 : timesMs.last();
+    }
+  };
+
+  static constexpr qint64 s_defaultSpanMs = 60000;
+  static constexpr qint64 s_minSpanMs = 250;
+  static constexpr qint64 s_liveHistoryMs = 2 * 60 * 60 * 1000;
+  static constexpr qint64 s_liveTrimSlackMs = 15 * 60 * 1000;
+  static const int s_labelWidth = 150;
+  static const int s_timeAxisHeight = 18;
+
+  Session m_live;
+  Session m_log;
+  bool m_showLog = false;
+  bool m_following = true;
+  qint64 m_viewEndMs = 0;
+  qint64 m_viewSpanMs = s_defaultSpanMs;
+  bool m_visible[StripChartChannel_NumChannels];
+
+  bool m_dragging = false;
+  QPoint m_dragStart;
+  qint64 m_dragViewEndMs = 0;
+
+  const Session& session() const
+  {
+    return m_showLog ? m_log : m_live;
+  }
+
+  QRect plotRect() const;
+  void setView(qint64 endMs, qint64 spanMs);
+  void drawLane(QPainter& painter, const QRect& lane, StripChartChannel channel,
+                int fromIndex, int toIndex) const;
+};
@@ -0,0 +1,126 @@
+#include <QApplication>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QVBoxLayout>
+#include "stripchartdialog.h"
+#include "logreplaysource.h"
+
+namespace
+{
+const char* const s_liveText =
+  "Showing live data. Scroll to zoom, drag to pan, and double-click to follow the newest data.";
+}
+
+/**
+ * Constructor. The chart starts out showing the live session.
+ */
+StripChartDialog::StripChartDialog(QString title, QWidget* parent) :
+  QDialog(parent)
+{
+  this->setWindowTitle(title);
+  setupWidgets();
+}
+
+/**
+ * Creates the chart, a checkbox for each reading, and the buttons, and
+ * places them on the form.
+ */
+void StripChartDialog::setupWidgets()
+{
+  QVBoxLayout* channelLayout = new QVBoxLayout();
+
+  m_grid = new QGridLayout(this);
+
+  for (int channel = 0; channel < (int)StripChartChannel_NumChannels; channel++)
+  {
+    const StripChartChannel id = (StripChartChannel)channel;
+    QCheckBox* checkbox = new QCheckBox(StripChart::channelName(id), this);
+
+    checkbox->setStyleSheet(QString("QCheckBox { color: %1; }").arg(StripChart::channelColor(id).name()));
+    channelLayout->addWidget(checkbox);
+    m_channelCheckboxes[channel] = checkbox;
+  }
+  channelLayout->addStretch();
+  m_grid->addLayout(channelLayout, 0, 0);
+
+  m_chart = new StripChart(this);
+  m_grid->addWidget(m_chart, 0, 1, 1, 4);
+  m_grid->setColumnStretch(1, 1);
+
+  for (int channel = 0; channel < (int)StripChartChannel_NumChannels; channel++)
+  {
+    const StripChartChannel id = (StripChartChannel)channel;
+
+    m_channelCheckboxes[channel]->setChecked(m_chart->isChannelVisible(id));
+    connect(m_channelCheckboxes[channel], &QCheckBox::toggled, this,
+            [this, id](bool checked) { m_chart->setChannelVisible(id, checked); });
+  }
+
+  m_sourceLabel = new QLabel(s_liveText, this);
+  m_grid->addWidget(m_sourceLabel, 1, 0, 1, 2);
+
+  m_openLogButton = new QPushButton("Open log...", this);
+  m_grid->addWidget(m_openLogButton, 1, 2);
+  connect(m_openLogButton, &QPushButton::clicked, this, &StripChartDialog::onOpenLogClicked);
+
+  m_liveButton = new QPushButton("Live", this);
+  m_grid->addWidget(m_liveButton, 1, 3);
+  connect(m_liveButton, &QPushButton::clicked, this, &StripChartDialog::onLiveClicked);
+
+  m_clearButton = new QPushButton("Clear", this);
+  m_grid->addWidget(m_clearButton, 2, 2);
+  connect(m_clearButton, &QPushButton::clicked, this, &StripChartDialog::onClearClicked);
+
+  m_closeButton = new QPushButton("Close", this);
+  m_grid->addWidget(m_closeButton, 2, 3);
+  connect(m_closeButton, &QPushButton::clicked, this, &QDialog::accept);
+}
+
+/**
+ * Asks for a log file and loads the whole of it into the chart.
+ */
+void StripChartDialog::onOpenLogClicked()
+{
+  const QString path = QFileDialog::getOpenFileName(this, "Open log", "logs",
+                                                    "Logs (*.txt *.rglog *.manifest);;All files (*)");
+  LogReplaySource source;
+
+  if (path.isEmpty())
+  {
+    return;
+  }
+
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  const bool opened = source.open(path);
+  const bool loaded = opened && m_chart->loadLog(source);
+  QApplication::restoreOverrideCursor();
+
+  if (loaded)
+  {
+    m_sourceLabel->setText(QString("Showing %1. Double-click to show the whole log.").arg(QFileInfo(path).fileName()));
+  }
+  else
+  {
+    QMessageBox::warning(this, "Error", QString("Unable to read the log:\n%1")
+                         .arg(opened ? QString("The log holds no data") : source.errorString()),
+                         QMessageBox::Ok);
+  }
+}
+
+/**
+ * Switches back to the live session.
+ */
+void StripChartDialog::onLiveClicked()
+{
+  m_chart->showLive();
+  m_sourceLabel->setText(s_liveText);
+}
+
+/**
+ * Discards the frames received so far in the live session.
+ */
+void StripChartDialog::onClearClicked()
+{
+  m_chart->clearLive();
+}
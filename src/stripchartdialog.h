@@ -0,0 +1,43 @@
+#pragma once
+#include <QDialog>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLabel>
+#include <QString>
+#include "stripchart.h"
+
+/**
+ * A dialog that holds the strip chart, along with the choice of readings to
+ * plot and the controls for switching between the live session and a log
+ * loaded from disk.
+ */
+class StripChartDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  StripChartDialog(QString title, QWidget* parent = nullptr);
+
+  void appendFrame(const TelemetryFrame& frame)
+  {
+    m_chart->appendFrame(frame);
+  }
+
+private slots:
+  void onOpenLogClicked();
+  void onLiveClicked();
+  void onClearClicked();
+
+private:
+  QGridLayout* m_grid;
+  StripChart* m_chart;
+  QCheckBox* m_channelCheckboxes[StripChartChannel_NumChannels];
+  QLabel* m_sourceLabel;
+  QPushButton* m_openLogButton;
+  QPushButton* m_liveButton;
+  QPushButton* m_clearButton;
+  QPushButton* m_closeButton;
+
+  void setupWidgets();
+};
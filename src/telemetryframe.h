@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <QtGlobal>
+#include "comm14cux.h"
+
+/**
+ * Snapshot of every periodic reading taken from the ECU, published by the
+ * interface thread once per completed poll. Speeds and temperatures are
+ * already converted to the units selected when the frame was captured.
+ */
+struct TelemetryFrame
+{
+  qint64 timestampMs = 0;          // wall-clock time (msecs since epoch)
+  qint64 monotonicMs = 0;          // time on the scheduler's monotonic clock
+  unsigned int roadSpeed = 0;
+  int engineSpeedRPM = 0;
+  int targetIdleSpeed = 0;
+  bool idleMode = false;
+  int coolantTemp = 0;
+  int fuelTemp = 0;
+  float throttlePos = 0.0f;
+  float mafReading = 0.0f;
+  float idleBypassPos = 0.0f;
+  float mainVoltage = 0.0f;
+  float coTrimVoltage = 0.0f;
+  float injectorPulseWidthMs = 0.0f;
+  int lambdaTrimOdd = 0;
+  int lambdaTrimEven = 0;
+  c14cux_lambda_trim_type lambdaTrimType = C14CUX_LambdaTrimType_ShortTerm;
+  c14cux_gear gear = C14CUX_Gear_NoReading;
+  c14cux_feedback_mode feedbackMode = C14CUX_FeedbackMode_ClosedLoop;
+  int currentFuelMapIndex = 0;
+  int fuelMapRowIndex = 0;
+  int fuelMapRowWeighting = 0;
+  int fuelMapColumnIndex = 0;
+  int fuelMapColumnWeighting = 0;
+  bool fuelPumpRelayOn = false;
+  bool milOn = false;
+};
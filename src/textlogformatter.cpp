@@ -0,0 +1,289 @@
+#include <cmath>
+#include <cstring>
+#include <QDateTime>
+#include "textlogformatter.h"
+
+const char* const TextLogFormatter::header =
+  "#datetime,roadSpeed,engineSpeed,waterTemp,fuelTemp,"
+  "throttlePos,mafPercentage,idleBypassPos,mainVoltage,"
+  "currentFuelMapIndex,currentFuelMapRow,currentFuelMapCol,"
+  "targetIdle,lambdaTrimOdd,lambdaTrimEven,pulseWidthMs\n";
+
+namespace
+{
+// Powers of ten that are exactly representable as doubles, used to scale a
+// reading up to six integer digits with a single rounding step.
+const double s_exactPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+// Thresholds for the decimal exponent of a value, from 1e-4 to 1e5. Outside
+// this range QTextStream switches to exponent notation.
+const double s_decadeFloor[] = { 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5 };
+}
+
+/**
+ * Appends a single frame of data to the buffer as one line of the text log.
+ * @param out Buffer to which the line is appended
+ * @param frame Set of readings to log
+ */
+void TextLogFormatter::appendFrame(QByteArray& out, const TelemetryFrame& frame)
+{
+  double roadSpeed = frame.roadSpeed;
+
+  if (m_settings.speedoAdjust)
+  {
+    roadSpeed *= m_settings.speedoMultiplier;
+    roadSpeed += m_settings.speedoOffset;
+  }
+
+  // Depending on settings, the time will either represent an absolute time or
+  // a delta time (against the time of the first log entry.)
+  if (!m_firstTimestampSet)
+  {
+    m_firstTimestampMs = frame.timestampMs;
+    m_firstTimestampSet = true;
+  }
+
+  if (m_settings.timesMsecsFromZero)
+  {
+    appendInt(out, frame.timestampMs - m_firstTimestampMs);
+  }
+  else
+  {
+    appendDateTime(out, frame.timestampMs);
+  }
+
+  out.append(',');
+  appendNumber(out, roadSpeed);
+  out.append(',');
+  appendInt(out, frame.engineSpeedRPM);
+  out.append(',');
+  appendInt(out, frame.coolantTemp);
+  out.append(',');
+  appendInt(out, frame.fuelTemp);
+  out.append(',');
+  appendNumber(out, frame.throttlePos);
+  out.append(',');
+  appendNumber(out, frame.mafReading);
+  out.append(',');
+  appendNumber(out, frame.idleBypassPos);
+  out.append(',');
+  appendNumber(out, frame.mainVoltage);
+  out.append(',');
+  appendInt(out, frame.currentFuelMapIndex);
+  out.append(',');
+  appendNumber(out, getRowWithWeighting(frame));
+  out.append(',');
+  appendNumber(out, getColWithWeighting(frame));
+  out.append(',');
+  appendInt(out, frame.targetIdleSpeed);
+  out.append(',');
+  appendInt(out, frame.lambdaTrimOdd);
+  out.append(',');
+  appendInt(out, frame.lambdaTrimEven);
+  out.append(',');
+  appendNumber(out, frame.injectorPulseWidthMs);
+  out.append('\n');
+}
+
+/**
+ * Appends a local date and time in the form yyyy-MM-dd_hh:mm:ss.zzz. The text
+ * up to the milliseconds is only rebuilt when the second changes.
+ * @param out Buffer to which the time is appended
+ * @param msecsSinceEpoch Time at which the logged data was captured
+ */
+void TextLogFormatter::appendDateTime(QByteArray& out, qint64 msecsSinceEpoch)
+{
+  qint64 second = msecsSinceEpoch / 1000;
+  int msecs = (int)(msecsSinceEpoch % 1000);
+
+  if (msecs < 0)
+  {
+    second -= 1;
+    msecs += 1000;
+  }
+
+  if (!m_cachedSecondSet || (second != m_cachedSecond))
+  {
+    const QByteArray prefix =
+      QDateTime::fromMSecsSinceEpoch(second * 1000).toString("yyyy-MM-dd_hh:mm:ss.").toLatin1();
+
+    m_datePrefixLength = qMin(prefix.size(), (int)sizeof(m_datePrefix));
+    memcpy(m_datePrefix, prefix.constData(), m_datePrefixLength);
+    m_cachedSecond = second;
+    m_cachedSecondSet = true;
+  }
+
+  const char msecsText[3] = { (char)('0' + msecs / 100), (char)('0' + (msecs / 10) % 10), (char)('0' + msecs % 10) };
+  out.append(m_datePrefix, m_datePrefixLength);
+  out.append(msecsText, 3);
+}
+
+/**
+ * Appends an integer in decimal.
+ */
+void TextLogFormatter::appendInt(QByteArray& out, qint64 value)
+{
+  char buf[24];
+  char* p = buf + sizeof(buf);
+  quint64 magnitude = (value < 0) ? (0 - (quint64)value) : (quint64)value;
+
+  do
+  {
+    *--p = (char)('0' + (magnitude % 10));
+    magnitude /= 10;
+  } while (magnitude > 0);
+
+  if (value < 0)
+  {
+    *--p = '-';
+  }
+
+  out.append(p, (int)(buf + sizeof(buf) - p));
+}
+
+/**
+ * Appends a real number with six significant digits, in the same form that
+ * QTextStream uses by default (like printf's "%g".)
+ */
+void TextLogFormatter::appendNumber(QByteArray& out, double value)
+{
+  char buf[16];
+  const int length = formatSignificant(value, buf);
+
+  if (length > 0)
+  {
+    out.append(buf, length);
+  }
+  else
+  {
+    // exponent notation, infinities, and values too close to a rounding
+    // boundary to be sure of; these never appear in normal logging
+    out.append(QByteArray::number(value, 'g', 6));
+  }
+}
+
+/**
+ * Formats a value between 0.0001 and 999999.5 with six significant digits and
+ * no trailing zeros. The value is scaled to a six-digit integer with a single
+ * multiplication by an exact power of ten, so the only rounding that can
+ * differ from an exact conversion is when the scaled value lands almost
+ * exactly halfway between two integers; those are left to the caller.
+ * @param value Value to format
+ * @param buf Buffer of at least 16 characters
+ * @return Number of characters written, or 0 if the value was not formatted
+ */
+int TextLogFormatter::formatSignificant(double value, char* buf)
+{
+  const double magnitude = std::fabs(value);
+  char* p = buf;
+
+  if (value == 0.0)
+  {
+    if (std::signbit(value))
+    {
+      return 0;
+    }
+    *p = '0';
+    return 1;
+  }
+
+  if (!(magnitude >= s_decadeFloor[0]) || !(magnitude < 1e6))
+  {
+    return 0;
+  }
+
+  // find the decimal exponent of the leading digit
+  int exponent = 5;
+  while ((exponent > -4) && (magnitude < s_decadeFloor[exponent + 4]))
+  {
+    exponent--;
+  }
+
+  const double scaled = magnitude * s_exactPow10[5 - exponent];
+  const double whole = std::floor(scaled);
+  const double fraction = scaled - whole;
+
+  if (std::fabs(fraction - 0.5) < 1e-7)
+  {
+    return 0;
+  }
+
+  quint32 mantissa = (quint32)whole + ((fraction > 0.5) ? 1 : 0);
+
+  if (mantissa >= 1000000)
+  {
+    mantissa /= 10;
+    exponent++;
+  }
+
+  if ((mantissa < 100000) || (mantissa > 999999) || (exponent > 5))
+  {
+    return 0;
+  }
+
+  char digits[6];
+  for (int i = 5; i >= 0; i--)
+  {
+    digits[i] = (char)('0' + (mantissa % 10));
+    mantissa /= 10;
+  }
+
+  // the last digit to print; trailing zeros after the decimal point are dropped
+  int last = 5;
+  while ((last > 0) && (last > exponent) && (digits[last] == '0'))
+  {
+    last--;
+  }
+
+  if (value < 0.0)
+  {
+    *p++ = '-';
+  }
+
+  if (exponent >= 0)
+  {
+    for (int i = 0; i <= last; i++)
+    {
+      if (i == exponent + 1)
+      {
+        *p++ = '.';
+      }
+      *p++ = digits[i];
+    }
+  }
+  else
+  {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > exponent; i--)
+    {
+      *p++ = '0';
+    }
+    for (int i = 0; i <= last; i++)
+    {
+      *p++ = digits[i];
+    }
+  }
+
+  return (int)(p - buf);
+}
+
+/**
+ * Gets a fractional value that describes the current fuel map row index considering
+ * the weighting.
+ */
+float TextLogFormatter::getRowWithWeighting(const TelemetryFrame& frame)
+{
+  return ((float)frame.fuelMapRowIndex +
+          ((float)frame.fuelMapRowWeighting / 16.0));
+}
+
+/**
+ * Gets a fractional value that describes the current fuel map column index considering
+ * the weighting.
+ */
+float TextLogFormatter::getColWithWeighting(const TelemetryFrame& frame)
+{
+  return ((float)frame.fuelMapColumnIndex +
+          ((float)frame.fuelMapColumnWeighting / 16.0));
+}
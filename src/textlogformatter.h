@@ -0,0 +1,41 @@
+#pragma once
+#include <QByteArray>
+#include "logsettings.h"
+#include "telemetryframe.h"
+
+/**
+ * Formats rows of the CSV text log. Rows are appended to a caller-supplied
+ * buffer, and numbers are converted by hand rather than through QString or
+ * QTextStream, so that formatting a row allocates nothing once the buffer has
+ * grown to its working size. The output is byte-for-byte what QTextStream
+ * would produce (integers in decimal, reals with six significant digits.)
+ */
+class TextLogFormatter
+{
+public:
+  static const char* const header;
+
+  void setSettings(const LogSettings& settings)
+  {
+    m_settings = settings;
+  }
+
+  void appendFrame(QByteArray& out, const TelemetryFrame& frame);
+  void appendDateTime(QByteArray& out, qint64 msecsSinceEpoch);
+
+  static void appendInt(QByteArray& out, qint64 value);
+  static void appendNumber(QByteArray& out, double value);
+
+private:
+  LogSettings m_settings;
+  qint64 m_firstTimestampMs = 0;
+  bool m_firstTimestampSet = false;
+  qint64 m_cachedSecond = 0;
+  bool m_cachedSecondSet = false;
+  char m_datePrefix[32];
+  int m_datePrefixLength = 0;
+
+  static int formatSignificant(double value, char* buf);
+  static float getRowWithWeighting(const TelemetryFrame& frame);
+  static float getColWithWeighting(const TelemetryFrame& frame);
+};